@@ -0,0 +1,1180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SaveSystem.h"
+#include "Algo/AnyOf.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Components/SceneComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/LevelActorFlags.h"
+#include "GameFramework/LevelActorRegistry.h"
+#include "GameFramework/LevelSaveObject.h"
+#include "GameFramework/QuantizedActorTransforms.h"
+#include "HAL/IConsoleManager.h"
+#include "Interfaces/LevelSaveInterface.h"
+#include "HAL/FileManager.h"
+#include "Math/RandomStream.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Operations/SaveOperation.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+#include "Serialization/SavePipeline.h"
+#include "Storage/FileSaveStorage.h"
+#include "Storage/JournaledSaveStorage.h"
+#include "Storage/MemorySaveStorage.h"
+#include "Storage/SQLiteSaveStorage.h"
+#include "Subsystems/LevelSaveSubsystem.h"
+#include "Subsystems/LevelStateCacheSubsystem.h"
+#include "Subsystems/MultiSlotSaveSubsystem.h"
+#include "Subsystems/SingleSlotSaveSubsystem.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace SaveSystemBenchmarks
+{
+	static TArray<int32> ParseCounts(const TArray<FString>& Args, const TArray<int32>& Defaults)
+	{
+		TArray<int32> Counts;
+		for(const FString& Arg : Args)
+		{
+			const int32 Count = FCString::Atoi(*Arg);
+			if(Count > 0)
+			{
+				Counts.Add(Count);
+			}
+		}
+		return Counts.IsEmpty() ? Defaults : Counts;
+	}
+
+	static TArray<AActor*> SpawnMovableActors(UWorld* World, int32 Count)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags = RF_Transient;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TArray<AActor*> Actors;
+		Actors.Reserve(Count);
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(SpawnParameters);
+			Actor->SetMobility(EComponentMobility::Movable);
+			Actors.Add(Actor);
+		}
+		return Actors;
+	}
+
+	static TArray<FTransform> MakeRandomTransforms(int32 Count, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<FTransform> Transforms;
+		Transforms.Reserve(Count);
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			Transforms.Emplace(FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f), Random.GetUnitVector() * Random.FRandRange(0.f, 100000.f));
+		}
+		return Transforms;
+	}
+
+	static double MsSince(const double StartTime)
+	{
+		return (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	}
+
+	/**
+	 * Stores everything through a File backend in a scratch directory while in scope. The previous backend is put back
+	 * and the directory removed when leaving scope, however the benchmark exits
+	 */
+	struct FScopedScratchStorage
+	{
+		explicit FScopedScratchStorage(const FString& InDirectory) : Directory(InDirectory), PreviousStorage(FSaveStorage::Get())
+		{
+			FSaveStorage::SetBackend(MakeShared<FFileSaveStorage>(Directory));
+		}
+		~FScopedScratchStorage()
+		{
+			FSaveStorage::SetBackend(PreviousStorage);
+			IFileManager::Get().DeleteDirectory(*Directory, false, true);
+		}
+		const FString Directory;
+		const TSharedRef<ISaveStorageBackend> PreviousStorage;
+	};
+
+	/**
+	 * Times writing, batch writing, looking up, reading and querying Slots on a single storage backend
+	 */
+	static void BenchmarkStorageBackend(ISaveStorageBackend& Storage, int32 Count, const TArray<uint8>& Payload)
+	{
+		TArray<FString> SlotNames;
+		SlotNames.Reserve(Count);
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			SlotNames.Add(FString::Printf(TEXT("Player_%d"), Index));
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		for(const FString& SlotName : SlotNames)
+		{
+			Storage.Write(SlotName, 0, Payload);
+		}
+		const double WriteMs = MsSince(StartTime);
+
+		TArray<TPair<FString, TArray<uint8>>> Batch;
+		Batch.Reserve(Count);
+		for(const FString& SlotName : SlotNames)
+		{
+			Batch.Emplace(SlotName, Payload);
+		}
+		StartTime = FPlatformTime::Seconds();
+		Storage.WriteBatch(Batch, 0);
+		const double BatchMs = MsSince(StartTime);
+
+		StartTime = FPlatformTime::Seconds();
+		int32 Found = 0;
+		for(const FString& SlotName : SlotNames)
+		{
+			Found += Storage.Exists(SlotName, 0) ? 1 : 0;
+		}
+		const double ExistsMs = MsSince(StartTime);
+
+		StartTime = FPlatformTime::Seconds();
+		TArray<uint8> Data;
+		for(const FString& SlotName : SlotNames)
+		{
+			Storage.Read(SlotName, 0, Data);
+		}
+		const double ReadMs = MsSince(StartTime);
+
+		StartTime = FPlatformTime::Seconds();
+		TArray<FString> Modified;
+		const bool bQuerySupported = Storage.GetSlotsModifiedSince(FDateTime::UtcNow() - FTimespan::FromHours(1.0), 0, Modified);
+		const double QueryMs = MsSince(StartTime);
+
+		UE_LOG(LogSaveSystem, Display, TEXT("Slot Store Benchmark [%s]: %d Slots | Write %.2fms | Batch Write %.2fms | Exists %.2fms (%d found) | Read %.2fms | Modified Since %s"),
+			Storage.GetName(), Count, WriteMs, BatchMs, ExistsMs, Found, ReadMs,
+			bQuerySupported ? *FString::Printf(TEXT("%.2fms (%d Slots)"), QueryMs, Modified.Num()) : TEXT("unsupported"));
+
+		for(const FString& SlotName : SlotNames)
+		{
+			Storage.Delete(SlotName, 0);
+		}
+	}
+
+	/**
+	 * Compares storing many Slots as a file each against the other storage backends. Everything is written to a scratch
+	 * directory, so real saves are never touched
+	 */
+	static void BenchmarkSlotStore(const TArray<FString>& Args)
+	{
+		const FString ScratchDirectory = FPaths::ProjectSavedDir() / TEXT("SaveSystemBenchmarks") / TEXT("SlotStore");
+
+		// Random bytes so that no backend gets an unfair advantage from compression or deduplication
+		FRandomStream Random(3);
+		TArray<uint8> Payload;
+		Payload.SetNumUninitialized(4 * 1024);
+		for(uint8& Byte : Payload)
+		{
+			Byte = static_cast<uint8>(Random.RandHelper(256));
+		}
+
+		for(const int32 Count : ParseCounts(Args, {100, 1000, 5000}))
+		{
+			FMemorySaveStorage MemoryStorage;
+			BenchmarkStorageBackend(MemoryStorage, Count, Payload);
+
+			FFileSaveStorage FileStorage(ScratchDirectory / TEXT("Files"));
+			BenchmarkStorageBackend(FileStorage, Count, Payload);
+
+			FJournaledSaveStorage JournaledStorage(ScratchDirectory / TEXT("Journal"));
+			BenchmarkStorageBackend(JournaledStorage, Count, Payload);
+
+#if WITH_SAVESYSTEM_SQLITE
+			{
+				FSQLiteSaveStorage SQLiteStorage(ScratchDirectory / TEXT("Slots.db"));
+				BenchmarkStorageBackend(SQLiteStorage, Count, Payload);
+			}
+#endif
+		}
+
+		IFileManager::Get().DeleteDirectory(*ScratchDirectory, false, true);
+	}
+
+	/**
+	 * Builds a Level Save Object that looks like a real one: Actors placed on a grid, mostly only rotated around the up
+	 * axis, at unit scale, and a mix of interacted states
+	 */
+	static ULevelSaveObject* MakeRepresentativeLevelSave(int32 Count)
+	{
+		FRandomStream Random(4);
+		ULevelSaveObject* LevelSave = NewObject<ULevelSaveObject>();
+		for(int32 Index = 0; Index < Count; Index++)
+		{
+			const FLevelActorId ActorId((static_cast<uint64>(Random.GetUnsignedInt()) << 32) | Random.GetUnsignedInt());
+			LevelSave->InteractedActors.Set(ActorId, Random.FRand() < 0.5f);
+			if(Index % 2 == 0)
+			{
+				const FVector Location(Random.RandRange(-500, 500) * 100.0, Random.RandRange(-500, 500) * 100.0, Random.RandRange(0, 10) * 50.0);
+				LevelSave->MovedActors.Add(ActorId, FTransform(FRotator(0.f, Random.RandRange(0, 7) * 45.f, 0.f), Location));
+			}
+		}
+		return LevelSave;
+	}
+
+	/**
+	 * Compares rewriting a whole Slot on every autosave against journaling the changes, for a representative Level save
+	 * of which only a few Actors change between saves. The payloads come out of the Save Pipeline, compressed for the File
+	 * backend and uncompressed for the journal as the pipeline writes them. The journal is also fed the compressed payloads,
+	 * to show what compression costs it. Reports the time and the bytes that reached the disk
+	 */
+	static void BenchmarkJournal(const TArray<FString>& Args)
+	{
+		const FString ScratchDirectory = FPaths::ProjectSavedDir() / TEXT("SaveSystemBenchmarks") / TEXT("Journal");
+		constexpr int32 Saves = 200;
+		constexpr int32 ChangesPerSave = 8;
+
+		for(const int32 Count : ParseCounts(Args, {1000, 10000}))
+		{
+			ULevelSaveObject* LevelSave = MakeRepresentativeLevelSave(Count);
+
+			// Every backend sees the same sequence of saves
+			FRandomStream Random(5);
+			TArray<TArray<uint8>> CompressedVersions;
+			TArray<TArray<uint8>> RawVersions;
+			CompressedVersions.Reserve(Saves);
+			RawVersions.Reserve(Saves);
+			for(int32 Save = 0; Save < Saves; Save++)
+			{
+				for(int32 Change = 0; Change < ChangesPerSave; Change++)
+				{
+					const int32 Index = Random.RandHelper(LevelSave->InteractedActors.Num());
+					LevelSave->InteractedActors.Set(LevelSave->InteractedActors.GetId(Index), !LevelSave->InteractedActors.Get(Index));
+				}
+
+				FSavePipelineStats Stats;
+				FSavePipeline::EncodePayload(LevelSave, CompressedVersions.AddDefaulted_GetRef(), Stats, ESaveCompressionCodec::Fast);
+				FSavePipeline::EncodePayload(LevelSave, RawVersions.AddDefaulted_GetRef(), Stats, ESaveCompressionCodec::None);
+			}
+
+			double StartTime = FPlatformTime::Seconds();
+			int64 FileBytes = 0;
+			{
+				FFileSaveStorage FileStorage(ScratchDirectory / TEXT("Files"));
+				for(const TArray<uint8>& Version : CompressedVersions)
+				{
+					FileStorage.Write(TEXT("Autosave"), 0, Version);
+					FileBytes += Version.Num();
+				}
+			}
+			const double FileMs = MsSince(StartTime);
+
+			int64 CompressedJournalBytes = 0;
+			{
+				FJournaledSaveStorage CompressedStorage(ScratchDirectory / TEXT("CompressedJournal"));
+				for(const TArray<uint8>& Version : CompressedVersions)
+				{
+					CompressedStorage.Write(TEXT("Autosave"), 0, Version);
+				}
+				CompressedJournalBytes = CompressedStorage.GetBytesWritten();
+			}
+
+			StartTime = FPlatformTime::Seconds();
+			FJournaledSaveStorage JournaledStorage(ScratchDirectory / TEXT("Journal"));
+			for(const TArray<uint8>& Version : RawVersions)
+			{
+				JournaledStorage.Write(TEXT("Autosave"), 0, Version);
+			}
+			const double JournalMs = MsSince(StartTime);
+			const int64 JournalBytes = JournaledStorage.GetBytesWritten();
+
+			// A second backend stands in for the next session, and has to replay the journal on top of the checkpoint
+			TArray<uint8> Recovered;
+			double RecoverMs = 0.0;
+			{
+				FJournaledSaveStorage RecoveryStorage(ScratchDirectory / TEXT("Journal"));
+				StartTime = FPlatformTime::Seconds();
+				RecoveryStorage.Read(TEXT("Autosave"), 0, Recovered);
+				RecoverMs = MsSince(StartTime);
+			}
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Journal Benchmark: %d saves of %d Actors | File %.2fms, %lld bytes | Journal %.2fms, %lld bytes (%lld if compressed) | Recover %.2fms (%s)"),
+				Saves, Count, FileMs, FileBytes, JournalMs, JournalBytes, CompressedJournalBytes, RecoverMs, Recovered == RawVersions.Last() ? TEXT("matches") : TEXT("MISMATCH"));
+		}
+
+		IFileManager::Get().DeleteDirectory(*ScratchDirectory, false, true);
+	}
+
+	/**
+	 * Reports the compression ratio and the encode and decode throughput of every codec on representative Level saves
+	 */
+	static void BenchmarkCompression(const TArray<FString>& Args)
+	{
+		static const ESaveCompressionCodec Codecs[] = { ESaveCompressionCodec::None, ESaveCompressionCodec::Fast, ESaveCompressionCodec::HighRatio };
+		constexpr int32 Iterations = 5;
+
+		for(const int32 Count : ParseCounts(Args, {1000, 10000, 100000}))
+		{
+			TArray<uint8> RawData;
+			UGameplayStatics::SaveGameToMemory(MakeRepresentativeLevelSave(Count), RawData);
+			const double RawMegabytes = RawData.Num() / (1024.0 * 1024.0);
+
+			for(const ESaveCompressionCodec Codec : Codecs)
+			{
+				// Keep the fastest of several runs, which is the least disturbed by everything else going on
+				double EncodeMs = TNumericLimits<double>::Max();
+				double DecodeMs = TNumericLimits<double>::Max();
+				int64 StoredBytes = 0;
+				for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+				{
+					FSavePipelineStats Stats;
+					TArray<uint8> Data;
+					double StartTime = FPlatformTime::Seconds();
+					FSavePipeline::CompressPayload(TArray<uint8>(RawData), Data, Stats, Codec);
+					EncodeMs = FMath::Min(EncodeMs, MsSince(StartTime));
+					StoredBytes = Data.Num();
+
+					StartTime = FPlatformTime::Seconds();
+					FSavePipeline::DecodePayload(Data, Stats);
+					DecodeMs = FMath::Min(DecodeMs, MsSince(StartTime));
+				}
+
+				UE_LOG(LogSaveSystem, Display, TEXT("Compression Benchmark [%s]: %d Actors | %lld -> %lld bytes (%.2fx) | Encode %.1f MB/s | Decode %.1f MB/s"),
+					*StaticEnum<ESaveCompressionCodec>()->GetNameStringByValue(static_cast<int64>(Codec)), Count,
+					static_cast<int64>(RawData.Num()), StoredBytes, static_cast<double>(RawData.Num()) / FMath::Max<int64>(StoredBytes, 1),
+					RawMegabytes / FMath::Max(EncodeMs / 1000.0, UE_DOUBLE_SMALL_NUMBER), RawMegabytes / FMath::Max(DecodeMs / 1000.0, UE_DOUBLE_SMALL_NUMBER));
+			}
+		}
+	}
+
+	/**
+	 * Compares keeping the interacted state of many Actors in a Map against the packed layout of ULevelSaveObject, in
+	 * memory, in iteration time and in saved size
+	 */
+	static void BenchmarkInteractedActors(const TArray<FString>& Args)
+	{
+		for(const int32 Count : ParseCounts(Args, {10000, 50000, 200000}))
+		{
+			FRandomStream Random(7);
+			TMap<FLevelActorId, bool> Map;
+			ULevelSaveObject* LevelSave = NewObject<ULevelSaveObject>();
+			Map.Reserve(Count);
+			LevelSave->InteractedActors.Reserve(Count);
+			for(int32 Index = 0; Index < Count; Index++)
+			{
+				const FLevelActorId ActorId((static_cast<uint64>(Random.GetUnsignedInt()) << 32) | Random.GetUnsignedInt());
+				const bool bInteracted = Random.FRand() < 0.5f;
+				Map.Add(ActorId, bInteracted);
+				LevelSave->InteractedActors.Set(ActorId, bInteracted);
+			}
+
+			// Walk every entry the way a restore does, summing something so the loops can't be optimized away
+			double StartTime = FPlatformTime::Seconds();
+			uint64 MapSum = 0;
+			for(const TPair<FLevelActorId, bool>& Entry : Map)
+			{
+				MapSum += Entry.Value ? Entry.Key.Value : 0;
+			}
+			const double MapMs = MsSince(StartTime);
+
+			StartTime = FPlatformTime::Seconds();
+			uint64 PackedSum = 0;
+			const FLevelActorFlags& Packed = LevelSave->InteractedActors;
+			for(int32 Index = 0; Index < Packed.Num(); Index++)
+			{
+				PackedSum += Packed.Get(Index) ? Packed.GetId(Index).Value : 0;
+			}
+			const double PackedMs = MsSince(StartTime);
+
+			TArray<uint8> SavedData;
+			UGameplayStatics::SaveGameToMemory(LevelSave, SavedData);
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Interacted Actors Benchmark: %d Actors | Map %llu bytes, walk %.2fms | Packed %llu bytes, walk %.2fms, saved %d bytes (%s)"),
+				Count, static_cast<uint64>(Map.GetAllocatedSize()), MapMs, static_cast<uint64>(Packed.GetAllocatedSize()), PackedMs, SavedData.Num(),
+				MapSum == PackedSum ? TEXT("matches") : TEXT("MISMATCH"));
+		}
+	}
+
+	static FAutoConsoleCommand InteractedActorsCommand(
+		TEXT("SaveSystem.Benchmark.InteractedActors"),
+		TEXT("Compares a Map of interacted states against the packed Level save layout. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkInteractedActors));
+
+	/**
+	 * Compares saving moved Actor transforms at full precision against the quantized layout: the saved size, the time to
+	 * load each back, the throughput of the quantized decode on its own, and the largest error it introduces
+	 */
+	static void BenchmarkQuantizedTransforms(const TArray<FString>& Args)
+	{
+		constexpr int32 Iterations = 5;
+
+		for(const int32 Count : ParseCounts(Args, {1000, 10000, 100000}))
+		{
+			FRandomStream Random(8);
+			ULevelSaveObject* LevelSave = NewObject<ULevelSaveObject>();
+			LevelSave->MovedActors.Reserve(Count);
+			for(int32 Index = 0; Index < Count; Index++)
+			{
+				const FLevelActorId ActorId((static_cast<uint64>(Random.GetUnsignedInt()) << 32) | Random.GetUnsignedInt());
+				const FRotator Rotation(Random.FRandRange(-90.f, 90.f), Random.FRandRange(0.f, 360.f), Random.FRandRange(-180.f, 180.f));
+				const FVector Scale = Index % 10 == 0 ? FVector(Random.FRandRange(0.5f, 2.f)) : FVector::OneVector;
+				LevelSave->MovedActors.Add(ActorId, FTransform(Rotation, Random.GetUnitVector() * Random.FRandRange(0.f, 200000.f), Scale));
+			}
+
+			TArray<uint8> FullData;
+			LevelSave->bQuantizeMovedActors = false;
+			UGameplayStatics::SaveGameToMemory(LevelSave, FullData);
+
+			TArray<uint8> QuantizedData;
+			LevelSave->bQuantizeMovedActors = true;
+			UGameplayStatics::SaveGameToMemory(LevelSave, QuantizedData);
+
+			// Keep the fastest of several runs, which is the least disturbed by everything else going on
+			double FullLoadMs = TNumericLimits<double>::Max();
+			double QuantizedLoadMs = TNumericLimits<double>::Max();
+			ULevelSaveObject* Quantized = nullptr;
+			for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				double StartTime = FPlatformTime::Seconds();
+				UGameplayStatics::LoadGameFromMemory(FullData);
+				FullLoadMs = FMath::Min(FullLoadMs, MsSince(StartTime));
+
+				StartTime = FPlatformTime::Seconds();
+				Quantized = Cast<ULevelSaveObject>(UGameplayStatics::LoadGameFromMemory(QuantizedData));
+				QuantizedLoadMs = FMath::Min(QuantizedLoadMs, MsSince(StartTime));
+			}
+
+			FQuantizedActorTransforms Encoded;
+			Encoded.Encode(LevelSave->MovedActors);
+			TArray<FLevelActorId> DecodedIds;
+			TArray<FTransform> DecodedTransforms;
+			double DecodeMs = TNumericLimits<double>::Max();
+			for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				Encoded.Decode(DecodedIds, DecodedTransforms);
+				DecodeMs = FMath::Min(DecodeMs, MsSince(StartTime));
+			}
+
+			double MaxPositionError = 0.0;
+			double MaxAngleError = 0.0;
+			int32 Missing = 0;
+			for(const TPair<FLevelActorId, FTransform>& Entry : LevelSave->MovedActors)
+			{
+				const FTransform* Decoded = Quantized ? Quantized->MovedActors.Find(Entry.Key) : nullptr;
+				if(!Decoded)
+				{
+					Missing++;
+					continue;
+				}
+				MaxPositionError = FMath::Max(MaxPositionError, FVector::Dist(Entry.Value.GetLocation(), Decoded->GetLocation()));
+				MaxAngleError = FMath::Max(MaxAngleError, FMath::RadiansToDegrees(Entry.Value.GetRotation().AngularDistance(Decoded->GetRotation())));
+			}
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Quantized Transforms Benchmark: %d Actors | Full %d bytes, load %.2fms | Quantized %d bytes, load %.2fms, decode %.1f M/s | Max error %.3fcm %.3fdeg%s"),
+				Count, FullData.Num(), FullLoadMs, QuantizedData.Num(), QuantizedLoadMs, Count / FMath::Max(DecodeMs * 1000.0, UE_DOUBLE_SMALL_NUMBER),
+				MaxPositionError, MaxAngleError, Missing > 0 ? *FString::Printf(TEXT(" (%d MISSING)"), Missing) : TEXT(""));
+		}
+	}
+
+	static FAutoConsoleCommand QuantizedTransformsCommand(
+		TEXT("SaveSystem.Benchmark.QuantizedTransforms"),
+		TEXT("Compares saving moved Actor transforms at full precision against the quantized layout. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkQuantizedTransforms));
+
+	/**
+	 * Compares loading a whole Level save as one Slot against loading only the 3x3 cells around a player from a save
+	 * partitioned into cells, which is what ULevelSaveSubsystem does at startup with bPartitionIntoCells. The Actors are
+	 * spread evenly over a 16x16 cell World, and everything is stored in a scratch directory
+	 */
+	static void BenchmarkLevelCells(const TArray<FString>& Args)
+	{
+		constexpr int32 GridSize = 16;
+		constexpr int32 LoadedRadius = 1;
+		const FScopedScratchStorage ScratchStorage(FPaths::ProjectSavedDir() / TEXT("SaveSystemBenchmarks") / TEXT("LevelCells"));
+
+		for(const int32 Count : ParseCounts(Args, {10000, 100000, 500000}))
+		{
+			FRandomStream Random(9);
+			ULevelSaveObject* Whole = NewObject<ULevelSaveObject>();
+			TMap<FIntPoint, ULevelSaveObject*> Cells;
+			for(int32 Index = 0; Index < Count; Index++)
+			{
+				const FLevelActorId ActorId((static_cast<uint64>(Random.GetUnsignedInt()) << 32) | Random.GetUnsignedInt());
+				const FIntPoint Cell(Random.RandHelper(GridSize), Random.RandHelper(GridSize));
+				ULevelSaveObject*& CellSave = Cells.FindOrAdd(Cell);
+				if(!CellSave)
+				{
+					CellSave = NewObject<ULevelSaveObject>();
+				}
+
+				const bool bInteracted = Random.FRand() < 0.5f;
+				Whole->InteractedActors.Set(ActorId, bInteracted);
+				CellSave->InteractedActors.Set(ActorId, bInteracted);
+				if(Index % 4 == 0)
+				{
+					const FTransform Transform(FRotator(0.f, Random.FRandRange(0.f, 360.f), 0.f), FVector(Random.FRand(), Random.FRand(), 0.f) * 25600.0);
+					Whole->MovedActors.Add(ActorId, Transform);
+					CellSave->MovedActors.Add(ActorId, Transform);
+				}
+			}
+
+			FSavePipelineStats Stats;
+			FSavePipeline::SaveSync(Whole, TEXT("Whole"), 0, Stats);
+			for(const TPair<FIntPoint, ULevelSaveObject*>& Cell : Cells)
+			{
+				FSavePipeline::SaveSync(Cell.Value, FString::Printf(TEXT("Cell_%d_%d"), Cell.Key.X, Cell.Key.Y), 0, Stats);
+			}
+
+			double StartTime = FPlatformTime::Seconds();
+			const ULevelSaveObject* LoadedWhole = Cast<ULevelSaveObject>(FSavePipeline::LoadSync(TEXT("Whole"), 0, Stats));
+			const double WholeMs = MsSince(StartTime);
+			const int32 WholeActors = LoadedWhole ? LoadedWhole->InteractedActors.Num() : 0;
+			const uint64 WholeBytes = LoadedWhole ? LoadedWhole->InteractedActors.GetAllocatedSize() + LoadedWhole->MovedActors.GetAllocatedSize() : 0;
+
+			// The player stands in the middle of the World, so every loaded cell has neighbours on all sides
+			StartTime = FPlatformTime::Seconds();
+			int32 CellActors = 0;
+			uint64 CellBytes = 0;
+			for(int32 Y = GridSize / 2 - LoadedRadius; Y <= GridSize / 2 + LoadedRadius; Y++)
+			{
+				for(int32 X = GridSize / 2 - LoadedRadius; X <= GridSize / 2 + LoadedRadius; X++)
+				{
+					if(const ULevelSaveObject* LoadedCell = Cast<ULevelSaveObject>(FSavePipeline::LoadSync(FString::Printf(TEXT("Cell_%d_%d"), X, Y), 0, Stats)))
+					{
+						CellActors += LoadedCell->InteractedActors.Num();
+						CellBytes += LoadedCell->InteractedActors.GetAllocatedSize() + LoadedCell->MovedActors.GetAllocatedSize();
+					}
+				}
+			}
+			const double CellsMs = MsSince(StartTime);
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Level Cells Benchmark: %d Actors | Whole %.2fms, %d Actors, %llu bytes | %d Cells %.2fms, %d Actors, %llu bytes"),
+				Count, WholeMs, WholeActors, WholeBytes, FMath::Square(LoadedRadius * 2 + 1), CellsMs, CellActors, CellBytes);
+
+			FSaveStorage::Get()->Delete(TEXT("Whole"), 0);
+			for(const TPair<FIntPoint, ULevelSaveObject*>& Cell : Cells)
+			{
+				FSaveStorage::Get()->Delete(FString::Printf(TEXT("Cell_%d_%d"), Cell.Key.X, Cell.Key.Y), 0);
+			}
+		}
+	}
+
+	static FAutoConsoleCommand LevelCellsCommand(
+		TEXT("SaveSystem.Benchmark.LevelCells"),
+		TEXT("Compares loading a whole Level save against loading the cells around a player. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLevelCells));
+
+	static FAutoConsoleCommand CompressionCommand(
+		TEXT("SaveSystem.Benchmark.Compression"),
+		TEXT("Reports the ratio and throughput of each save compression codec on representative Level saves. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCompression));
+
+	static FAutoConsoleCommand JournalCommand(
+		TEXT("SaveSystem.Benchmark.Journal"),
+		TEXT("Compares rewriting a Slot on every autosave against journaling its changes. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkJournal));
+
+	static FAutoConsoleCommand SlotStoreCommand(
+		TEXT("SaveSystem.Benchmark.SlotStore"),
+		TEXT("Times the storage backends with many small Slots. Optionally takes a list of Slot counts"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkSlotStore));
+
+	/**
+	 * The timings of one case of the Benchmark Suite, repeated a few times
+	 */
+	struct FSuiteSamples
+	{
+		TArray<double> Ms;
+
+		void Add(double Sample) { Ms.Add(Sample); }
+
+		double Median() const
+		{
+			if(Ms.IsEmpty())
+			{
+				return 0.0;
+			}
+			TArray<double> Sorted = Ms;
+			Sorted.Sort();
+			return Sorted[Sorted.Num() / 2];
+		}
+
+		double Max() const { return Ms.IsEmpty() ? 0.0 : FMath::Max(Ms); }
+	};
+
+	using FSuiteJsonWriter = TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>;
+
+	static void WriteSamples(FSuiteJsonWriter& Writer, const TCHAR* Name, const FSuiteSamples& Samples)
+	{
+		Writer.WriteValue(FString::Printf(TEXT("%sMedianMs"), Name), Samples.Median());
+		Writer.WriteValue(FString::Printf(TEXT("%sMaxMs"), Name), Samples.Max());
+	}
+
+	/**
+	 * @brief Save a Save Game Object through the async pipeline and block until the write is done
+	 */
+	static bool SaveAndWait(USaveGame* SaveGame, const FString& SlotName, ESaveCompressionCodec Codec, FSavePipelineStats& OutStats)
+	{
+		const TSharedRef<FSaveOperation> Operation = MakeShared<FSaveOperation>(SlotName);
+		const bool bStarted = FSavePipeline::SaveAsync(SaveGame, SlotName, 0, FOnSavePipelineFinished::CreateLambda([Operation](bool bSuccess, const FSavePipelineStats& Stats)
+		{
+			Operation->Complete(bSuccess, Stats);
+		}), Codec);
+		if(!bStarted || !Operation->Wait())
+		{
+			return false;
+		}
+		OutStats = Operation->GetStats();
+		return Operation->WasSuccessful();
+	}
+
+	/**
+	 * @brief Load a Slot through the async pipeline and block until the Save Game Object is ready
+	 */
+	static USaveGame* LoadAndWait(const FString& SlotName)
+	{
+		const TSharedRef<FSaveOperation> Operation = MakeShared<FSaveOperation>(SlotName);
+		FSavePipeline::LoadAsync(SlotName, 0, FOnLoadPipelineFinished::CreateLambda([Operation](USaveGame* SaveGame, const FSavePipelineStats& Stats)
+		{
+			Operation->Complete(IsValid(SaveGame), Stats, SaveGame);
+		}));
+		Operation->Wait();
+		return Operation->GetSaveGame();
+	}
+
+	/**
+	 * @brief Block the Game Thread until an operation of a Subsystem has finished
+	 * @return Whether it finished successfully
+	 */
+	static bool WaitForOperation(const TSharedRef<FSaveOperation>& Operation)
+	{
+		return Operation->Wait() && Operation->WasSuccessful();
+	}
+
+	/**
+	 * @brief Keep the Game Thread tasks that finish the work of a Subsystem running until a condition is met
+	 * @return False if the condition still wasn't met after a minute
+	 */
+	static bool WaitUntil(TFunctionRef<bool()> Condition)
+	{
+		constexpr double TimeoutSeconds = 60.0;
+		const double EndTime = FPlatformTime::Seconds() + TimeoutSeconds;
+		while(!Condition())
+		{
+			if(FPlatformTime::Seconds() >= EndTime)
+			{
+				UE_LOG(LogSaveSystem, Error, TEXT("Benchmark Suite gave up waiting after %.0f seconds"), TimeoutSeconds);
+				return false;
+			}
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			FPlatformProcess::SleepNoStats(0.f);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Flip the interacted state of the first Actor in a Level save, so a write of it is never skipped as unchanged
+	 * and a load can tell whether that write made it to disk
+	 * @return The Actor that was changed and its new state
+	 */
+	static TPair<FLevelActorId, bool> ChangeFirstActor(ULevelSaveObject* LevelSave)
+	{
+		const FLevelActorId ActorId = LevelSave->InteractedActors.GetId(0);
+		bool bInteracted = false;
+		LevelSave->InteractedActors.Find(ActorId, bInteracted);
+		LevelSave->InteractedActors.Set(ActorId, !bInteracted);
+		return TPair<FLevelActorId, bool>(ActorId, !bInteracted);
+	}
+
+	/**
+	 * @brief Whether a loaded Level save has the change made by ChangeFirstActor
+	 */
+	static bool HasChange(const ULevelSaveObject* LevelSave, const TPair<FLevelActorId, bool>& Change)
+	{
+		bool bInteracted = !Change.Value;
+		return LevelSave && LevelSave->InteractedActors.Find(Change.Key, bInteracted) && bInteracted == Change.Value;
+	}
+
+	/**
+	 * Single Slot save and load latency across payload sizes, through BeginSaveData and BeginLoadData of a Single Slot
+	 * Save Subsystem, so the save scheduler and the Slot's operation queue are timed along with the pipeline. It is an
+	 * instance of the Game Instance's own class, but not the one the game uses, so the Player Data is left alone. Every
+	 * save changes the Player Data, and only counts if the load after it reads that change back
+	 */
+	static void RunSaveSubsystemCases(FSuiteJsonWriter& Writer, UGameInstance* GameInstance)
+	{
+		const USingleSlotSaveSubsystem* GameSubsystem = GameInstance ? GameInstance->GetSubsystem<USingleSlotSaveSubsystem>() : nullptr;
+		if(!GameSubsystem)
+		{
+			UE_LOG(LogSaveSystem, Warning, TEXT("Benchmark Suite has no Single Slot Save Subsystem, skipping the SaveSubsystem cases"));
+			return;
+		}
+
+		constexpr int32 Iterations = 10;
+		const FString SlotName = TEXT("Benchmark_Player");
+
+		for(const int32 Count : {100, 1000, 10000, 100000})
+		{
+			// The Player Data is written once up front, and loaded into the Subsystem like it would be when the game starts
+			FSavePipelineStats Stats;
+			bool bSuccess = FSavePipeline::SaveSync(MakeRepresentativeLevelSave(Count), SlotName, 0, Stats);
+
+			// Saves are written as soon as they are requested, rather than once Wait cuts their debounce window short
+			const TStrongObjectPtr<USingleSlotSaveSubsystem> Subsystem(NewObject<USingleSlotSaveSubsystem>(GameInstance, GameSubsystem->GetClass()));
+			Subsystem->PlayerSaveSlot = SlotName;
+			Subsystem->SaveDebounceSeconds = 0.f;
+			Subsystem->SetSaveGameClass(ULevelSaveObject::StaticClass(), false);
+			bSuccess = bSuccess && WaitForOperation(Subsystem->BeginLoadData()) && Cast<ULevelSaveObject>(Subsystem->GetRawSaveGameObject());
+
+			FSuiteSamples SaveMs;
+			FSuiteSamples LoadMs;
+			for(int32 Iteration = 0; Iteration < Iterations && bSuccess; Iteration++)
+			{
+				const TPair<FLevelActorId, bool> Change = ChangeFirstActor(Cast<ULevelSaveObject>(Subsystem->GetRawSaveGameObject()));
+
+				double StartTime = FPlatformTime::Seconds();
+				bSuccess = WaitForOperation(Subsystem->BeginSaveData());
+				SaveMs.Add(MsSince(StartTime));
+
+				StartTime = FPlatformTime::Seconds();
+				bSuccess = bSuccess && WaitForOperation(Subsystem->BeginLoadData());
+				LoadMs.Add(MsSince(StartTime));
+				bSuccess = bSuccess && HasChange(Cast<ULevelSaveObject>(Subsystem->GetRawSaveGameObject()), Change);
+			}
+			Stats = Subsystem->GetLastSaveStats();
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Benchmark Suite [SaveSubsystem]: %lld bytes | Save %.2fms | Load %.2fms%s"),
+				Stats.RawBytes, SaveMs.Median(), LoadMs.Median(), bSuccess ? TEXT("") : TEXT(" (FAILED)"));
+
+			Writer.WriteObjectStart();
+			Writer.WriteValue(TEXT("Case"), TEXT("SaveSubsystem"));
+			Writer.WriteValue(TEXT("Count"), Count);
+			Writer.WriteValue(TEXT("Success"), bSuccess);
+			Writer.WriteValue(TEXT("PayloadBytes"), Stats.RawBytes);
+			Writer.WriteValue(TEXT("StoredBytes"), Stats.StoredBytes);
+			WriteSamples(Writer, TEXT("Save"), SaveMs);
+			WriteSamples(Writer, TEXT("Load"), LoadMs);
+			Writer.WriteObjectEnd();
+
+			FSaveStorage::Get()->Delete(SlotName, 0);
+		}
+	}
+
+	/**
+	 * Throughput of saving and loading many Slots at once, through SaveSlotBatch and LoadSlots of a Multi Slot Save
+	 * Subsystem, so every Slot takes its turn in its operation queue and is cached as it loads. It is an instance of the
+	 * Game Instance's own class, but not the one the game uses, so the game's Slots and their manifest are left alone.
+	 * Every save changes each Slot, and a Slot only counts as saved if the load after it reads that change back
+	 */
+	static void RunMultiSlotCases(FSuiteJsonWriter& Writer, UGameInstance* GameInstance)
+	{
+		const UMultiSlotSaveSubsystem* GameSubsystem = GameInstance ? GameInstance->GetSubsystem<UMultiSlotSaveSubsystem>() : nullptr;
+		if(!GameSubsystem)
+		{
+			UE_LOG(LogSaveSystem, Warning, TEXT("Benchmark Suite has no Multi Slot Save Subsystem, skipping the MultiSlot cases"));
+			return;
+		}
+
+		constexpr int32 Iterations = 3;
+		constexpr int32 MaxConcurrency = 8;
+
+		for(const int32 Count : {1, 10, 100, 1000})
+		{
+			// The Slots are written once up front, and loaded into the Subsystem like a save menu would
+			TArray<FString> SlotNames;
+			bool bLoadedUpFront = true;
+			for(int32 Index = 0; Index < Count; Index++)
+			{
+				SlotNames.Add(FString::Printf(TEXT("Benchmark_Slot_%d"), Index));
+				FSavePipelineStats Stats;
+				bLoadedUpFront = FSavePipeline::SaveSync(MakeRepresentativeLevelSave(64), SlotNames.Last(), 0, Stats) && bLoadedUpFront;
+			}
+
+			// No Slot may be evicted between being saved and loaded again
+			const TStrongObjectPtr<UMultiSlotSaveSubsystem> Subsystem(NewObject<UMultiSlotSaveSubsystem>(GameInstance, GameSubsystem->GetClass()));
+			Subsystem->SlotCacheBudgetBytes = TNumericLimits<int64>::Max();
+			const auto HasPendingSlots = [&Subsystem, &SlotNames]()
+			{
+				return Algo::AnyOf(SlotNames, [&Subsystem](const FString& SlotName) { return Subsystem->HasPendingSlotOperations(SlotName); });
+			};
+			bLoadedUpFront = bLoadedUpFront && Subsystem->LoadSlots(SlotNames, MaxConcurrency) && WaitUntil([&HasPendingSlots]() { return !HasPendingSlots(); });
+
+			FSuiteSamples SaveMs;
+			FSuiteSamples LoadMs;
+			int32 SavedSlots = 0;
+			int32 LoadedSlots = 0;
+			for(int32 Iteration = 0; Iteration < Iterations && bLoadedUpFront; Iteration++)
+			{
+				TArray<USaveGame*> SavedObjects;
+				TArray<TPair<FLevelActorId, bool>> Changes;
+				for(const FString& SlotName : SlotNames)
+				{
+					ULevelSaveObject* SlotSave = Cast<ULevelSaveObject>(Subsystem->GetSaveSlot(SlotName));
+					SavedObjects.Add(SlotSave);
+					Changes.Add(SlotSave ? ChangeFirstActor(SlotSave) : TPair<FLevelActorId, bool>());
+				}
+
+				double StartTime = FPlatformTime::Seconds();
+				const bool bSaved = Subsystem->SaveSlotBatch(SlotNames) && WaitUntil([&HasPendingSlots]() { return !HasPendingSlots(); });
+				SaveMs.Add(MsSince(StartTime));
+
+				StartTime = FPlatformTime::Seconds();
+				const bool bLoaded = bSaved && Subsystem->LoadSlots(SlotNames, MaxConcurrency) && WaitUntil([&HasPendingSlots]() { return !HasPendingSlots(); });
+				LoadMs.Add(MsSince(StartTime));
+
+				// A loaded Slot holds a new Save Game Object, and a saved one has the change made before the save
+				SavedSlots = 0;
+				LoadedSlots = 0;
+				for(int32 Index = 0; bLoaded && Index < SlotNames.Num(); Index++)
+				{
+					const ULevelSaveObject* Loaded = Cast<ULevelSaveObject>(Subsystem->GetSaveSlot(SlotNames[Index]));
+					if(!Loaded || Loaded == SavedObjects[Index])
+					{
+						continue;
+					}
+					LoadedSlots++;
+					SavedSlots += SavedObjects[Index] && HasChange(Loaded, Changes[Index]) ? 1 : 0;
+				}
+				if(SavedSlots < Count || LoadedSlots < Count)
+				{
+					break;
+				}
+			}
+			const bool bSuccess = bLoadedUpFront && SavedSlots == Count && LoadedSlots == Count;
+
+			const double SaveSlotsPerSecond = Count / FMath::Max(SaveMs.Median() / 1000.0, UE_DOUBLE_SMALL_NUMBER);
+			const double LoadSlotsPerSecond = Count / FMath::Max(LoadMs.Median() / 1000.0, UE_DOUBLE_SMALL_NUMBER);
+			UE_LOG(LogSaveSystem, Display, TEXT("Benchmark Suite [MultiSlot]: %d Slots | Save %.2fms (%.0f Slots/s, %d saved) | Load %.2fms (%.0f Slots/s, %d loaded)%s"),
+				Count, SaveMs.Median(), SaveSlotsPerSecond, SavedSlots, LoadMs.Median(), LoadSlotsPerSecond, LoadedSlots, bSuccess ? TEXT("") : TEXT(" (FAILED)"));
+
+			Writer.WriteObjectStart();
+			Writer.WriteValue(TEXT("Case"), TEXT("MultiSlot"));
+			Writer.WriteValue(TEXT("Count"), Count);
+			Writer.WriteValue(TEXT("Success"), bSuccess);
+			Writer.WriteValue(TEXT("SavedSlots"), SavedSlots);
+			Writer.WriteValue(TEXT("LoadedSlots"), LoadedSlots);
+			WriteSamples(Writer, TEXT("Save"), SaveMs);
+			WriteSamples(Writer, TEXT("Load"), LoadMs);
+			Writer.WriteValue(TEXT("SaveSlotsPerSecond"), SaveSlotsPerSecond);
+			Writer.WriteValue(TEXT("LoadSlotsPerSecond"), LoadSlotsPerSecond);
+			Writer.WriteObjectEnd();
+
+			for(const FString& SlotName : SlotNames)
+			{
+				FSaveStorage::Get()->Delete(SlotName, 0);
+			}
+		}
+	}
+
+	/**
+	 * Saving, loading and restoring the Level state of many moved Actors, through the Level Save Subsystem of a World
+	 * that is created for each case, so the World the suite runs in and its Level save are left alone. Every save moves
+	 * the Actors somewhere new, and only counts if the restore after it puts all of them there.
+	 * \n \n
+	 * The restore is time sliced, so that it can be timed apart from the load. The load covers reading the base and its
+	 * deltas, indexing the Actors and the first batch of moves, the restore covers the rest of the slices
+	 */
+	static void RunLevelSaveCases(FSuiteJsonWriter& Writer)
+	{
+		constexpr int32 Iterations = 3;
+
+		for(const int32 Count : {100, 1000, 10000, 100000})
+		{
+			UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("SaveSystemBenchmarkLevel"));
+			ULevelSaveSubsystem* Subsystem = World->GetSubsystem<ULevelSaveSubsystem>();
+			if(!Subsystem)
+			{
+				UE_LOG(LogSaveSystem, Warning, TEXT("Benchmark Suite has no Level Save Subsystem, skipping the LevelSave cases"));
+				World->DestroyWorld(false);
+				return;
+			}
+
+			// The World is new and has nothing saved, so loading starts it off with an empty Level state
+			Subsystem->bPartitionIntoCells = false;
+			Subsystem->bCacheLevelState = false;
+			Subsystem->bTimeSlicedRestore = true;
+			const float RestoreBudgetMs = Subsystem->RestoreBudgetMs;
+			Subsystem->LoadData();
+			const TArray<AActor*> Actors = SpawnMovableActors(World, Count);
+
+			FSuiteSamples SaveMs;
+			FSuiteSamples LoadMs;
+			FSuiteSamples RestoreMs;
+			int64 StoredBytes = 0;
+			bool bSuccess = Subsystem->IsLoaded();
+			for(int32 Iteration = 0; Iteration < Iterations && bSuccess; Iteration++)
+			{
+				const TArray<FTransform> Transforms = MakeRandomTransforms(Count, 6 + Iteration);
+				for(int32 Index = 0; Index < Count; Index++)
+				{
+					Subsystem->UpdateMovedActors(Actors[Index], Transforms[Index]);
+					Subsystem->UpdateActors(Actors[Index], (Index + Iteration) % 2 == 0);
+				}
+
+				// Compacting writes the whole base every time, where a save would only write the changes as a delta
+				double StartTime = FPlatformTime::Seconds();
+				Subsystem->CompactSaveData();
+				bSuccess = WaitUntil([Subsystem]() { return !Subsystem->IsSaving(); });
+				SaveMs.Add(MsSince(StartTime));
+
+				TArray<uint8> Stored;
+				FSaveStorage::Get()->Read(World->GetName(), 0, Stored);
+				StoredBytes = Stored.Num();
+
+				// Move everything away first, so the restore never finds an Actor already in place
+				for(AActor* Actor : Actors)
+				{
+					Actor->SetActorLocation(FVector::ZeroVector);
+				}
+
+				// Without a budget the load only applies the first batch of moves, and leaves the rest to Tick
+				Subsystem->RestoreBudgetMs = 0.f;
+				StartTime = FPlatformTime::Seconds();
+				Subsystem->LoadData();
+				bSuccess = bSuccess && WaitUntil([Subsystem]() { return Subsystem->IsLoaded(); });
+				LoadMs.Add(MsSince(StartTime));
+
+				Subsystem->RestoreBudgetMs = RestoreBudgetMs;
+				StartTime = FPlatformTime::Seconds();
+				while(Subsystem->IsRestoring())
+				{
+					Subsystem->Tick(0.f);
+				}
+				RestoreMs.Add(MsSince(StartTime));
+
+				int32 RestoredActors = 0;
+				for(int32 Index = 0; Index < Count; Index++)
+				{
+					RestoredActors += Actors[Index]->GetActorTransform().Equals(Transforms[Index], 0.01) ? 1 : 0;
+				}
+				bSuccess = bSuccess && RestoredActors == Count;
+			}
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Benchmark Suite [LevelSave]: %d Actors | %lld bytes | Save %.2fms | Load %.2fms | Restore %.2fms%s"),
+				Count, StoredBytes, SaveMs.Median(), LoadMs.Median(), RestoreMs.Median(), bSuccess ? TEXT("") : TEXT(" (FAILED)"));
+
+			Writer.WriteObjectStart();
+			Writer.WriteValue(TEXT("Case"), TEXT("LevelSave"));
+			Writer.WriteValue(TEXT("Count"), Count);
+			Writer.WriteValue(TEXT("Success"), bSuccess);
+			Writer.WriteValue(TEXT("StoredBytes"), StoredBytes);
+			WriteSamples(Writer, TEXT("Save"), SaveMs);
+			WriteSamples(Writer, TEXT("Load"), LoadMs);
+			WriteSamples(Writer, TEXT("Restore"), RestoreMs);
+			Writer.WriteObjectEnd();
+
+			FSaveStorage::Get()->Delete(World->GetName(), 0);
+			World->DestroyWorld(false);
+		}
+	}
+
+	/**
+	 * Runs every case of the Benchmark Suite and writes the results to a JSON file, so runs can be compared against a
+	 * baseline. Everything is stored through a File backend in a scratch directory, so real saves are never touched.
+	 * Version 2 times the Subsystems themselves, so its results can't be compared against version 1
+	 */
+	static void RunBenchmarkSuite(const TArray<FString>& Args, UWorld* World)
+	{
+		const FString OutputPath = Args.Num() > 0 ? Args[0]
+			: FPaths::ProjectSavedDir() / TEXT("SaveSystemBenchmarks") / FString::Printf(TEXT("Suite-%s.json"), *FDateTime::UtcNow().ToString());
+		const FScopedScratchStorage ScratchStorage(FPaths::ProjectSavedDir() / TEXT("SaveSystemBenchmarks") / TEXT("Suite"));
+
+		FString Json;
+		const TSharedRef<FSuiteJsonWriter> Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("Version"), 2);
+		Writer->WriteValue(TEXT("Timestamp"), FDateTime::UtcNow().ToIso8601());
+		Writer->WriteValue(TEXT("Platform"), UGameplayStatics::GetPlatformName());
+		Writer->WriteValue(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+		Writer->WriteValue(TEXT("BuildVersion"), FApp::GetBuildVersion());
+		Writer->WriteValue(TEXT("Cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+		Writer->WriteArrayStart(TEXT("Results"));
+
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		RunSaveSubsystemCases(*Writer, GameInstance);
+		RunMultiSlotCases(*Writer, GameInstance);
+		RunLevelSaveCases(*Writer);
+
+		Writer->WriteArrayEnd();
+		Writer->WriteObjectEnd();
+		Writer->Close();
+
+		if(FFileHelper::SaveStringToFile(Json, *OutputPath))
+		{
+			UE_LOG(LogSaveSystem, Display, TEXT("Benchmark Suite results written to %s"), *FPaths::ConvertRelativePathToFull(OutputPath));
+		}
+		else
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Benchmark Suite could not write its results to %s"), *OutputPath);
+		}
+	}
+
+	/**
+	 * Compares travelling back to a Level that is loaded from its Slot against one that is held by the Level State Cache.
+	 * The Slot is stored in a scratch directory, and the cache entry is dropped again afterwards
+	 */
+	static void BenchmarkLevelStateCache(const TArray<FString>& Args, UWorld* World)
+	{
+		ULevelStateCacheSubsystem* Cache = ULevelStateCacheSubsystem::Get(World);
+		if(!Cache)
+		{
+			UE_LOG(LogSaveSystem, Warning, TEXT("Level State Cache Benchmark needs a World with a Game Instance"));
+			return;
+		}
+
+		constexpr int32 Iterations = 5;
+		const FString SlotName = TEXT("Benchmark_LevelStateCache");
+		const FScopedScratchStorage ScratchStorage(FPaths::ProjectSavedDir() / TEXT("SaveSystemBenchmarks") / TEXT("LevelStateCache"));
+
+		for(const int32 Count : ParseCounts(Args, {1000, 10000, 100000}))
+		{
+			FRandomStream Random(10);
+			const TArray<FTransform> Transforms = MakeRandomTransforms(Count, 10);
+			ULevelSaveObject* LevelSave = NewObject<ULevelSaveObject>();
+			for(int32 Index = 0; Index < Count; Index++)
+			{
+				const FLevelActorId ActorId((static_cast<uint64>(Random.GetUnsignedInt()) << 32) | Random.GetUnsignedInt());
+				LevelSave->InteractedActors.Set(ActorId, Index % 2 == 0);
+				LevelSave->MovedActors.Add(ActorId, Transforms[Index]);
+			}
+
+			FSavePipelineStats Stats;
+			SaveAndWait(LevelSave, SlotName, ESaveCompressionCodec::HighRatio, Stats);
+
+			// Keep the fastest of several runs, which is the least disturbed by everything else going on
+			double DiskMs = TNumericLimits<double>::Max();
+			double CacheMs = TNumericLimits<double>::Max();
+			bool bMatches = true;
+			for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				double StartTime = FPlatformTime::Seconds();
+				const ULevelSaveObject* Loaded = Cast<ULevelSaveObject>(LoadAndWait(SlotName));
+				DiskMs = FMath::Min(DiskMs, MsSince(StartTime));
+				bMatches = bMatches && Loaded && Loaded->InteractedActors.Num() == Count;
+
+				// Leaving the Level checks its state in, coming back checks it out again
+				Cache->CheckIn(SlotName, LevelSave, true, 0, false, false, ESaveCompressionCodec::HighRatio);
+				StartTime = FPlatformTime::Seconds();
+				FLevelStateCacheEntry Cached;
+				const bool bHit = Cache->CheckOut(SlotName, nullptr, Cached);
+				CacheMs = FMath::Min(CacheMs, MsSince(StartTime));
+				bMatches = bMatches && bHit && Cached.State == LevelSave;
+			}
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Level State Cache Benchmark: %d Actors | Disk %.3fms, %lld bytes | Cache %.3fms (%s)"),
+				Count, DiskMs, Stats.StoredBytes, CacheMs, bMatches ? TEXT("matches") : TEXT("MISMATCH"));
+		}
+
+		Cache->ClearCache();
+	}
+
+	/**
+	 * Compares the per load Actor lookups the Level Save Subsystem used to do against the live Actor registry. Both sides
+	 * walk the World to index the same Actors and then resolve every saved entry, so the registry pays for registering
+	 * too. The map checks the interface for every saved entry, the registry checks it once as each Actor registers.
+	 * Resolving alone is reported separately, as that is all a load pays once the registry is kept up to date
+	 */
+	static void BenchmarkActorRegistry(const TArray<FString>& Args, UWorld* World)
+	{
+		constexpr int32 Iterations = 5;
+
+		const auto IsMovable = [](const AActor* Actor)
+		{
+			return IsValid(Actor) && Actor->GetRootComponent() && Actor->GetRootComponent()->Mobility == EComponentMobility::Movable;
+		};
+
+		for(const int32 Count : ParseCounts(Args, {1000, 10000, 100000}))
+		{
+			TArray<AActor*> Actors = SpawnMovableActors(World, Count);
+			FLevelActorFlags InteractedActors;
+			for(int32 Index = 0; Index < Count; Index++)
+			{
+				InteractedActors.Set(FLevelActorId::FromActor(Actors[Index]), Index % 2 == 0);
+			}
+
+			// Keep the fastest of several runs, which is the least disturbed by everything else going on
+			FLevelActorRegistry ActorRegistry;
+			double MapMs = TNumericLimits<double>::Max();
+			double RegistryMs = TNumericLimits<double>::Max();
+			double ResolveMs = TNumericLimits<double>::Max();
+			int32 MapResolved = 0;
+			int32 RegistryResolved = 0;
+			for(int32 Iteration = 0; Iteration < Iterations; Iteration++)
+			{
+				double StartTime = FPlatformTime::Seconds();
+				TMap<FLevelActorId, TWeakObjectPtr<AActor>> ActorIndex;
+				for(TActorIterator<AActor> It(World); It; ++It)
+				{
+					if(IsMovable(*It))
+					{
+						ActorIndex.Add(FLevelActorId::FromActor(*It), *It);
+					}
+				}
+				MapResolved = 0;
+				for(int32 Index = 0; Index < InteractedActors.Num(); Index++)
+				{
+					const TWeakObjectPtr<AActor>* Actor = ActorIndex.Find(InteractedActors.GetId(Index));
+					if(Actor && Actor->IsValid() && !(*Actor)->Implements<ULevelSaveInterface>())
+					{
+						MapResolved++;
+					}
+				}
+				MapMs = FMath::Min(MapMs, MsSince(StartTime));
+
+				StartTime = FPlatformTime::Seconds();
+				ActorRegistry.Reset();
+				for(TActorIterator<AActor> It(World); It; ++It)
+				{
+					if(IsMovable(*It))
+					{
+						ActorRegistry.Register(*It);
+					}
+				}
+				const double ResolveStartTime = FPlatformTime::Seconds();
+				RegistryResolved = 0;
+				for(int32 Index = 0; Index < InteractedActors.Num(); Index++)
+				{
+					const FRegisteredLevelActor* Registered = ActorRegistry.Find(InteractedActors.GetId(Index));
+					if(Registered && Registered->Actor.IsValid() && !Registered->bImplementsInterface)
+					{
+						RegistryResolved++;
+					}
+				}
+				RegistryMs = FMath::Min(RegistryMs, MsSince(StartTime));
+				ResolveMs = FMath::Min(ResolveMs, MsSince(ResolveStartTime));
+			}
+
+			UE_LOG(LogSaveSystem, Display, TEXT("Actor Registry Benchmark: %d Actors | Map index and resolve %.3fms | Registry register and resolve %.3fms (resolve alone %.3fms, %llu bytes) (%s)"),
+				Count, MapMs, RegistryMs, ResolveMs, static_cast<uint64>(ActorRegistry.GetAllocatedSize()),
+				MapResolved == Count && RegistryResolved == Count ? TEXT("matches") : TEXT("MISMATCH"));
+
+			for(AActor* Actor : Actors)
+			{
+				Actor->Destroy();
+			}
+		}
+	}
+
+	static FAutoConsoleCommandWithWorldAndArgs ActorRegistryCommand(
+		TEXT("SaveSystem.Benchmark.ActorRegistry"),
+		TEXT("Compares rebuilding an Actor index on load against resolving saved entries through the live Actor registry. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkActorRegistry));
+
+	static FAutoConsoleCommandWithWorldAndArgs LevelStateCacheCommand(
+		TEXT("SaveSystem.Benchmark.LevelStateCache"),
+		TEXT("Compares loading a Level from its Slot against restoring it from the Level State Cache. Optionally takes a list of Actor counts"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkLevelStateCache));
+
+	static FAutoConsoleCommandWithWorldAndArgs SuiteCommand(
+		TEXT("SaveSystem.Benchmark.Suite"),
+		TEXT("Runs the save, multi Slot and Level save benchmarks and writes the results as JSON to Saved/SaveSystemBenchmarks, or to the path given. ")
+		TEXT("Runs headless with -game -nullrhi -unattended -ExecCmds=\"SaveSystem.Benchmark.Suite, Quit\""),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBenchmarkSuite));
+}
+
+#endif
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameFramework/LevelActorFlags.h"
+
+int32 FLevelActorFlags::Set(const FLevelActorId& ActorId, bool bFlag)
+{
+	int32 Index = FindIndex(ActorId);
+	if(Index == INDEX_NONE)
+	{
+		Index = ActorIds.Add(ActorId.Value);
+		if((Index >> 5) >= Bits.Num())
+		{
+			Bits.Add(0);
+		}
+
+		if((Index + 1) * 2 > LookupSlots.Num())
+		{
+			RebuildLookup(Index + 1);
+		}
+		else
+		{
+			const uint32 Mask = LookupSlots.Num() - 1;
+			uint32 Slot = static_cast<uint32>(ActorId.Value) & Mask;
+			while(LookupSlots[Slot] != INDEX_NONE)
+			{
+				Slot = (Slot + 1) & Mask;
+			}
+			LookupSlots[Slot] = Index;
+			LookupEntries++;
+		}
+	}
+
+	const uint32 Mask = 1u << (Index & 31);
+	if(bFlag)
+	{
+		Bits[Index >> 5] |= Mask;
+	}
+	else
+	{
+		Bits[Index >> 5] &= ~Mask;
+	}
+	return Index;
+}
+
+bool FLevelActorFlags::Find(const FLevelActorId& ActorId, bool& bOutFlag) const
+{
+	const int32 Index = FindIndex(ActorId);
+	if(Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	bOutFlag = Get(Index);
+	return true;
+}
+
+int32 FLevelActorFlags::CountSet() const
+{
+	int32 Count = 0;
+	for(const uint32 Word : Bits)
+	{
+		Count += FMath::CountBits(Word);
+	}
+	return Count;
+}
+
+void FLevelActorFlags::Append(const FLevelActorFlags& Other)
+{
+	Reserve(Num() + Other.Num());
+	for(int32 Index = 0; Index < Other.Num(); Index++)
+	{
+		Set(Other.GetId(Index), Other.Get(Index));
+	}
+}
+
+void FLevelActorFlags::Reserve(int32 Number)
+{
+	ActorIds.Reserve(Number);
+	Bits.Reserve((Number + 31) >> 5);
+	if(Number * 2 > LookupSlots.Num())
+	{
+		RebuildLookup(Number);
+	}
+}
+
+void FLevelActorFlags::Empty()
+{
+	ActorIds.Empty();
+	Bits.Empty();
+	LookupSlots.Empty();
+	LookupEntries = 0;
+}
+
+SIZE_T FLevelActorFlags::GetAllocatedSize() const
+{
+	return ActorIds.GetAllocatedSize() + Bits.GetAllocatedSize() + LookupSlots.GetAllocatedSize();
+}
+
+int32 FLevelActorFlags::FindIndex(const FLevelActorId& ActorId) const
+{
+	// Loaded sets arrive without their lookup, so build it the first time it is needed
+	if(LookupEntries != ActorIds.Num())
+	{
+		RebuildLookup(ActorIds.Num());
+	}
+	if(LookupSlots.IsEmpty())
+	{
+		return INDEX_NONE;
+	}
+
+	const uint32 Mask = LookupSlots.Num() - 1;
+	for(uint32 Slot = static_cast<uint32>(ActorId.Value) & Mask; LookupSlots[Slot] != INDEX_NONE; Slot = (Slot + 1) & Mask)
+	{
+		if(ActorIds[LookupSlots[Slot]] == ActorId.Value)
+		{
+			return LookupSlots[Slot];
+		}
+	}
+	return INDEX_NONE;
+}
+
+void FLevelActorFlags::RebuildLookup(int32 MinEntries) const
+{
+	const int32 NumSlots = FMath::RoundUpToPowerOfTwo(FMath::Max(MinEntries * 2, 16));
+	LookupSlots.Init(INDEX_NONE, NumSlots);
+
+	const uint32 Mask = NumSlots - 1;
+	for(int32 Index = 0; Index < ActorIds.Num(); Index++)
+	{
+		uint32 Slot = static_cast<uint32>(ActorIds[Index]) & Mask;
+		while(LookupSlots[Slot] != INDEX_NONE)
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+		LookupSlots[Slot] = Index;
+	}
+	LookupEntries = ActorIds.Num();
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameFramework/LevelActorId.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Hash/CityHash.h"
+#include "Interfaces/LevelSaveInterface.h"
+
+FLevelActorId FLevelActorId::FromActor(const AActor* Actor)
+{
+	if(!::IsValid(Actor))
+	{
+		return FLevelActorId();
+	}
+
+	// Actors that are spawned at runtime don't have a stable name, so they can provide their own Guid instead
+	if(Actor->Implements<ULevelSaveInterface>())
+	{
+		const FGuid PersistentGuid = ILevelSaveInterface::Execute_GetPersistentGuid(const_cast<AActor*>(Actor));
+		if(PersistentGuid.IsValid())
+		{
+			return FLevelActorId(CityHash64(reinterpret_cast<const char*>(&PersistentGuid), sizeof(FGuid)));
+		}
+	}
+
+	// Actors in a partitioned world are streamed in from generated cell packages, so use the world's package for those,
+	// and the package of the Actor's own Level otherwise so that Actors in different sub levels can't collide
+	const UWorld* World = Actor->GetWorld();
+	const UObject* PackageOwner = World && World->IsPartitionedWorld() ? static_cast<const UObject*>(World) : static_cast<const UObject*>(Actor->GetLevel());
+	const FString PackageName = PackageOwner ? UWorld::RemovePIEPrefix(PackageOwner->GetOutermost()->GetName()) : FString();
+
+	const FString ActorPath = PackageName + TEXT(":") + Actor->GetName();
+	const FTCHARToUTF8 Utf8Path(*ActorPath);
+	return FLevelActorId(CityHash64(Utf8Path.Get(), Utf8Path.Length()));
+}
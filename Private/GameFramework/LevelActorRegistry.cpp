@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameFramework/LevelActorRegistry.h"
+#include "GameFramework/Actor.h"
+#include "Interfaces/LevelSaveInterface.h"
+
+int32 FLevelActorRegistry::Register(AActor* Actor)
+{
+	if(!IsValid(Actor))
+	{
+		return INDEX_NONE;
+	}
+	return Register(FLevelActorId::FromActor(Actor), Actor);
+}
+
+int32 FLevelActorRegistry::Register(const FLevelActorId& ActorId, AActor* Actor)
+{
+	const bool bImplementsInterface = IsValid(Actor) && Actor->Implements<ULevelSaveInterface>();
+
+	if(const int32* Existing = IndexById.Find(ActorId))
+	{
+		FRegisteredLevelActor& Entry = Entries[*Existing];
+		Entry.Actor = Actor;
+		Entry.bImplementsInterface = bImplementsInterface;
+		return *Existing;
+	}
+
+	const int32 Index = Entries.Add({ActorId, Actor, bImplementsInterface});
+	IndexById.Add(ActorId, Index);
+	return Index;
+}
+
+bool FLevelActorRegistry::Unregister(const FLevelActorId& ActorId, const AActor* Actor)
+{
+	const int32* Index = IndexById.Find(ActorId);
+	if(!Index || (Actor && Entries[*Index].Actor.Get() != Actor))
+	{
+		return false;
+	}
+
+	RemoveAt(*Index);
+	return true;
+}
+
+void FLevelActorRegistry::Reserve(int32 Number)
+{
+	Entries.Reserve(Number);
+	IndexById.Reserve(Number);
+}
+
+void FLevelActorRegistry::Reset()
+{
+	Entries.Reset();
+	IndexById.Reset();
+}
+
+void FLevelActorRegistry::RemoveAt(int32 Index)
+{
+	IndexById.Remove(Entries[Index].Id);
+
+	const int32 LastIndex = Entries.Num() - 1;
+	if(Index != LastIndex)
+	{
+		IndexById[Entries[LastIndex].Id] = Index;
+	}
+	Entries.RemoveAtSwap(Index);
+}
@@ -3,3 +3,50 @@
 
 #include "GameFramework/LevelSaveObject.h"
 
+
+void ULevelSaveObject::MergeFrom(const ULevelSaveObject* Other)
+{
+	if(!Other)
+	{
+		return;
+	}
+
+	InteractedActors.Append(Other->InteractedActors);
+	MovedActors.Append(Other->MovedActors);
+}
+
+void ULevelSaveObject::Serialize(FArchive& Ar)
+{
+	// Only persistent saves are quantized, so things like reference collection and Snapshot copies see the full transforms
+	if(Ar.IsSaving() && Ar.IsPersistent() && !Ar.IsObjectReferenceCollector() && bQuantizeMovedActors && !MovedActors.IsEmpty())
+	{
+		QuantizedMovedActors.Encode(MovedActors);
+		TMap<FLevelActorId, FTransform> FullTransforms = MoveTemp(MovedActors);
+		MovedActors.Reset();
+
+		Super::Serialize(Ar);
+
+		MovedActors = MoveTemp(FullTransforms);
+		QuantizedMovedActors.Empty();
+	}
+	else
+	{
+		Super::Serialize(Ar);
+	}
+
+	if(Ar.IsLoading() && !QuantizedMovedActors.IsEmpty())
+	{
+		QuantizedMovedActors.Decode(MovedActors);
+		QuantizedMovedActors.Empty();
+	}
+
+	if(Ar.IsLoading() && !InteractedWithActors_DEPRECATED.IsEmpty())
+	{
+		InteractedActors.Reserve(InteractedActors.Num() + InteractedWithActors_DEPRECATED.Num());
+		for(const TPair<FLevelActorId, bool>& InteractedActor : InteractedWithActors_DEPRECATED)
+		{
+			InteractedActors.Set(InteractedActor.Key, InteractedActor.Value);
+		}
+		InteractedWithActors_DEPRECATED.Empty();
+	}
+}
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameFramework/QuantizedActorTransforms.h"
+#include "SaveSystem.h"
+#include "Math/VectorRegister.h"
+
+namespace QuantizedActorTransforms
+{
+	static constexpr int32 RotationBits = 10;
+	static constexpr uint32 RotationMask = (1u << RotationBits) - 1;
+
+	// The three smallest components of a unit quaternion lie within +-1/sqrt(2)
+	static constexpr float RotationRange = UE_INV_SQRT_2;
+
+	static uint32 QuantizeRotationComponent(double Component)
+	{
+		const double Normalized = (Component / RotationRange) * 0.5 + 0.5;
+		return static_cast<uint32>(FMath::Clamp(FMath::RoundToInt(Normalized * RotationMask), 0, static_cast<int32>(RotationMask)));
+	}
+
+	static uint32 EncodeRotation(FQuat Rotation)
+	{
+		Rotation.Normalize();
+		const double Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+
+		int32 Largest = 0;
+		for(int32 Index = 1; Index < 4; Index++)
+		{
+			if(FMath::Abs(Components[Index]) > FMath::Abs(Components[Largest]))
+			{
+				Largest = Index;
+			}
+		}
+
+		// Q and -Q are the same rotation, so flip it to make the dropped component positive and rebuild it from the rest
+		const double Sign = Components[Largest] < 0.0 ? -1.0 : 1.0;
+		uint32 Packed = static_cast<uint32>(Largest) << (RotationBits * 3);
+		int32 Shift = RotationBits * 2;
+		for(int32 Index = 0; Index < 4; Index++)
+		{
+			if(Index != Largest)
+			{
+				Packed |= QuantizeRotationComponent(Components[Index] * Sign) << Shift;
+				Shift -= RotationBits;
+			}
+		}
+		return Packed;
+	}
+
+	static int32 QuantizePosition(double Value, double Origin, double InvStep)
+	{
+		return static_cast<int32>(FMath::Clamp<int64>(FMath::RoundToInt64((Value - Origin) * InvStep), MIN_int32, MAX_int32));
+	}
+}
+
+void FQuantizedActorTransforms::Encode(const TMap<FLevelActorId, FTransform>& Transforms, float InPositionStep)
+{
+	using namespace QuantizedActorTransforms;
+
+	Empty();
+	if(Transforms.IsEmpty())
+	{
+		return;
+	}
+
+	PositionStep = FMath::Max(InPositionStep, UE_KINDA_SMALL_NUMBER);
+
+	// Centre the positions, so the integers are as small as they can be and decode exactly
+	FBox Bounds(ForceInit);
+	for(const TPair<FLevelActorId, FTransform>& Entry : Transforms)
+	{
+		Bounds += Entry.Value.GetLocation();
+	}
+	Origin = Bounds.GetCenter();
+
+	const int32 Count = Transforms.Num();
+	ActorIds.Reserve(Count);
+	PositionsX.Reserve(Count);
+	PositionsY.Reserve(Count);
+	PositionsZ.Reserve(Count);
+	Rotations.Reserve(Count);
+
+	const double InvStep = 1.0 / PositionStep;
+	for(const TPair<FLevelActorId, FTransform>& Entry : Transforms)
+	{
+		const FVector Location = Entry.Value.GetLocation();
+		ActorIds.Add(Entry.Key.Value);
+		PositionsX.Add(QuantizePosition(Location.X, Origin.X, InvStep));
+		PositionsY.Add(QuantizePosition(Location.Y, Origin.Y, InvStep));
+		PositionsZ.Add(QuantizePosition(Location.Z, Origin.Z, InvStep));
+		Rotations.Add(EncodeRotation(Entry.Value.GetRotation()));
+
+		const FVector Scale = Entry.Value.GetScale3D();
+		if(!Scale.Equals(FVector::OneVector, UE_KINDA_SMALL_NUMBER))
+		{
+			ScaledIndices.Add(ActorIds.Num() - 1);
+			Scales.Add(FVector3f(Scale));
+		}
+	}
+}
+
+void FQuantizedActorTransforms::Decode(TArray<FLevelActorId>& OutActorIds, TArray<FTransform>& OutTransforms) const
+{
+	using namespace QuantizedActorTransforms;
+
+	const int32 Count = ActorIds.Num();
+	if(PositionsX.Num() != Count || PositionsY.Num() != Count || PositionsZ.Num() != Count || Rotations.Num() != Count || ScaledIndices.Num() != Scales.Num())
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Quantized Actor Transforms are corrupt, %d Ids but %d Rotations"), Count, Rotations.Num());
+		OutActorIds.Reset();
+		OutTransforms.Reset();
+		return;
+	}
+
+	OutActorIds.SetNumUninitialized(Count);
+	OutTransforms.SetNumUninitialized(Count);
+
+	// Positions are scaled in double, as a float only holds the step count exactly up to 2^24
+	const double Step = PositionStep;
+	const VectorRegister4Float RotationScale = VectorSetFloat1(2.f * RotationRange / RotationMask);
+	const VectorRegister4Float RotationBias = VectorSetFloat1(-RotationRange);
+	const VectorRegister4Float One = VectorOneFloat();
+	const VectorRegister4Float Zero = VectorZeroFloat();
+
+	// Four entries at a time. The last block is padded with zeros, which decode to valid but unused values
+	for(int32 Block = 0; Block < Count; Block += 4)
+	{
+		const int32 Lanes = FMath::Min(4, Count - Block);
+
+		alignas(16) int32 X[4] = {};
+		alignas(16) int32 Y[4] = {};
+		alignas(16) int32 Z[4] = {};
+		alignas(16) int32 A[4] = {};
+		alignas(16) int32 B[4] = {};
+		alignas(16) int32 C[4] = {};
+		for(int32 Lane = 0; Lane < Lanes; Lane++)
+		{
+			X[Lane] = PositionsX[Block + Lane];
+			Y[Lane] = PositionsY[Block + Lane];
+			Z[Lane] = PositionsZ[Block + Lane];
+
+			const uint32 Packed = Rotations[Block + Lane];
+			A[Lane] = (Packed >> (RotationBits * 2)) & RotationMask;
+			B[Lane] = (Packed >> RotationBits) & RotationMask;
+			C[Lane] = Packed & RotationMask;
+		}
+
+		// Rebuild the dropped component of four quaternions at once from the unit length
+		const VectorRegister4Float First = VectorMultiplyAdd(VectorIntToFloat(VectorIntLoadAligned(A)), RotationScale, RotationBias);
+		const VectorRegister4Float Second = VectorMultiplyAdd(VectorIntToFloat(VectorIntLoadAligned(B)), RotationScale, RotationBias);
+		const VectorRegister4Float Third = VectorMultiplyAdd(VectorIntToFloat(VectorIntLoadAligned(C)), RotationScale, RotationBias);
+		const VectorRegister4Float SumOfSquares = VectorMultiplyAdd(First, First, VectorMultiplyAdd(Second, Second, VectorMultiply(Third, Third)));
+		const VectorRegister4Float Dropped = VectorSqrt(VectorMax(VectorSubtract(One, SumOfSquares), Zero));
+
+		alignas(16) float Components[4][4];
+		VectorStoreAligned(First, Components[0]);
+		VectorStoreAligned(Second, Components[1]);
+		VectorStoreAligned(Third, Components[2]);
+		VectorStoreAligned(Dropped, Components[3]);
+
+		for(int32 Lane = 0; Lane < Lanes; Lane++)
+		{
+			const int32 Index = Block + Lane;
+			const uint32 Largest = Rotations[Index] >> (RotationBits * 3);
+
+			float Quat[4];
+			int32 Next = 0;
+			for(uint32 Component = 0; Component < 4; Component++)
+			{
+				Quat[Component] = Component == Largest ? Components[3][Lane] : Components[Next++][Lane];
+			}
+
+			OutActorIds[Index] = FLevelActorId(ActorIds[Index]);
+			OutTransforms[Index] = FTransform(FQuat(Quat[0], Quat[1], Quat[2], Quat[3]),
+				Origin + FVector(X[Lane], Y[Lane], Z[Lane]) * Step, FVector::OneVector);
+		}
+	}
+
+	for(int32 Scaled = 0; Scaled < ScaledIndices.Num(); Scaled++)
+	{
+		if(OutTransforms.IsValidIndex(ScaledIndices[Scaled]))
+		{
+			OutTransforms[ScaledIndices[Scaled]].SetScale3D(FVector(Scales[Scaled]));
+		}
+	}
+}
+
+void FQuantizedActorTransforms::Decode(TMap<FLevelActorId, FTransform>& OutTransforms) const
+{
+	TArray<FLevelActorId> DecodedIds;
+	TArray<FTransform> DecodedTransforms;
+	Decode(DecodedIds, DecodedTransforms);
+
+	OutTransforms.Reserve(OutTransforms.Num() + DecodedIds.Num());
+	for(int32 Index = 0; Index < DecodedIds.Num(); Index++)
+	{
+		OutTransforms.Add(DecodedIds[Index], DecodedTransforms[Index]);
+	}
+}
+
+void FQuantizedActorTransforms::Empty()
+{
+	Origin = FVector::ZeroVector;
+	ActorIds.Empty();
+	PositionsX.Empty();
+	PositionsY.Empty();
+	PositionsZ.Empty();
+	Rotations.Empty();
+	ScaledIndices.Empty();
+	Scales.Empty();
+}
+
+SIZE_T FQuantizedActorTransforms::GetAllocatedSize() const
+{
+	return ActorIds.GetAllocatedSize() + PositionsX.GetAllocatedSize() + PositionsY.GetAllocatedSize() + PositionsZ.GetAllocatedSize()
+		+ Rotations.GetAllocatedSize() + ScaledIndices.GetAllocatedSize() + Scales.GetAllocatedSize();
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameFramework/SaveSlotManifest.h"
+
+FSaveSlotManifestEntry* USaveSlotManifest::FindEntry(const FString& SlotName)
+{
+	return Entries.FindByPredicate([&SlotName](const FSaveSlotManifestEntry& Entry) { return Entry.SlotName == SlotName; });
+}
+
+const FSaveSlotManifestEntry* USaveSlotManifest::FindEntry(const FString& SlotName) const
+{
+	return Entries.FindByPredicate([&SlotName](const FSaveSlotManifestEntry& Entry) { return Entry.SlotName == SlotName; });
+}
+
+FSaveSlotManifestEntry& USaveSlotManifest::FindOrAddEntry(const FString& SlotName)
+{
+	if(FSaveSlotManifestEntry* Entry = FindEntry(SlotName))
+	{
+		return *Entry;
+	}
+
+	FSaveSlotManifestEntry& NewEntry = Entries.AddDefaulted_GetRef();
+	NewEntry.SlotName = SlotName;
+	return NewEntry;
+}
+
+bool USaveSlotManifest::RemoveEntry(const FString& SlotName)
+{
+	return Entries.RemoveAll([&SlotName](const FSaveSlotManifestEntry& Entry) { return Entry.SlotName == SlotName; }) > 0;
+}
@@ -4,3 +4,8 @@
 #include "Interfaces/LevelSaveInterface.h"
 
 // Add default functionality here for any ILevelSaveInterface functions that are not pure virtual.
+
+FGuid ILevelSaveInterface::GetPersistentGuid_Implementation()
+{
+	return FGuid();
+}
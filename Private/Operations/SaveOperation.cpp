@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Operations/SaveOperation.h"
+#include "GameFramework/SaveGame.h"
+#include "Async/TaskGraphInterfaces.h"
+
+namespace SaveOperation
+{
+	// How many OnComplete callbacks are running on the Game Thread, which is the only thread they run on
+	static int32 CallbackDepth = 0;
+
+	static void RunCallback(const TFunction<void(const FSaveOperation&)>& Callback, const FSaveOperation& Operation)
+	{
+		CallbackDepth++;
+		Callback(Operation);
+		CallbackDepth--;
+	}
+}
+
+FSaveOperation::FSaveOperation(const FString& InSlotName)
+	: SlotName(InSlotName)
+{
+}
+
+FSaveOperation& FSaveOperation::OnComplete(TFunction<void(const FSaveOperation&)> Callback)
+{
+	check(IsInGameThread());
+
+	if(IsDone())
+	{
+		SaveOperation::RunCallback(Callback, *this);
+	}
+	else
+	{
+		Callbacks.Add(MoveTemp(Callback));
+	}
+	return *this;
+}
+
+TSharedRef<FSaveOperation> FSaveOperation::Then(TFunction<TSharedPtr<FSaveOperation>(const FSaveOperation&)> Next)
+{
+	check(IsInGameThread());
+
+	const TSharedRef<FSaveOperation> Chained = MakeShared<FSaveOperation>(SlotName);
+
+	// Until Next has run, waiting on the chain means waiting on this operation
+	Chained->ExpediteHandler = [WeakPrevious = AsWeak()]()
+	{
+		if(const TSharedPtr<FSaveOperation> Previous = WeakPrevious.Pin())
+		{
+			Previous->Expedite();
+		}
+	};
+
+	OnComplete([Chained, Next = MoveTemp(Next)](const FSaveOperation& Previous)
+	{
+		if(Chained->IsDone())
+		{
+			return;
+		}
+
+		const TSharedPtr<FSaveOperation> Started = Next(Previous);
+		if(!Started.IsValid())
+		{
+			Chained->Finish(ESaveOperationState::Cancelled, FSavePipelineStats(), nullptr);
+			return;
+		}
+
+		Chained->SlotName = Started->SlotName;
+		Chained->State = ESaveOperationState::Running;
+		Chained->ExpediteHandler = [WeakStarted = Started.ToWeakPtr()]()
+		{
+			if(const TSharedPtr<FSaveOperation> Pinned = WeakStarted.Pin())
+			{
+				Pinned->Expedite();
+			}
+		};
+		Chained->CancelHandler = [WeakStarted = Started.ToWeakPtr()]()
+		{
+			const TSharedPtr<FSaveOperation> Pinned = WeakStarted.Pin();
+			return Pinned && Pinned->Cancel();
+		};
+		Started->OnComplete([Chained](const FSaveOperation& Result)
+		{
+			Chained->Finish(Result.GetState(), Result.GetStats(), Result.GetSaveGame());
+		});
+	});
+	return Chained;
+}
+
+bool FSaveOperation::Wait(float TimeoutSeconds)
+{
+	const double EndTime = TimeoutSeconds < 0.f ? TNumericLimits<double>::Max() : FPlatformTime::Seconds() + TimeoutSeconds;
+
+	// Everything that finishes an operation runs on the Game Thread, so waiting there has to keep those tasks running
+	if(IsInGameThread())
+	{
+		// Callbacks run from inside the Game Thread tasks that finish operations, so pumping those tasks again from a
+		// callback would re-enter the task graph
+		if(!ensureMsgf(SaveOperation::CallbackDepth == 0, TEXT("Save Operation for Slot %s was waited on from inside a Save Operation callback"), *SlotName))
+		{
+			return IsDone();
+		}
+
+		while(!IsDone())
+		{
+			if(FPlatformTime::Seconds() >= EndTime)
+			{
+				return false;
+			}
+			Expedite();
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+			if(!IsDone())
+			{
+				FPlatformProcess::SleepNoStats(0.f);
+			}
+		}
+		return true;
+	}
+
+	if(TimeoutSeconds < 0.f)
+	{
+		return DoneEvent->Wait();
+	}
+	return DoneEvent->Wait(FTimespan::FromSeconds(TimeoutSeconds)) || IsDone();
+}
+
+bool FSaveOperation::Cancel()
+{
+	check(IsInGameThread());
+
+	if(GetState() == ESaveOperationState::Queued)
+	{
+		Finish(ESaveOperationState::Cancelled, FSavePipelineStats(), nullptr);
+		return true;
+	}
+	return GetState() == ESaveOperationState::Running && CancelHandler && CancelHandler();
+}
+
+bool FSaveOperation::Start()
+{
+	ESaveOperationState Expected = ESaveOperationState::Queued;
+	return State.compare_exchange_strong(Expected, ESaveOperationState::Running) || Expected == ESaveOperationState::Running;
+}
+
+void FSaveOperation::Complete(bool bSuccess, const FSavePipelineStats& InStats, USaveGame* InSaveGame)
+{
+	if(!IsDone())
+	{
+		Finish(bSuccess ? ESaveOperationState::Succeeded : ESaveOperationState::Failed, InStats, InSaveGame);
+	}
+}
+
+void FSaveOperation::Expedite()
+{
+	// Starting the operation can finish it straight away, which resets the handler, so call a copy
+	if(const TFunction<void()> Handler = ExpediteHandler)
+	{
+		Handler();
+	}
+}
+
+void FSaveOperation::Finish(ESaveOperationState FinalState, const FSavePipelineStats& InStats, USaveGame* InSaveGame)
+{
+	check(IsInGameThread());
+
+	Stats = InStats;
+	SaveGame = InSaveGame;
+	State = FinalState;
+	ExpediteHandler.Reset();
+	CancelHandler.Reset();
+	DoneEvent->Trigger();
+
+	// A callback may start more operations, or even add callbacks to this one, so run from a copy
+	const TArray<TFunction<void(const FSaveOperation&)>> CompletedCallbacks = MoveTemp(Callbacks);
+	Callbacks.Reset();
+	for(const TFunction<void(const FSaveOperation&)>& Callback : CompletedCallbacks)
+	{
+		SaveOperation::RunCallback(Callback, *this);
+	}
+}
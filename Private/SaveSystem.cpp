@@ -1,6 +1,9 @@
 ﻿#include "SaveSystem.h"
 
 DEFINE_LOG_CATEGORY(LogSaveSystem);
+DEFINE_LOG_CATEGORY(LogSaveSystemLevel);
+DEFINE_LOG_CATEGORY(LogSaveSystemSlots);
+DEFINE_LOG_CATEGORY(LogSaveSystemPipeline);
 
 #define LOCTEXT_NAMESPACE "FSaveSystemModule"
 
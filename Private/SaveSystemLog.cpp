@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SaveSystemLog.h"
+#include "HAL/IConsoleManager.h"
+
+namespace SaveSystemLog
+{
+	static float AggregateSeconds = 5.f;
+	static FAutoConsoleVariableRef CVarAggregateSeconds(
+		TEXT("SaveSystem.Log.AggregateSeconds"),
+		AggregateSeconds,
+		TEXT("The shortest time between two lines of the same high frequency Save System log. Repeats in between are counted into the next line"));
+}
+
+bool FSaveLogAggregator::Add(int32& OutCount)
+{
+	PendingCount.fetch_add(1, std::memory_order_relaxed);
+
+	const double Now = FPlatformTime::Seconds();
+	double LastTime = LastLogTime.load(std::memory_order_relaxed);
+	if(LastTime != 0.0 && Now - LastTime < SaveSystemLog::AggregateSeconds)
+	{
+		return false;
+	}
+
+	// Only the thread that claims the interval logs it, everyone else is counted into the next line
+	if(!LastLogTime.compare_exchange_strong(LastTime, Now))
+	{
+		return false;
+	}
+
+	OutCount = PendingCount.exchange(0);
+	return OutCount > 0;
+}
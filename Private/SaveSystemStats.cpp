@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SaveSystemStats.h"
+#include "HAL/IConsoleManager.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+DEFINE_STAT(STAT_SaveSystem_Snapshot);
+DEFINE_STAT(STAT_SaveSystem_Serialize);
+DEFINE_STAT(STAT_SaveSystem_Compress);
+DEFINE_STAT(STAT_SaveSystem_Write);
+DEFINE_STAT(STAT_SaveSystem_Read);
+DEFINE_STAT(STAT_SaveSystem_Decompress);
+DEFINE_STAT(STAT_SaveSystem_Deserialize);
+DEFINE_STAT(STAT_SaveSystem_OnObjectLoaded);
+DEFINE_STAT(STAT_SaveSystem_LevelRestore);
+
+DEFINE_STAT(STAT_SaveSystem_BytesWritten);
+DEFINE_STAT(STAT_SaveSystem_BytesRead);
+DEFINE_STAT(STAT_SaveSystem_QueuedOperations);
+DEFINE_STAT(STAT_SaveSystem_SaveLatency);
+DEFINE_STAT(STAT_SaveSystem_LoadLatency);
+
+UE_TRACE_CHANNEL_DEFINE(SaveSystemChannel);
+
+TRACE_DECLARE_INT_COUNTER(SaveSystem_BytesWritten, TEXT("SaveSystem/BytesWritten"));
+TRACE_DECLARE_INT_COUNTER(SaveSystem_BytesRead, TEXT("SaveSystem/BytesRead"));
+TRACE_DECLARE_INT_COUNTER(SaveSystem_QueuedOperations, TEXT("SaveSystem/QueuedOperations"));
+TRACE_DECLARE_FLOAT_COUNTER(SaveSystem_SaveLatencyMs, TEXT("SaveSystem/SaveLatencyMs"));
+TRACE_DECLARE_FLOAT_COUNTER(SaveSystem_LoadLatencyMs, TEXT("SaveSystem/LoadLatencyMs"));
+
+namespace SaveSystemStats
+{
+	static float LatencyBookmarkMs = 250.f;
+	static FAutoConsoleVariableRef CVarLatencyBookmarkMs(
+		TEXT("SaveSystem.Trace.LatencyBookmarkMs"),
+		LatencyBookmarkMs,
+		TEXT("Saves and loads that take longer than this many milliseconds from request to completion are bookmarked in the trace with their Slot"));
+
+	void RecordBytesWritten(int64 Bytes)
+	{
+		INC_DWORD_STAT_BY(STAT_SaveSystem_BytesWritten, Bytes);
+		TRACE_COUNTER_ADD(SaveSystem_BytesWritten, Bytes);
+	}
+
+	void RecordBytesRead(int64 Bytes)
+	{
+		INC_DWORD_STAT_BY(STAT_SaveSystem_BytesRead, Bytes);
+		TRACE_COUNTER_ADD(SaveSystem_BytesRead, Bytes);
+	}
+
+	void RecordQueuedOperations(int32 Delta)
+	{
+		if(Delta >= 0)
+		{
+			INC_DWORD_STAT_BY(STAT_SaveSystem_QueuedOperations, Delta);
+		}
+		else
+		{
+			DEC_DWORD_STAT_BY(STAT_SaveSystem_QueuedOperations, -Delta);
+		}
+		TRACE_COUNTER_ADD(SaveSystem_QueuedOperations, Delta);
+	}
+
+	void RecordSaveLatency(const FString& SlotName, double LatencyMs)
+	{
+		SET_FLOAT_STAT(STAT_SaveSystem_SaveLatency, LatencyMs);
+		TRACE_COUNTER_SET(SaveSystem_SaveLatencyMs, LatencyMs);
+		if(LatencyMs >= LatencyBookmarkMs)
+		{
+			TRACE_BOOKMARK(TEXT("Save %s took %.1fms"), *SlotName, LatencyMs);
+		}
+	}
+
+	void RecordLoadLatency(const FString& SlotName, double LatencyMs)
+	{
+		SET_FLOAT_STAT(STAT_SaveSystem_LoadLatency, LatencyMs);
+		TRACE_COUNTER_SET(SaveSystem_LoadLatencyMs, LatencyMs);
+		if(LatencyMs >= LatencyBookmarkMs)
+		{
+			TRACE_BOOKMARK(TEXT("Load %s took %.1fms"), *SlotName, LatencyMs);
+		}
+	}
+}
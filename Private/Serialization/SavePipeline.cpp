@@ -0,0 +1,514 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Serialization/SavePipeline.h"
+#include "SaveSystem.h"
+#include "SaveSystemStats.h"
+#include "Async/Async.h"
+#include "Compression/OodleDataCompression.h"
+#include "GameFramework/SaveGame.h"
+#include "Hash/xxhash.h"
+#include "Kismet/GameplayStatics.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Storage/SaveStorageBackend.h"
+#include "Tasks/Task.h"
+#include "UObject/Package.h"
+#include "UObject/UnrealType.h"
+#include <atomic>
+
+namespace SavePipeline
+{
+	// 'SSPZ'. Engine save data starts with 'GVAS', so the two can never be confused when loading
+	static constexpr uint32 PayloadMagic = 0x5A505353;
+	static constexpr uint8 PayloadVersion = 1;
+
+	enum class EPayloadCodec : uint8
+	{
+		None,
+		Oodle
+	};
+
+	// Magic + Version + Codec + Raw Size
+	static constexpr int64 HeaderSize = sizeof(uint32) + sizeof(uint8) + sizeof(uint8) + sizeof(int64);
+
+	static float MsSince(const double StartTime)
+	{
+		return static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+
+	static bool WriteSlot(ISaveStorageBackend& Storage, const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data, FSavePipelineStats& Stats)
+	{
+		SAVESYSTEM_SCOPE(Write);
+
+		const double WriteStart = FPlatformTime::Seconds();
+		const bool bSuccess = Storage.Write(SlotName, UserIndex, Data);
+		Stats.WriteMs = MsSince(WriteStart);
+		Stats.StoredBytes = Data.Num();
+		if(bSuccess)
+		{
+			SaveSystemStats::RecordBytesWritten(Data.Num());
+		}
+		return bSuccess;
+	}
+
+	static bool ReadSlot(ISaveStorageBackend& Storage, const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData, FSavePipelineStats& Stats)
+	{
+		SAVESYSTEM_SCOPE(Read);
+
+		const double ReadStart = FPlatformTime::Seconds();
+		const bool bSuccess = Storage.Read(SlotName, UserIndex, OutData);
+		Stats.ReadMs = MsSince(ReadStart);
+		Stats.StoredBytes = OutData.Num();
+		if(bSuccess)
+		{
+			SaveSystemStats::RecordBytesRead(OutData.Num());
+		}
+		return bSuccess;
+	}
+
+	/**
+	 * Get the options to write to a backend with, which for backends that only store changes means without compression
+	 */
+	static FSaveWriteOptions GetOptionsFor(const ISaveStorageBackend& Storage, const FSaveWriteOptions& Options)
+	{
+		FSaveWriteOptions StorageOptions = Options;
+		if(Storage.StoresChangesOnly())
+		{
+			StorageOptions.Codec = ESaveCompressionCodec::None;
+		}
+		return StorageOptions;
+	}
+}
+
+bool FSavePipeline::SaveAsync(USaveGame* SaveGameObject, const FString& SlotName, int32 UserIndex, FOnSavePipelineFinished OnFinished, const FSaveWriteOptions& Options)
+{
+	check(IsInGameThread());
+
+	if(!IsValid(SaveGameObject) || SlotName.IsEmpty())
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Pipeline could not start for Slot %s"), *SlotName);
+		return false;
+	}
+
+	// The Snapshot is the only part of the save that the Game Thread pays for
+	FSavePipelineStats Stats;
+	const double SnapshotStart = FPlatformTime::Seconds();
+	USaveGame* Snapshot = CreateSnapshot(SaveGameObject);
+	Stats.SnapshotMs = SavePipeline::MsSince(SnapshotStart);
+
+	// Hold on to the backend that was active when the save started, even if it is swapped while the task is running
+	TSharedRef<ISaveStorageBackend> Storage = FSaveStorage::Get();
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshot, SlotName, UserIndex, Storage, Stats, Options = SavePipeline::GetOptionsFor(*Storage, Options),
+		OnFinished = MoveTemp(OnFinished)]() mutable
+	{
+		TArray<uint8> Data;
+		bool bSuccess = EncodePayload(Snapshot, Data, Stats, Options);
+		if(bSuccess && !Stats.bSkippedUnchanged)
+		{
+			bSuccess = SavePipeline::WriteSlot(*Storage, SlotName, UserIndex, Data, Stats);
+		}
+
+		// Hand the result back to the Game Thread, which is also the only place the Snapshot can be released
+		AsyncTask(ENamedThreads::GameThread, [Snapshot, bSuccess, Stats, OnFinished = MoveTemp(OnFinished)]()
+		{
+			ReleaseSnapshot(Snapshot);
+			OnFinished.ExecuteIfBound(bSuccess, Stats);
+		});
+	});
+
+	return true;
+}
+
+bool FSavePipeline::SaveBatchAsync(const TArray<USaveGame*>& SaveGameObjects, const TArray<FString>& SlotNames, int32 UserIndex, FOnSaveBatchPipelineFinished OnFinished,
+	const TArray<FSaveWriteOptions>& Options)
+{
+	check(IsInGameThread());
+
+	if(SaveGameObjects.Num() == 0 || SaveGameObjects.Num() != SlotNames.Num())
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Pipeline could not start a batch of %d Slots"), SlotNames.Num());
+		return false;
+	}
+
+	TArray<USaveGame*> Snapshots;
+	TArray<FSavePipelineStats> Stats;
+	Snapshots.Reserve(SaveGameObjects.Num());
+	Stats.SetNum(SaveGameObjects.Num());
+	for(int32 Index = 0; Index < SaveGameObjects.Num(); Index++)
+	{
+		if(!IsValid(SaveGameObjects[Index]) || SlotNames[Index].IsEmpty())
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Save Pipeline could not start a batch, Slot %s is invalid"), *SlotNames[Index]);
+			for(USaveGame* Snapshot : Snapshots)
+			{
+				ReleaseSnapshot(Snapshot);
+			}
+			return false;
+		}
+
+		const double SnapshotStart = FPlatformTime::Seconds();
+		Snapshots.Add(CreateSnapshot(SaveGameObjects[Index]));
+		Stats[Index].SnapshotMs = SavePipeline::MsSince(SnapshotStart);
+	}
+
+	TSharedRef<ISaveStorageBackend> Storage = FSaveStorage::Get();
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshots, SlotNames, UserIndex, Storage, Stats, Options, OnFinished = MoveTemp(OnFinished)]() mutable
+	{
+		bool bSuccess = true;
+		TArray<TPair<FString, TArray<uint8>>> Slots;
+		Slots.Reserve(Snapshots.Num());
+		for(int32 Index = 0; Index < Snapshots.Num() && bSuccess; Index++)
+		{
+			TArray<uint8> Data;
+			bSuccess = EncodePayload(Snapshots[Index], Data, Stats[Index],
+				SavePipeline::GetOptionsFor(*Storage, Options.IsValidIndex(Index) ? Options[Index] : FSaveWriteOptions()));
+			if(bSuccess && !Stats[Index].bSkippedUnchanged)
+			{
+				Stats[Index].StoredBytes = Data.Num();
+				Slots.Emplace(SlotNames[Index], MoveTemp(Data));
+			}
+		}
+
+		// The whole batch is written in one call, so the time is shared out between the Slots
+		if(bSuccess && Slots.Num() > 0)
+		{
+			SAVESYSTEM_SCOPE(Write);
+
+			const double WriteStart = FPlatformTime::Seconds();
+			bSuccess = Storage->WriteBatch(Slots, UserIndex);
+			const float WriteMs = SavePipeline::MsSince(WriteStart) / Slots.Num();
+			for(FSavePipelineStats& SlotStats : Stats)
+			{
+				SlotStats.WriteMs = SlotStats.bSkippedUnchanged ? 0.f : WriteMs;
+				if(bSuccess && !SlotStats.bSkippedUnchanged)
+				{
+					SaveSystemStats::RecordBytesWritten(SlotStats.StoredBytes);
+				}
+			}
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [Snapshots, bSuccess, Stats, OnFinished = MoveTemp(OnFinished)]()
+		{
+			for(USaveGame* Snapshot : Snapshots)
+			{
+				ReleaseSnapshot(Snapshot);
+			}
+			OnFinished.ExecuteIfBound(bSuccess, Stats);
+		});
+	});
+
+	return true;
+}
+
+bool FSavePipeline::SaveSync(USaveGame* SaveGameObject, const FString& SlotName, int32 UserIndex, FSavePipelineStats& OutStats, const FSaveWriteOptions& Options)
+{
+	if(!IsValid(SaveGameObject) || SlotName.IsEmpty())
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Pipeline could not start for Slot %s"), *SlotName);
+		return false;
+	}
+
+	const TSharedRef<ISaveStorageBackend> Storage = FSaveStorage::Get();
+	TArray<uint8> Data;
+	if(!EncodePayload(SaveGameObject, Data, OutStats, SavePipeline::GetOptionsFor(*Storage, Options)))
+	{
+		return false;
+	}
+	if(OutStats.bSkippedUnchanged)
+	{
+		return true;
+	}
+
+	return SavePipeline::WriteSlot(*Storage, SlotName, UserIndex, Data, OutStats);
+}
+
+void FSavePipeline::LoadAsync(const FString& SlotName, int32 UserIndex, FOnLoadPipelineFinished OnFinished)
+{
+	check(IsInGameThread());
+
+	if(SlotName.IsEmpty())
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Load Pipeline could not start for Slot %s"), *SlotName);
+		OnFinished.ExecuteIfBound(nullptr, FSavePipelineStats());
+		return;
+	}
+
+	TSharedRef<ISaveStorageBackend> Storage = FSaveStorage::Get();
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [SlotName, UserIndex, Storage, OnFinished = MoveTemp(OnFinished)]() mutable
+	{
+		FSavePipelineStats Stats;
+		TArray<uint8> Data;
+
+		const bool bSuccess = SavePipeline::ReadSlot(*Storage, SlotName, UserIndex, Data, Stats) && DecodePayload(Data, Stats);
+
+		// Creating the Save Game Object has to happen on the Game Thread
+		AsyncTask(ENamedThreads::GameThread, [Data = MoveTemp(Data), bSuccess, Stats, OnFinished = MoveTemp(OnFinished)]() mutable
+		{
+			USaveGame* SaveGame = bSuccess ? DeserializePayload(Data, Stats) : nullptr;
+			OnFinished.ExecuteIfBound(SaveGame, Stats);
+		});
+	});
+}
+
+USaveGame* FSavePipeline::LoadSync(const FString& SlotName, int32 UserIndex, FSavePipelineStats& OutStats)
+{
+	if(SlotName.IsEmpty())
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Load Pipeline could not start for Slot %s"), *SlotName);
+		return nullptr;
+	}
+
+	TArray<uint8> Data;
+	if(!SavePipeline::ReadSlot(*FSaveStorage::Get(), SlotName, UserIndex, Data, OutStats) || !DecodePayload(Data, OutStats))
+	{
+		return nullptr;
+	}
+	return DeserializePayload(Data, OutStats);
+}
+
+void FSavePipeline::LoadBatchAsync(const TArray<FString>& SlotNames, int32 UserIndex, int32 MaxConcurrency, FOnLoadBatchPipelineFinished OnFinished)
+{
+	check(IsInGameThread());
+
+	if(SlotNames.Num() == 0)
+	{
+		OnFinished.ExecuteIfBound({});
+		return;
+	}
+
+	// Shared between the workers. Each worker only ever touches the indices it claimed, so only the counters need to be atomic
+	struct FBatchLoadState
+	{
+		TArray<FString> SlotNames;
+		TArray<TArray<uint8>> Data;
+		TArray<bool> bDecoded;
+		TArray<FSavePipelineStats> Stats;
+		std::atomic<int32> NextIndex{0};
+		std::atomic<int32> RunningWorkers{0};
+		FOnLoadBatchPipelineFinished OnFinished;
+	};
+
+	TSharedRef<FBatchLoadState> State = MakeShared<FBatchLoadState>();
+	State->SlotNames = SlotNames;
+	State->Data.SetNum(SlotNames.Num());
+	State->bDecoded.SetNumZeroed(SlotNames.Num());
+	State->Stats.SetNum(SlotNames.Num());
+	State->OnFinished = MoveTemp(OnFinished);
+
+	TSharedRef<ISaveStorageBackend> Storage = FSaveStorage::Get();
+	const int32 NumWorkers = FMath::Clamp(MaxConcurrency, 1, SlotNames.Num());
+	State->RunningWorkers = NumWorkers;
+
+	for(int32 Worker = 0; Worker < NumWorkers; Worker++)
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [State, UserIndex, Storage]()
+		{
+			// Keep claiming Slots until there are none left, so a slow Slot never holds up the rest of the batch
+			for(int32 Index = State->NextIndex++; Index < State->SlotNames.Num(); Index = State->NextIndex++)
+			{
+				FSavePipelineStats& Stats = State->Stats[Index];
+				TArray<uint8>& Data = State->Data[Index];
+
+				State->bDecoded[Index] = SavePipeline::ReadSlot(*Storage, State->SlotNames[Index], UserIndex, Data, Stats) && DecodePayload(Data, Stats);
+			}
+
+			// The last worker out hands the whole batch back to the Game Thread
+			if(--State->RunningWorkers > 0)
+			{
+				return;
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [State]()
+			{
+				TArray<FSaveSlotLoadResult> Results;
+				Results.Reserve(State->SlotNames.Num());
+				for(int32 Index = 0; Index < State->SlotNames.Num(); Index++)
+				{
+					FSaveSlotLoadResult& Result = Results.AddDefaulted_GetRef();
+					Result.SlotName = State->SlotNames[Index];
+					Result.Stats = State->Stats[Index];
+					Result.SaveGame = State->bDecoded[Index] ? DeserializePayload(State->Data[Index], Result.Stats) : nullptr;
+					Result.bSuccess = Result.SaveGame != nullptr;
+
+					// Release the bytes as soon as they are no longer needed, rather than holding the whole batch until the end
+					State->Data[Index].Empty();
+				}
+				State->OnFinished.ExecuteIfBound(Results);
+			});
+		});
+	}
+}
+
+USaveGame* FSavePipeline::CreateSnapshot(USaveGame* Source)
+{
+	check(IsInGameThread());
+	SAVESYSTEM_SCOPE(Snapshot);
+
+	USaveGame* Snapshot = NewObject<USaveGame>(GetTransientPackage(), Source->GetClass());
+
+	// Copy property by property rather than passing Source in as the Template. Using it as the Template would also make it
+	// the Snapshot's archetype, and delta serialization would then skip every property that matches it
+	for(TFieldIterator<FProperty> It(Source->GetClass()); It; ++It)
+	{
+		if(!It->HasAnyPropertyFlags(CPF_Transient))
+		{
+			It->CopyCompleteValue_InContainer(Snapshot, Source);
+		}
+	}
+
+	// Keep the Snapshot alive while the worker task is using it
+	Snapshot->AddToRoot();
+	return Snapshot;
+}
+
+void FSavePipeline::ReleaseSnapshot(USaveGame* Snapshot)
+{
+	check(IsInGameThread());
+
+	if(Snapshot)
+	{
+		Snapshot->RemoveFromRoot();
+	}
+}
+
+bool FSavePipeline::EncodePayload(USaveGame* SaveGameObject, TArray<uint8>& OutData, FSavePipelineStats& Stats, const FSaveWriteOptions& Options)
+{
+	// Serialize in the same format as UGameplayStatics, so uncompressed data stays readable by the engine
+	const double SerializeStart = FPlatformTime::Seconds();
+	TArray<uint8> RawData;
+	{
+		SAVESYSTEM_SCOPE(Serialize);
+		if(!UGameplayStatics::SaveGameToMemory(SaveGameObject, RawData))
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Failed to serialize Save Game Object %s"), *GetNameSafe(SaveGameObject));
+			return false;
+		}
+	}
+	Stats.SerializeMs = SavePipeline::MsSince(SerializeStart);
+
+	// The codec is part of the hash, so changing it always rewrites the Slot
+	FXxHash64Builder HashBuilder;
+	HashBuilder.Update(RawData.GetData(), RawData.Num());
+	HashBuilder.Update(&Options.Codec, sizeof(Options.Codec));
+	Stats.PayloadHash = HashBuilder.Finalize().Hash;
+
+	if(Options.SkipIfHash != 0 && Stats.PayloadHash == Options.SkipIfHash)
+	{
+		Stats.RawBytes = RawData.Num();
+		Stats.Codec = Options.Codec;
+		Stats.bSkippedUnchanged = true;
+		OutData.Reset();
+		return true;
+	}
+
+	CompressPayload(MoveTemp(RawData), OutData, Stats, Options.Codec);
+	return true;
+}
+
+void FSavePipeline::CompressPayload(TArray<uint8>&& RawData, TArray<uint8>& OutData, FSavePipelineStats& Stats, ESaveCompressionCodec Codec)
+{
+	using namespace SavePipeline;
+	SAVESYSTEM_SCOPE(Compress);
+
+	Stats.RawBytes = RawData.Num();
+	Stats.Codec = Codec;
+	if(Codec == ESaveCompressionCodec::None)
+	{
+		OutData = MoveTemp(RawData);
+		return;
+	}
+
+	// Every Oodle compressor is decoded by the same call, so the codec choice doesn't need to be recorded in the header
+	const FOodleDataCompression::ECompressor Compressor = Codec == ESaveCompressionCodec::HighRatio
+		? FOodleDataCompression::ECompressor::Kraken : FOodleDataCompression::ECompressor::Mermaid;
+	const FOodleDataCompression::ECompressionLevel Level = Codec == ESaveCompressionCodec::HighRatio
+		? FOodleDataCompression::ECompressionLevel::Optimal2 : FOodleDataCompression::ECompressionLevel::VeryFast;
+
+	const double CompressStart = FPlatformTime::Seconds();
+	const int64 CompressedBound = FOodleDataCompression::CompressedBufferSizeNeeded(RawData.Num());
+	OutData.SetNumUninitialized(HeaderSize + CompressedBound);
+	const int64 CompressedSize = FOodleDataCompression::Compress(OutData.GetData() + HeaderSize, CompressedBound,
+		RawData.GetData(), RawData.Num(), Compressor, Level);
+	Stats.CompressMs = MsSince(CompressStart);
+
+	// If the compression failed or didn't save anything, store the raw bytes without a header
+	if(CompressedSize <= 0 || HeaderSize + CompressedSize >= RawData.Num())
+	{
+		OutData = MoveTemp(RawData);
+		return;
+	}
+
+	OutData.SetNumUninitialized(HeaderSize + CompressedSize);
+
+	// Write the header over the space reserved at the front of the data
+	uint32 Magic = PayloadMagic;
+	uint8 Version = PayloadVersion;
+	uint8 PayloadCodec = static_cast<uint8>(EPayloadCodec::Oodle);
+	int64 RawSize = RawData.Num();
+	FMemoryWriter HeaderWriter(OutData);
+	HeaderWriter << Magic << Version << PayloadCodec << RawSize;
+}
+
+bool FSavePipeline::DecodePayload(TArray<uint8>& InOutData, FSavePipelineStats& Stats)
+{
+	using namespace SavePipeline;
+	SAVESYSTEM_SCOPE(Decompress);
+
+	if(InOutData.Num() == 0)
+	{
+		return false;
+	}
+
+	Stats.RawBytes = InOutData.Num();
+
+	// Data without a header is plain engine save data
+	if(InOutData.Num() < HeaderSize)
+	{
+		return true;
+	}
+
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	uint8 Codec = 0;
+	int64 RawSize = 0;
+	FMemoryReader HeaderReader(InOutData);
+	HeaderReader << Magic;
+	if(Magic != PayloadMagic)
+	{
+		return true;
+	}
+	HeaderReader << Version << Codec << RawSize;
+
+	// The raw size comes straight from disk, so a corrupt header must not size the decompression buffer past what an array can hold
+	if(Version > PayloadVersion || Codec != static_cast<uint8>(EPayloadCodec::Oodle) || RawSize <= 0 || RawSize > MAX_int32)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Unsupported Save Payload (Version %d, Codec %d)"), Version, Codec);
+		return false;
+	}
+
+	const double DecompressStart = FPlatformTime::Seconds();
+	TArray<uint8> RawData;
+	RawData.SetNumUninitialized(static_cast<int32>(RawSize));
+	if(!FOodleDataCompression::Decompress(RawData.GetData(), RawSize, InOutData.GetData() + HeaderSize, InOutData.Num() - HeaderSize))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to decompress Save Payload"));
+		return false;
+	}
+	Stats.DecompressMs = MsSince(DecompressStart);
+	Stats.RawBytes = RawSize;
+
+	InOutData = MoveTemp(RawData);
+	return true;
+}
+
+USaveGame* FSavePipeline::DeserializePayload(const TArray<uint8>& Data, FSavePipelineStats& Stats)
+{
+	check(IsInGameThread());
+	SAVESYSTEM_SCOPE(Deserialize);
+
+	const double DeserializeStart = FPlatformTime::Seconds();
+	USaveGame* SaveGame = UGameplayStatics::LoadGameFromMemory(Data);
+	Stats.DeserializeMs = SavePipeline::MsSince(DeserializeStart);
+	return SaveGame;
+}
@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Storage/FileSaveStorage.h"
+#include "SaveSystem.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+FFileSaveStorage::FFileSaveStorage(const FString& InDirectory)
+	: Directory(InDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("SaveGames") : InDirectory)
+{
+}
+
+bool FFileSaveStorage::Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SlotPath = GetSlotPath(SlotName, UserIndex);
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(SlotPath));
+
+	// Unique per write, so two writers can never share a temporary file
+	const FString TempPath = SlotPath + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp");
+	{
+		// Flushed before the rename, so the rename can never expose a file whose bytes haven't reached the disk
+		TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*TempPath));
+		if(!FileHandle || !FileHandle->Write(Data.GetData(), Data.Num()) || !FileHandle->Flush(true))
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Failed to write Slot %s to %s"), *SlotName, *TempPath);
+			FileHandle.Reset();
+			PlatformFile.DeleteFile(*TempPath);
+			return false;
+		}
+	}
+
+	// Swap the finished file in, so the Slot is always either the old or the new data and never a partial write. The
+	// temporary file is removed if that fails, as its name is unique and nothing would ever read or clean it up
+	if(!ReplaceFile(SlotPath, TempPath))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to move %s over Slot %s"), *TempPath, *SlotName);
+		PlatformFile.DeleteFile(*TempPath);
+		return false;
+	}
+	return true;
+}
+
+bool FFileSaveStorage::Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SlotPath = GetSlotPath(SlotName, UserIndex);
+	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenRead(*SlotPath));
+	if(!FileHandle)
+	{
+		// A crash in the middle of ReplaceFile leaves the old data in the backup
+		FileHandle.Reset(PlatformFile.OpenRead(*GetBackupPath(SlotPath)));
+	}
+	if(!FileHandle)
+	{
+		return false;
+	}
+
+	const int64 Size = FileHandle->Size();
+	if(Size < 0)
+	{
+		return false;
+	}
+	OutData.SetNumUninitialized(Size);
+	return FileHandle->Read(OutData.GetData(), Size);
+}
+
+bool FFileSaveStorage::Exists(const FString& SlotName, int32 UserIndex)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SlotPath = GetSlotPath(SlotName, UserIndex);
+	return PlatformFile.FileExists(*SlotPath) || PlatformFile.FileExists(*GetBackupPath(SlotPath));
+}
+
+bool FFileSaveStorage::Delete(const FString& SlotName, int32 UserIndex)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SlotPath = GetSlotPath(SlotName, UserIndex);
+	const bool bDeletedBackup = PlatformFile.DeleteFile(*GetBackupPath(SlotPath));
+	return PlatformFile.DeleteFile(*SlotPath) || bDeletedBackup;
+}
+
+bool FFileSaveStorage::GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames)
+{
+	const FString SlotDirectory = FPaths::GetPath(GetSlotPath(TEXT("Slot"), UserIndex));
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryStat(*SlotDirectory,
+		[&OutSlotNames, &Since](const TCHAR* FileName, const FFileStatData& StatData)
+		{
+			if(!StatData.bIsDirectory && FPaths::GetExtension(FileName) == TEXT("sav") && StatData.ModificationTime >= Since)
+			{
+				OutSlotNames.Add(FPaths::GetBaseFilename(FileName));
+			}
+			return true;
+		});
+	return true;
+}
+
+FString FFileSaveStorage::GetSlotPath(const FString& SlotName, int32 UserIndex) const
+{
+	// User 0 uses the same path as the engine, other users get a directory each
+	const FString FileName = SlotName + TEXT(".sav");
+	return UserIndex == 0 ? Directory / FileName : Directory / FString::Printf(TEXT("User%d"), UserIndex) / FileName;
+}
+
+bool FFileSaveStorage::ReplaceFile(const FString& Path, const FString& TempPath)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// Platforms that rename over an existing file replace it in a single step
+	if(PlatformFile.MoveFile(*Path, *TempPath))
+	{
+		PlatformFile.DeleteFile(*GetBackupPath(Path));
+		return true;
+	}
+	if(!PlatformFile.FileExists(*Path))
+	{
+		return false;
+	}
+
+	// Everywhere else the old file is moved aside rather than deleted, so there is a complete copy on disk at all times
+	const FString BackupPath = GetBackupPath(Path);
+	PlatformFile.DeleteFile(*BackupPath);
+	if(!PlatformFile.MoveFile(*BackupPath, *Path))
+	{
+		return false;
+	}
+	if(!PlatformFile.MoveFile(*Path, *TempPath))
+	{
+		PlatformFile.MoveFile(*Path, *BackupPath);
+		return false;
+	}
+	PlatformFile.DeleteFile(*BackupPath);
+	return true;
+}
+
+FString FFileSaveStorage::GetBackupPath(const FString& Path)
+{
+	return Path + TEXT(".bak");
+}
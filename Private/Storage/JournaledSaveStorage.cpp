@@ -0,0 +1,454 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Storage/JournaledSaveStorage.h"
+#include "SaveSystem.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Storage/FileSaveStorage.h"
+
+namespace JournaledSaveStorage
+{
+	// 'SSJH' and 'SSJR'
+	static constexpr uint32 HeaderMagic = 0x484A5353;
+	static constexpr uint32 RecordMagic = 0x524A5353;
+	static constexpr uint32 JournalVersion = 1;
+
+	// Magic + Version + Checkpoint Size + Checkpoint CRC
+	static constexpr int32 HeaderSize = sizeof(uint32) + sizeof(uint32) + sizeof(int32) + sizeof(uint32);
+
+	// Magic + Body Size + Body CRC
+	static constexpr int32 RecordHeaderSize = sizeof(uint32) + sizeof(int32) + sizeof(uint32);
+
+	// Unchanged runs shorter than this are folded into the surrounding range, as a new range costs 8 bytes anyway
+	static constexpr int32 MergeGap = 16;
+
+	// Unchanged blocks are skipped with a memcmp before looking at single bytes
+	static constexpr int32 CompareBlock = 64;
+
+	/**
+	 * Encodes the changes from Old to New as a record body: the sequence number, the new size, and every changed range
+	 */
+	static TArray<uint8> MakeRecordBody(const TArray<uint8>& Old, const TArray<uint8>& New, int32 Sequence)
+	{
+		TArray<TPair<int32, int32>> Ranges;
+		const int32 CommonSize = FMath::Min(Old.Num(), New.Num());
+		int32 Index = 0;
+		while(Index < CommonSize)
+		{
+			if(Index + CompareBlock <= CommonSize && FMemory::Memcmp(Old.GetData() + Index, New.GetData() + Index, CompareBlock) == 0)
+			{
+				Index += CompareBlock;
+				continue;
+			}
+			if(Old[Index] == New[Index])
+			{
+				Index++;
+				continue;
+			}
+
+			// Grow the range until it is followed by at least MergeGap unchanged bytes
+			const int32 Start = Index;
+			int32 End = Index + 1;
+			int32 Scan = End;
+			while(Scan < CommonSize && Scan - End < MergeGap)
+			{
+				if(Old[Scan] != New[Scan])
+				{
+					End = Scan + 1;
+				}
+				Scan++;
+			}
+			Ranges.Emplace(Start, End - Start);
+			Index = Scan;
+		}
+		if(New.Num() > CommonSize)
+		{
+			Ranges.Emplace(CommonSize, New.Num() - CommonSize);
+		}
+
+		TArray<uint8> Body;
+		FMemoryWriter Writer(Body);
+		int32 NewSize = New.Num();
+		int32 NumRanges = Ranges.Num();
+		Writer << Sequence << NewSize << NumRanges;
+		for(TPair<int32, int32>& Range : Ranges)
+		{
+			Writer << Range.Key << Range.Value;
+			Writer.Serialize(const_cast<uint8*>(New.GetData() + Range.Key), Range.Value);
+		}
+		return Body;
+	}
+
+	/**
+	 * Applies a record body to the contents of a Slot
+	 * @return If the body was well formed and followed on from the expected sequence number
+	 */
+	static bool ApplyRecordBody(TArrayView<const uint8> Body, int32 ExpectedSequence, TArray<uint8>& InOutContents)
+	{
+		FMemoryReaderView Reader(Body);
+		int32 Sequence = 0;
+		int32 NewSize = 0;
+		int32 NumRanges = 0;
+		Reader << Sequence << NewSize << NumRanges;
+		if(Reader.IsError() || Sequence != ExpectedSequence || NewSize < 0 || NumRanges < 0)
+		{
+			return false;
+		}
+
+		TArray<uint8> Contents = InOutContents;
+		Contents.SetNumZeroed(NewSize);
+		for(int32 RangeIndex = 0; RangeIndex < NumRanges; RangeIndex++)
+		{
+			int32 Offset = 0;
+			int32 Length = 0;
+			Reader << Offset << Length;
+			if(Reader.IsError() || Offset < 0 || Length < 0 || Offset + Length > NewSize || Reader.Tell() + Length > Body.Num())
+			{
+				return false;
+			}
+			Reader.Serialize(Contents.GetData() + Offset, Length);
+		}
+
+		InOutContents = MoveTemp(Contents);
+		return true;
+	}
+}
+
+FJournaledSaveStorage::FJournaledSaveStorage(const FString& InDirectory, int32 InMaxJournalRecords, float InMaxJournalRatio)
+	: Directory(InDirectory.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("SaveGames") : InDirectory)
+	, MaxJournalRecords(FMath::Max(InMaxJournalRecords, 1))
+	, MaxJournalRatio(FMath::Max(InMaxJournalRatio, 0.f))
+{
+}
+
+FJournaledSaveStorage::~FJournaledSaveStorage()
+{
+	CheckpointAll();
+}
+
+bool FJournaledSaveStorage::Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data)
+{
+	const TSharedRef<FSlotJournal> Slot = FindOrAddSlot(SlotName, UserIndex);
+	FScopeLock ScopeLock(&Slot->Lock);
+
+	// Anything that can't be appended safely starts a new checkpoint instead
+	if(!Slot->bLoaded && !LoadSlot(*Slot))
+	{
+		return WriteCheckpoint(*Slot, Data);
+	}
+	if(Slot->bJournalTorn || Slot->JournalRecords >= MaxJournalRecords)
+	{
+		return WriteCheckpoint(*Slot, Data);
+	}
+
+	const TArray<uint8> Body = JournaledSaveStorage::MakeRecordBody(Slot->Contents, Data, Slot->JournalRecords);
+	const int32 JournalBytesAfter = FMath::Max(Slot->JournalBytes, JournaledSaveStorage::HeaderSize) + JournaledSaveStorage::RecordHeaderSize + Body.Num();
+	if(JournalBytesAfter > MaxJournalRatio * Data.Num())
+	{
+		return WriteCheckpoint(*Slot, Data);
+	}
+
+	TArray<uint8> Record;
+	Record.Reserve(JournaledSaveStorage::HeaderSize + JournaledSaveStorage::RecordHeaderSize + Body.Num());
+	FMemoryWriter Writer(Record);
+	if(Slot->JournalBytes == 0)
+	{
+		// The journal starts with the checkpoint it applies to, so a journal left over from an older one is never replayed
+		uint32 Magic = JournaledSaveStorage::HeaderMagic;
+		uint32 Version = JournaledSaveStorage::JournalVersion;
+		Writer << Magic << Version << Slot->CheckpointSize << Slot->CheckpointCrc;
+	}
+	uint32 Magic = JournaledSaveStorage::RecordMagic;
+	int32 BodySize = Body.Num();
+	uint32 BodyCrc = FCrc::MemCrc32(Body.GetData(), Body.Num());
+	Writer << Magic << BodySize << BodyCrc;
+	Writer.Serialize(const_cast<uint8*>(Body.GetData()), Body.Num());
+
+	if(!AppendRecord(*Slot, Record))
+	{
+		return false;
+	}
+	Slot->Contents = Data;
+	return true;
+}
+
+bool FJournaledSaveStorage::Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData)
+{
+	const TSharedRef<FSlotJournal> Slot = FindOrAddSlot(SlotName, UserIndex);
+	FScopeLock ScopeLock(&Slot->Lock);
+	if(!Slot->bLoaded && !LoadSlot(*Slot))
+	{
+		return false;
+	}
+
+	OutData = Slot->Contents;
+	return true;
+}
+
+bool FJournaledSaveStorage::Exists(const FString& SlotName, int32 UserIndex)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString SlotPath = GetSlotPath(SlotName, UserIndex);
+	return PlatformFile.FileExists(*SlotPath) || PlatformFile.FileExists(*FFileSaveStorage::GetBackupPath(SlotPath));
+}
+
+bool FJournaledSaveStorage::Delete(const FString& SlotName, int32 UserIndex)
+{
+	const TSharedRef<FSlotJournal> Slot = FindOrAddSlot(SlotName, UserIndex);
+	FScopeLock ScopeLock(&Slot->Lock);
+
+	// The journal goes first, so a crash in between can't leave it behind to be replayed on a future checkpoint
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.DeleteFile(*GetJournalPath(SlotName, UserIndex));
+	const FString SlotPath = GetSlotPath(SlotName, UserIndex);
+	const bool bDeletedBackup = PlatformFile.DeleteFile(*FFileSaveStorage::GetBackupPath(SlotPath));
+	const bool bDeleted = PlatformFile.DeleteFile(*SlotPath) || bDeletedBackup;
+
+	Slot->bLoaded = false;
+	Slot->Contents.Empty();
+	Slot->JournalBytes = 0;
+	Slot->JournalRecords = 0;
+	Slot->bJournalTorn = false;
+	return bDeleted;
+}
+
+bool FJournaledSaveStorage::GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames)
+{
+	const FString SlotDirectory = FPaths::GetPath(GetSlotPath(TEXT("Slot"), UserIndex));
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectoryStat(*SlotDirectory,
+		[&OutSlotNames, &Since](const TCHAR* FileName, const FFileStatData& StatData)
+		{
+			const FString Extension = FPaths::GetExtension(FileName);
+			if(!StatData.bIsDirectory && (Extension == TEXT("sav") || Extension == TEXT("journal")) && StatData.ModificationTime >= Since)
+			{
+				OutSlotNames.AddUnique(FPaths::GetBaseFilename(FileName));
+			}
+			return true;
+		});
+	return true;
+}
+
+bool FJournaledSaveStorage::Checkpoint(const FString& SlotName, int32 UserIndex)
+{
+	const TSharedRef<FSlotJournal> Slot = FindOrAddSlot(SlotName, UserIndex);
+	FScopeLock ScopeLock(&Slot->Lock);
+	if(!Slot->bLoaded && !LoadSlot(*Slot))
+	{
+		return true;
+	}
+	if(Slot->JournalBytes == 0 && !Slot->bJournalTorn)
+	{
+		return true;
+	}
+
+	const TArray<uint8> Contents = Slot->Contents;
+	return WriteCheckpoint(*Slot, Contents);
+}
+
+void FJournaledSaveStorage::CheckpointAll()
+{
+	TArray<TSharedRef<FSlotJournal>> SlotsToCheckpoint;
+	{
+		FScopeLock ScopeLock(&SlotsLock);
+		Slots.GenerateValueArray(SlotsToCheckpoint);
+	}
+
+	int32 Checkpointed = 0;
+	for(const TSharedRef<FSlotJournal>& Slot : SlotsToCheckpoint)
+	{
+		FScopeLock ScopeLock(&Slot->Lock);
+		if(Slot->bLoaded && Slot->JournalBytes > 0)
+		{
+			const TArray<uint8> Contents = Slot->Contents;
+			Checkpointed += WriteCheckpoint(*Slot, Contents) ? 1 : 0;
+		}
+	}
+	if(Checkpointed > 0)
+	{
+		UE_LOG(LogSaveSystem, Display, TEXT("Folded the journals of %d Slots into checkpoints"), Checkpointed);
+	}
+}
+
+FString FJournaledSaveStorage::GetSlotPath(const FString& SlotName, int32 UserIndex) const
+{
+	// Same layout as the File backend, so checkpoints are interchangeable with its Slots
+	const FString FileName = SlotName + TEXT(".sav");
+	return UserIndex == 0 ? Directory / FileName : Directory / FString::Printf(TEXT("User%d"), UserIndex) / FileName;
+}
+
+FString FJournaledSaveStorage::GetJournalPath(const FString& SlotName, int32 UserIndex) const
+{
+	return FPaths::ChangeExtension(GetSlotPath(SlotName, UserIndex), TEXT("journal"));
+}
+
+TSharedRef<FJournaledSaveStorage::FSlotJournal> FJournaledSaveStorage::FindOrAddSlot(const FString& SlotName, int32 UserIndex)
+{
+	FScopeLock ScopeLock(&SlotsLock);
+	const FString Key = MakeKey(SlotName, UserIndex);
+	if(const TSharedRef<FSlotJournal>* Slot = Slots.Find(Key))
+	{
+		return *Slot;
+	}
+	return Slots.Add(Key, MakeShared<FSlotJournal>(SlotName, UserIndex));
+}
+
+bool FJournaledSaveStorage::LoadSlot(FSlotJournal& Slot)
+{
+	// A crash in the middle of replacing the checkpoint leaves the old one in the backup, which the journal still matches
+	TArray<uint8> Checkpoint;
+	const FString SlotPath = GetSlotPath(Slot.SlotName, Slot.UserIndex);
+	if(!FFileHelper::LoadFileToArray(Checkpoint, *SlotPath, FILEREAD_Silent)
+		&& !FFileHelper::LoadFileToArray(Checkpoint, *FFileSaveStorage::GetBackupPath(SlotPath), FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	Slot.bLoaded = true;
+	Slot.CheckpointSize = Checkpoint.Num();
+	Slot.CheckpointCrc = FCrc::MemCrc32(Checkpoint.GetData(), Checkpoint.Num());
+	Slot.Contents = MoveTemp(Checkpoint);
+	Slot.JournalBytes = 0;
+	Slot.JournalRecords = 0;
+	Slot.bJournalTorn = false;
+
+	TArray<uint8> Journal;
+	if(!FFileHelper::LoadFileToArray(Journal, *GetJournalPath(Slot.SlotName, Slot.UserIndex), FILEREAD_Silent) || Journal.Num() == 0)
+	{
+		return true;
+	}
+
+	FMemoryReader Reader(Journal);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 CheckpointSize = 0;
+	uint32 CheckpointCrc = 0;
+	Reader << Magic << Version << CheckpointSize << CheckpointCrc;
+	if(Reader.IsError() || Magic != JournaledSaveStorage::HeaderMagic || Version > JournaledSaveStorage::JournalVersion
+		|| CheckpointSize != Slot.CheckpointSize || CheckpointCrc != Slot.CheckpointCrc)
+	{
+		// Left over from an older checkpoint, or torn before its first record was complete. The next write replaces it
+		UE_LOG(LogSaveSystem, Display, TEXT("Ignoring a stale journal for Slot %s"), *Slot.SlotName);
+		return true;
+	}
+
+	int32 Offset = JournaledSaveStorage::HeaderSize;
+	while(Offset + JournaledSaveStorage::RecordHeaderSize <= Journal.Num())
+	{
+		Reader.Seek(Offset);
+		uint32 RecordMagic = 0;
+		int32 BodySize = 0;
+		uint32 BodyCrc = 0;
+		Reader << RecordMagic << BodySize << BodyCrc;
+		const int32 BodyOffset = Offset + JournaledSaveStorage::RecordHeaderSize;
+		if(RecordMagic != JournaledSaveStorage::RecordMagic || BodySize < 0 || BodySize > Journal.Num() - BodyOffset)
+		{
+			break;
+		}
+
+		const TArrayView<const uint8> Body(Journal.GetData() + BodyOffset, BodySize);
+		if(FCrc::MemCrc32(Body.GetData(), Body.Num()) != BodyCrc
+			|| !JournaledSaveStorage::ApplyRecordBody(Body, Slot.JournalRecords, Slot.Contents))
+		{
+			break;
+		}
+
+		Offset = BodyOffset + BodySize;
+		Slot.JournalRecords++;
+	}
+	Slot.JournalBytes = Offset;
+
+	// Whatever follows the last good record was cut off by a crash. Appending after it would hide the new records from
+	// the next read, so the next write checkpoints instead
+	if(Offset < Journal.Num())
+	{
+		UE_LOG(LogSaveSystem, Warning, TEXT("Journal for Slot %s ends in a torn record, recovered %d records and dropped %d bytes"),
+			*Slot.SlotName, Slot.JournalRecords, Journal.Num() - Offset);
+		Slot.bJournalTorn = true;
+	}
+	return true;
+}
+
+bool FJournaledSaveStorage::WriteCheckpoint(FSlotJournal& Slot, const TArray<uint8>& Data)
+{
+	if(!WriteFileAtomic(GetSlotPath(Slot.SlotName, Slot.UserIndex), Data))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to write a checkpoint for Slot %s"), *Slot.SlotName);
+		return false;
+	}
+
+	// Once the checkpoint is in place the old journal no longer matches it, so a crash before this delete is harmless
+	FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*GetJournalPath(Slot.SlotName, Slot.UserIndex));
+
+	Slot.bLoaded = true;
+	Slot.CheckpointSize = Data.Num();
+	Slot.CheckpointCrc = FCrc::MemCrc32(Data.GetData(), Data.Num());
+	if(&Slot.Contents != &Data)
+	{
+		Slot.Contents = Data;
+	}
+	Slot.JournalBytes = 0;
+	Slot.JournalRecords = 0;
+	Slot.bJournalTorn = false;
+	return true;
+}
+
+bool FJournaledSaveStorage::AppendRecord(FSlotJournal& Slot, const TArray<uint8>& Record)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString JournalPath = GetJournalPath(Slot.SlotName, Slot.UserIndex);
+
+	// A new journal replaces whatever stale one is on disk, an existing one is only ever appended to
+	TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*JournalPath, Slot.JournalBytes > 0));
+	const bool bWritten = FileHandle && FileHandle->Write(Record.GetData(), Record.Num()) && FileHandle->Flush(true);
+	FileHandle.Reset();
+	if(!bWritten)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to append to the journal of Slot %s"), *Slot.SlotName);
+		Slot.bJournalTorn = true;
+		return false;
+	}
+
+	BytesWritten.fetch_add(Record.Num(), std::memory_order_relaxed);
+	Slot.JournalBytes = Slot.JournalBytes > 0 ? Slot.JournalBytes + Record.Num() : Record.Num();
+	Slot.JournalRecords++;
+	return true;
+}
+
+bool FJournaledSaveStorage::WriteFileAtomic(const FString& Path, const TArray<uint8>& Data)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+
+	const FString TempPath = Path + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp");
+	{
+		// Flushed before the rename, so the rename can never expose a file whose bytes haven't reached the disk
+		TUniquePtr<IFileHandle> FileHandle(PlatformFile.OpenWrite(*TempPath));
+		if(!FileHandle || !FileHandle->Write(Data.GetData(), Data.Num()) || !FileHandle->Flush(true))
+		{
+			FileHandle.Reset();
+			PlatformFile.DeleteFile(*TempPath);
+			return false;
+		}
+	}
+
+	// The old checkpoint stays in place, or in its backup, until the new one has replaced it
+	if(!FFileSaveStorage::ReplaceFile(Path, TempPath))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to move %s over %s"), *TempPath, *Path);
+		return false;
+	}
+	BytesWritten.fetch_add(Data.Num(), std::memory_order_relaxed);
+	return true;
+}
+
+FString FJournaledSaveStorage::MakeKey(const FString& SlotName, int32 UserIndex)
+{
+	return FString::Printf(TEXT("%d/%s"), UserIndex, *SlotName);
+}
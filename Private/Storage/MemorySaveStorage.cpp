@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Storage/MemorySaveStorage.h"
+#include "Misc/ScopeRWLock.h"
+
+bool FMemorySaveStorage::Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data)
+{
+	FWriteScopeLock ScopeLock(Lock);
+	Slots.Add(MakeKey(SlotName, UserIndex), Data);
+	return true;
+}
+
+bool FMemorySaveStorage::Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData)
+{
+	FReadScopeLock ScopeLock(Lock);
+	const TArray<uint8>* Data = Slots.Find(MakeKey(SlotName, UserIndex));
+	if(!Data)
+	{
+		return false;
+	}
+
+	OutData = *Data;
+	return true;
+}
+
+bool FMemorySaveStorage::Exists(const FString& SlotName, int32 UserIndex)
+{
+	FReadScopeLock ScopeLock(Lock);
+	return Slots.Contains(MakeKey(SlotName, UserIndex));
+}
+
+bool FMemorySaveStorage::Delete(const FString& SlotName, int32 UserIndex)
+{
+	FWriteScopeLock ScopeLock(Lock);
+	return Slots.Remove(MakeKey(SlotName, UserIndex)) > 0;
+}
+
+void FMemorySaveStorage::Reset()
+{
+	FWriteScopeLock ScopeLock(Lock);
+	Slots.Empty();
+}
+
+int64 FMemorySaveStorage::GetStoredBytes() const
+{
+	FReadScopeLock ScopeLock(Lock);
+	int64 StoredBytes = 0;
+	for(const TPair<FString, TArray<uint8>>& Slot : Slots)
+	{
+		StoredBytes += Slot.Value.Num();
+	}
+	return StoredBytes;
+}
+
+FString FMemorySaveStorage::MakeKey(const FString& SlotName, int32 UserIndex)
+{
+	return FString::Printf(TEXT("%d/%s"), UserIndex, *SlotName);
+}
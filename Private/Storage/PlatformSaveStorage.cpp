@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Storage/PlatformSaveStorage.h"
+#include "PlatformFeatures.h"
+#include "SaveGameSystem.h"
+
+FPlatformSaveStorage::FPlatformSaveStorage()
+{
+	SaveGameSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+}
+
+bool FPlatformSaveStorage::Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data)
+{
+	return SaveGameSystem && SaveGameSystem->SaveGame(false, *SlotName, UserIndex, Data);
+}
+
+bool FPlatformSaveStorage::Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData)
+{
+	return SaveGameSystem && SaveGameSystem->LoadGame(false, *SlotName, UserIndex, OutData);
+}
+
+bool FPlatformSaveStorage::Exists(const FString& SlotName, int32 UserIndex)
+{
+	return SaveGameSystem && SaveGameSystem->DoesSaveGameExist(*SlotName, UserIndex);
+}
+
+bool FPlatformSaveStorage::Delete(const FString& SlotName, int32 UserIndex)
+{
+	return SaveGameSystem && SaveGameSystem->DeleteGame(false, *SlotName, UserIndex);
+}
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Storage/SQLiteSaveStorage.h"
+
+#if WITH_SAVESYSTEM_SQLITE
+
+#include "SaveSystem.h"
+#include "SQLiteDatabase.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace SQLiteSaveStorage
+{
+	static TUniquePtr<FSQLitePreparedStatement> Prepare(FSQLiteDatabase& Database, const TCHAR* Statement)
+	{
+		TUniquePtr<FSQLitePreparedStatement> PreparedStatement = MakeUnique<FSQLitePreparedStatement>(
+			Database.PrepareStatement(Statement, ESQLitePreparedStatementFlags::Persistent));
+		if(!PreparedStatement->IsValid())
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Failed to prepare SQLite statement: %s"), *Database.GetLastError());
+		}
+		return PreparedStatement;
+	}
+
+	/**
+	 * Returns the statement to a clean state when leaving scope, however the caller exits
+	 */
+	struct FScopedStatementReset
+	{
+		explicit FScopedStatementReset(FSQLitePreparedStatement& InStatement) : Statement(InStatement) {}
+		~FScopedStatementReset()
+		{
+			Statement.Reset();
+			Statement.ClearBindings();
+		}
+		FSQLitePreparedStatement& Statement;
+	};
+}
+
+FSQLiteSaveStorage::FSQLiteSaveStorage(const FString& InDatabasePath)
+{
+	using namespace SQLiteSaveStorage;
+
+	const FString DatabasePath = InDatabasePath.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("SaveGames") / TEXT("Slots.db") : InDatabasePath;
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(DatabasePath));
+
+	Database = MakeUnique<FSQLiteDatabase>();
+	if(!Database->Open(*DatabasePath, ESQLiteDatabaseOpenMode::ReadWriteCreate))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to open the SQLite Slot database %s: %s"), *DatabasePath, *Database->GetLastError());
+		Database.Reset();
+		return;
+	}
+
+	// WAL lets reads carry on while a write is committing, and NORMAL sync is still safe against corruption in WAL mode
+	Database->Execute(TEXT("PRAGMA journal_mode=WAL;"));
+	Database->Execute(TEXT("PRAGMA synchronous=NORMAL;"));
+	Database->Execute(TEXT("CREATE TABLE IF NOT EXISTS Slots(UserIndex INTEGER NOT NULL, SlotName TEXT NOT NULL, Data BLOB NOT NULL, ModifiedTicks INTEGER NOT NULL, PRIMARY KEY(UserIndex, SlotName)) WITHOUT ROWID;"));
+	Database->Execute(TEXT("CREATE INDEX IF NOT EXISTS SlotsByModified ON Slots(UserIndex, ModifiedTicks);"));
+
+	WriteStatement = Prepare(*Database, TEXT("INSERT OR REPLACE INTO Slots(UserIndex, SlotName, Data, ModifiedTicks) VALUES(?1, ?2, ?3, ?4);"));
+	ReadStatement = Prepare(*Database, TEXT("SELECT Data FROM Slots WHERE UserIndex = ?1 AND SlotName = ?2;"));
+	ExistsStatement = Prepare(*Database, TEXT("SELECT 1 FROM Slots WHERE UserIndex = ?1 AND SlotName = ?2;"));
+	DeleteStatement = Prepare(*Database, TEXT("DELETE FROM Slots WHERE UserIndex = ?1 AND SlotName = ?2;"));
+	ModifiedSinceStatement = Prepare(*Database, TEXT("SELECT SlotName FROM Slots WHERE UserIndex = ?1 AND ModifiedTicks >= ?2;"));
+}
+
+FSQLiteSaveStorage::~FSQLiteSaveStorage()
+{
+	// Statements have to be destroyed before the database they were prepared against is closed
+	WriteStatement.Reset();
+	ReadStatement.Reset();
+	ExistsStatement.Reset();
+	DeleteStatement.Reset();
+	ModifiedSinceStatement.Reset();
+
+	if(Database)
+	{
+		Database->Close();
+	}
+}
+
+bool FSQLiteSaveStorage::IsOpen() const
+{
+	return Database.IsValid();
+}
+
+bool FSQLiteSaveStorage::Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data)
+{
+	FScopeLock ScopeLock(&Lock);
+	return IsOpen() && WriteLocked(SlotName, UserIndex, Data, FDateTime::UtcNow().GetTicks());
+}
+
+bool FSQLiteSaveStorage::Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData)
+{
+	FScopeLock ScopeLock(&Lock);
+	if(!IsOpen())
+	{
+		return false;
+	}
+
+	SQLiteSaveStorage::FScopedStatementReset ScopedReset(*ReadStatement);
+	ReadStatement->SetBindingValueByIndex(1, static_cast<int64>(UserIndex));
+	ReadStatement->SetBindingValueByIndex(2, SlotName);
+	return ReadStatement->Step() == ESQLitePreparedStatementStepResult::Row && ReadStatement->GetColumnValueByIndex(0, OutData);
+}
+
+bool FSQLiteSaveStorage::Exists(const FString& SlotName, int32 UserIndex)
+{
+	FScopeLock ScopeLock(&Lock);
+	if(!IsOpen())
+	{
+		return false;
+	}
+
+	SQLiteSaveStorage::FScopedStatementReset ScopedReset(*ExistsStatement);
+	ExistsStatement->SetBindingValueByIndex(1, static_cast<int64>(UserIndex));
+	ExistsStatement->SetBindingValueByIndex(2, SlotName);
+	return ExistsStatement->Step() == ESQLitePreparedStatementStepResult::Row;
+}
+
+bool FSQLiteSaveStorage::Delete(const FString& SlotName, int32 UserIndex)
+{
+	FScopeLock ScopeLock(&Lock);
+	if(!IsOpen())
+	{
+		return false;
+	}
+
+	// Report whether there was a Slot to delete, the same as the other backends
+	{
+		SQLiteSaveStorage::FScopedStatementReset ScopedReset(*ExistsStatement);
+		ExistsStatement->SetBindingValueByIndex(1, static_cast<int64>(UserIndex));
+		ExistsStatement->SetBindingValueByIndex(2, SlotName);
+		if(ExistsStatement->Step() != ESQLitePreparedStatementStepResult::Row)
+		{
+			return false;
+		}
+	}
+
+	SQLiteSaveStorage::FScopedStatementReset ScopedReset(*DeleteStatement);
+	DeleteStatement->SetBindingValueByIndex(1, static_cast<int64>(UserIndex));
+	DeleteStatement->SetBindingValueByIndex(2, SlotName);
+	return DeleteStatement->Step() == ESQLitePreparedStatementStepResult::Done;
+}
+
+bool FSQLiteSaveStorage::WriteBatch(const TArray<TPair<FString, TArray<uint8>>>& Slots, int32 UserIndex)
+{
+	FScopeLock ScopeLock(&Lock);
+	if(!IsOpen())
+	{
+		return false;
+	}
+
+	// One transaction for the whole batch, which is both atomic and far cheaper than committing each Slot on its own
+	if(!Database->Execute(TEXT("BEGIN IMMEDIATE;")))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to begin SQLite Slot batch: %s"), *Database->GetLastError());
+		return false;
+	}
+
+	const int64 ModifiedTicks = FDateTime::UtcNow().GetTicks();
+	for(const TPair<FString, TArray<uint8>>& Slot : Slots)
+	{
+		if(!WriteLocked(Slot.Key, UserIndex, Slot.Value, ModifiedTicks))
+		{
+			Database->Execute(TEXT("ROLLBACK;"));
+			return false;
+		}
+	}
+
+	if(!Database->Execute(TEXT("COMMIT;")))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to commit SQLite Slot batch: %s"), *Database->GetLastError());
+		Database->Execute(TEXT("ROLLBACK;"));
+		return false;
+	}
+	return true;
+}
+
+bool FSQLiteSaveStorage::GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames)
+{
+	FScopeLock ScopeLock(&Lock);
+	if(!IsOpen())
+	{
+		return false;
+	}
+
+	SQLiteSaveStorage::FScopedStatementReset ScopedReset(*ModifiedSinceStatement);
+	ModifiedSinceStatement->SetBindingValueByIndex(1, static_cast<int64>(UserIndex));
+	ModifiedSinceStatement->SetBindingValueByIndex(2, Since.GetTicks());
+	while(ModifiedSinceStatement->Step() == ESQLitePreparedStatementStepResult::Row)
+	{
+		FString SlotName;
+		ModifiedSinceStatement->GetColumnValueByIndex(0, SlotName);
+		OutSlotNames.Add(MoveTemp(SlotName));
+	}
+	return true;
+}
+
+bool FSQLiteSaveStorage::WriteLocked(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data, int64 ModifiedTicks)
+{
+	SQLiteSaveStorage::FScopedStatementReset ScopedReset(*WriteStatement);
+	WriteStatement->SetBindingValueByIndex(1, static_cast<int64>(UserIndex));
+	WriteStatement->SetBindingValueByIndex(2, SlotName);
+	WriteStatement->SetBindingValueByIndex(3, TArrayView<const uint8>(Data), false);
+	WriteStatement->SetBindingValueByIndex(4, ModifiedTicks);
+	if(WriteStatement->Step() != ESQLitePreparedStatementStepResult::Done)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to write Slot %s to SQLite: %s"), *SlotName, *Database->GetLastError());
+		return false;
+	}
+	return true;
+}
+
+#endif
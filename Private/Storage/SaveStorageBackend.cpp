@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Storage/SaveStorageBackend.h"
+#include "SaveSystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "Storage/FileSaveStorage.h"
+#include "Storage/JournaledSaveStorage.h"
+#include "Storage/MemorySaveStorage.h"
+#include "Storage/PlatformSaveStorage.h"
+#include "Storage/SQLiteSaveStorage.h"
+
+namespace SaveStorage
+{
+	static FCriticalSection BackendLock;
+	static TSharedPtr<ISaveStorageBackend> ActiveBackend;
+}
+
+bool ISaveStorageBackend::WriteBatch(const TArray<TPair<FString, TArray<uint8>>>& Slots, int32 UserIndex)
+{
+	bool bSuccess = true;
+	for(const TPair<FString, TArray<uint8>>& Slot : Slots)
+	{
+		bSuccess &= Write(Slot.Key, UserIndex, Slot.Value);
+	}
+	return bSuccess;
+}
+
+TSharedRef<ISaveStorageBackend> FSaveStorage::Get()
+{
+	FScopeLock ScopeLock(&SaveStorage::BackendLock);
+	if(!SaveStorage::ActiveBackend.IsValid())
+	{
+		SaveStorage::ActiveBackend = CreateDefaultBackend();
+		UE_LOG(LogSaveSystem, Display, TEXT("Using the %s Save Storage Backend"), SaveStorage::ActiveBackend->GetName());
+	}
+	return SaveStorage::ActiveBackend.ToSharedRef();
+}
+
+void FSaveStorage::SetBackend(TSharedPtr<ISaveStorageBackend> Backend)
+{
+	FScopeLock ScopeLock(&SaveStorage::BackendLock);
+
+	// Anything already in flight keeps its own reference to the old backend, so it can be swapped at any time
+	SaveStorage::ActiveBackend = Backend.IsValid() ? Backend : TSharedPtr<ISaveStorageBackend>(CreateDefaultBackend());
+	UE_LOG(LogSaveSystem, Display, TEXT("Switched to the %s Save Storage Backend"), SaveStorage::ActiveBackend->GetName());
+}
+
+TSharedRef<ISaveStorageBackend> FSaveStorage::CreateDefaultBackend()
+{
+#if PLATFORM_DESKTOP
+	return MakeShared<FFileSaveStorage>();
+#else
+	return MakeShared<FPlatformSaveStorage>();
+#endif
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommand SetStorageBackendCommand(
+	TEXT("SaveSystem.Storage.SetBackend"),
+	TEXT("Switch the Save Storage Backend. Usage: SaveSystem.Storage.SetBackend <File|Journal|Memory|Platform|SQLite|Default>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const FString Name = Args.Num() > 0 ? Args[0] : FString();
+		if(Name.Equals(TEXT("File"), ESearchCase::IgnoreCase))
+		{
+			FSaveStorage::SetBackend(MakeShared<FFileSaveStorage>());
+		}
+		else if(Name.Equals(TEXT("Journal"), ESearchCase::IgnoreCase))
+		{
+			FSaveStorage::SetBackend(MakeShared<FJournaledSaveStorage>());
+		}
+		else if(Name.Equals(TEXT("Memory"), ESearchCase::IgnoreCase))
+		{
+			FSaveStorage::SetBackend(MakeShared<FMemorySaveStorage>());
+		}
+		else if(Name.Equals(TEXT("Platform"), ESearchCase::IgnoreCase))
+		{
+			FSaveStorage::SetBackend(MakeShared<FPlatformSaveStorage>());
+		}
+#if WITH_SAVESYSTEM_SQLITE
+		else if(Name.Equals(TEXT("SQLite"), ESearchCase::IgnoreCase))
+		{
+			FSaveStorage::SetBackend(MakeShared<FSQLiteSaveStorage>());
+		}
+#endif
+		else
+		{
+			FSaveStorage::SetBackend(nullptr);
+		}
+	}));
+
+#endif
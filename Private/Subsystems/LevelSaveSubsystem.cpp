@@ -3,8 +3,38 @@
 
 #include "Subsystems/LevelSaveSubsystem.h"
 #include "SaveSystem.h"
+#include "SaveSystemLog.h"
+#include "SaveSystemStats.h"
+#include "EngineUtils.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
 #include "Interfaces/LevelSaveInterface.h"
 #include "Kismet/GameplayStatics.h"
+#include "Storage/SaveStorageBackend.h"
+#include "Subsystems/LevelStateCacheSubsystem.h"
+#include "Async/TaskGraphInterfaces.h"
+
+namespace LevelSaveSubsystem
+{
+	// The longest teardown waits for cells that are loading or being written before writing the rest
+	static constexpr double ShutdownWriteTimeoutSeconds = 10.0;
+
+	/**
+	 * @brief Whether an Actor can have saved state. Moved Actors don't have to implement the interface, but only Movable
+	 * ones can have been moved
+	 */
+	static bool IsSaveableActor(const AActor* Actor, bool bIncludeMovableActors)
+	{
+		if(!IsValid(Actor))
+		{
+			return false;
+		}
+
+		const bool bMovable = bIncludeMovableActors && Actor->GetRootComponent() && Actor->GetRootComponent()->Mobility == EComponentMobility::Movable;
+		return bMovable || Actor->Implements<ULevelSaveInterface>();
+	}
+}
 
 ULevelSaveSubsystem::ULevelSaveSubsystem()
 {
@@ -16,93 +46,1068 @@ void ULevelSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 	LevelSaveSlot = GetWorld()->GetFName().ToString();
 
-	UE_LOG(LogSaveSystem, Display, TEXT("Save Slot: %s"), *LevelSaveSlot);
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Save Slot: %s"), *LevelSaveSlot);
 
 	GetWorld()->OnWorldBeginPlay.AddUObject(this, &ULevelSaveSubsystem::LoadData);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ULevelSaveSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &ULevelSaveSubsystem::OnLevelRemoved);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ULevelSaveSubsystem::OnActorSpawned));
+	ActorDestroyedHandle = GetWorld()->AddOnActorDestroyededHandler(FOnActorDestroyed::FDelegate::CreateUObject(this, &ULevelSaveSubsystem::OnActorDestroyed));
+}
+
+void ULevelSaveSubsystem::Deinitialize()
+{
+	// Anything that wasn't saved is left to the cache to write back, and a write that is still running to finish
+	ULevelStateCacheSubsystem* Cache = bCacheLevelState && !bPartitionIntoCells ? ULevelStateCacheSubsystem::Get(GetWorld()) : nullptr;
+	if(Cache && bStateLoaded && IsValid(LevelSaveObject))
+	{
+		const bool bUnsaved = bForceCompaction || !DirtyInteractedActors.IsEmpty() || !DirtyMovedActors.IsEmpty();
+		Cache->CheckIn(LevelSaveSlot, LevelSaveObject, bBaseOnDisk, StoredDeltaCount, bSaveInFlight, bUnsaved, CompressionCodec);
+		bStateCheckedIn = true;
+	}
+
+	// The state may now be the cache's, so a save that finishes after this must not start another
+	bSavePending = false;
+
+	if(bPartitionIntoCells)
+	{
+		WriteCellsSync();
+	}
+
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	GetWorld()->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+	bRegistryBuilt = false;
+	ActorRegistry.Reset();
+
+	Super::Deinitialize();
+}
+
+void ULevelSaveSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ProcessRestore(RestoreBudgetMs / 1000.0);
+}
+
+TStatId ULevelSaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULevelSaveSubsystem, STATGROUP_Tickables);
 }
 
 void ULevelSaveSubsystem::UpdateActors(AActor* SavedActor, bool bInteracted)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Updating Save Data"));
-	if(LevelSaveObject && IsValid(SavedActor))
+	if(!IsValid(SavedActor))
+	{
+		return;
+	}
+
+	// Called for every interaction, so the line is folded into one per interval rather than logged every time
+	const FLevelActorId ActorId = FLevelActorId::FromActor(SavedActor);
+	if(ULevelSaveObject* SaveObject = GetSaveObjectForUpdate(SavedActor, ActorId))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Save Object and Actor are Valid"));
-		LevelSaveObject->InteractedWithActors.Add(SavedActor, bInteracted);
+		SAVESYSTEM_LOG_AGGREGATED(LogSaveSystemLevel, Verbose, TEXT("Updated interacted Actor %s"), *SavedActor->GetName());
+		SaveObject->InteractedActors.Set(ActorId, bInteracted);
+		if(!bPartitionIntoCells)
+		{
+			DirtyInteractedActors.Add(ActorId);
+		}
+		if(ActorRegistry.Resolve(ActorId) != SavedActor)
+		{
+			ActorRegistry.Register(ActorId, SavedActor);
+		}
 	}
 }
 
 void ULevelSaveSubsystem::UpdateMovedActors(TObjectPtr<AActor> SavedActor, FTransform Transform)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Updating Save Data (Moved Actor)"));
-	if(LevelSaveObject && SavedActor)
+	if(!SavedActor)
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Save Object and Actor are Valid"));
-		LevelSaveObject->MovedActors.Add(SavedActor, Transform);
+		return;
+	}
+
+	const FLevelActorId ActorId = FLevelActorId::FromActor(SavedActor);
+	if(ULevelSaveObject* SaveObject = GetSaveObjectForUpdate(SavedActor, ActorId))
+	{
+		SAVESYSTEM_LOG_AGGREGATED(LogSaveSystemLevel, Verbose, TEXT("Updated moved Actor %s"), *SavedActor->GetName());
+		SaveObject->MovedActors.Add(ActorId, Transform);
+		if(!bPartitionIntoCells)
+		{
+			DirtyMovedActors.Add(ActorId);
+		}
+		if(ActorRegistry.Resolve(ActorId) != SavedActor)
+		{
+			ActorRegistry.Register(ActorId, SavedActor);
+		}
 	}
 }
 
+ULevelSaveObject* ULevelSaveSubsystem::GetSaveObjectForUpdate(const AActor* Actor, const FLevelActorId& ActorId)
+{
+	if(!bPartitionIntoCells)
+	{
+		return LevelSaveObject;
+	}
+
+	// Actors that weren't indexed as they streamed in, such as ones spawned since, keep their state where they are now
+	const FIntPoint* HomeCell = ActorCells.Find(ActorId);
+	const FIntPoint Cell = HomeCell ? *HomeCell : GetCellAt(Actor->GetActorLocation());
+	FLevelSaveCell& SaveCell = FindOrLoadCell(Cell);
+	if(!HomeCell)
+	{
+		ActorCells.Add(ActorId, Cell);
+		SaveCell.ResidentActors++;
+	}
+	SaveCell.bDirty = true;
+	return SaveCell.Data;
+}
+
 void ULevelSaveSubsystem::OnAsyncLoadFinished(const FString& SlotName, const int32 UserIndex, USaveGame* SaveGame)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Level Async Loading Finished"));
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Level Async Loading Finished"));
 	if(SaveGame)
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Level Save Game Pointer is Valid"));
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("Level Save Game Pointer is Valid"));
 		LevelSaveObject = Cast<ULevelSaveObject>(SaveGame);
 
-		// Use the Save Data to Affect which Actors have been interacted with
-		for(auto SavedActor : LevelSaveObject->InteractedWithActors)
+		// Fold any deltas written since the base snapshot in before touching the Actors
+		if(bBaseOnDisk)
+		{
+			LoadDelta(0);
+			return;
+		}
+
+		ApplyLevelSaveObject();
+	}
+}
+
+void ULevelSaveSubsystem::ApplyLevelSaveObject()
+{
+	if(!LevelSaveObject)
+	{
+		return;
+	}
+	bStateLoaded = true;
+
+	{
+		SAVESYSTEM_SCOPE(LevelRestore);
+		BuildActorIndex(!LevelSaveObject->MovedActors.IsEmpty());
+	}
+
+	BeginRestore(LevelSaveObject);
+}
+
+void ULevelSaveSubsystem::BeginRestore(ULevelSaveObject* Source)
+{
+	if(!Source)
+	{
+		return;
+	}
+
+	const bool bWasRestoring = IsRestoring();
+	if(!bWasRestoring)
+	{
+		PendingTransforms.Reset();
+		TransformCursor = 0;
+		TransformRestoreSeconds = 0.0;
+		CompletedRestoreCount = 0;
+	}
+
+	const int32 FirstTransform = PendingTransforms.Num();
+	int32 UnchangedTransforms = 0;
+	{
+		SAVESYSTEM_SCOPE(LevelRestore);
+
+		// Resolve the moved Actors up front, so that the moves themselves happen in tight batches.
+		// Anything that is already where it was saved is skipped, as moving it would only trigger needless updates
+		PendingTransforms.Reserve(FirstTransform + Source->MovedActors.Num());
+		for(const TPair<FLevelActorId, FTransform>& MovedActor : Source->MovedActors)
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Attempting to Update Actor"));
-			if(IsValid(SavedActor.Key) && SavedActor.Key->Implements<ULevelSaveInterface>())
+			const AActor* Actor = ResolveActor(MovedActor.Key);
+			USceneComponent* Root = Actor ? Actor->GetRootComponent() : nullptr;
+			if(!Root || Root->Mobility != EComponentMobility::Movable)
+			{
+				continue;
+			}
+
+			if(Root->GetComponentTransform().Equals(MovedActor.Value))
 			{
-				ILevelSaveInterface::Execute_UpdateActor(SavedActor.Key, SavedActor.Value);
+				UnchangedTransforms++;
+				continue;
 			}
+
+			PendingTransforms.Emplace(Root, MovedActor.Value);
 		}
 	}
+
+	// Queue up the Save Data that affects which Actors have been interacted with
+	// Applied straight from the packed entries of the Save Object once its turn comes, rather than copied out of it
+	if(!Source->InteractedActors.IsEmpty())
+	{
+		RestoreQueue.Add(Source);
+	}
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Restoring %d Moved (%d already in place) and %d Interacted Actors%s"), PendingTransforms.Num() - FirstTransform,
+		UnchangedTransforms, Source->InteractedActors.Num(), bTimeSlicedRestore ? TEXT(" (Time Sliced)") : TEXT(""));
+
+	if(!IsRestoring())
+	{
+		OnRestoreComplete.Broadcast();
+		return;
+	}
+
+	// A restore that is already running picks the new entries up on its next slice
+	if(bWasRestoring)
+	{
+		return;
+	}
+
+	// Either way the first slice is done straight away, the rest is picked up by Tick
+	ProcessRestore(bTimeSlicedRestore ? RestoreBudgetMs / 1000.0 : -1.0);
+}
+
+void ULevelSaveSubsystem::ProcessRestore(double BudgetSeconds)
+{
+	if(!IsRestoring())
+	{
+		return;
+	}
+	SAVESYSTEM_SCOPE(LevelRestore);
+
+	// Checking the clock for every Actor would cost more than some of the updates, so only check it every few
+	constexpr int32 ActorsPerTimeCheck = 16;
+	constexpr int32 TransformsPerBatch = 64;
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + BudgetSeconds;
+
+	// Transforms go first, so Actors are already in place when they are told about their interacted state
+	while(TransformCursor < PendingTransforms.Num())
+	{
+		const int32 BatchSize = FMath::Min(TransformsPerBatch, PendingTransforms.Num() - TransformCursor);
+		ApplyTransformBatch(MakeArrayView(PendingTransforms.GetData() + TransformCursor, BatchSize));
+		TransformCursor += BatchSize;
+
+		if(BudgetSeconds >= 0.0 && FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+	TransformRestoreSeconds += FPlatformTime::Seconds() - StartTime;
+
+	// The entries are walked in order, so the Ids and the bitset are both read sequentially
+	int32 SinceTimeCheck = 0;
+	while(TransformCursor >= PendingTransforms.Num() && (RestoreCursor < PendingRestoreCount || !RestoreQueue.IsEmpty()))
+	{
+		// Move on to the next queued Save Object once the current one is done
+		if(RestoreCursor >= PendingRestoreCount)
+		{
+			CompletedRestoreCount += PendingRestoreCount;
+			RestoreSource = RestoreQueue[0];
+			RestoreQueue.RemoveAt(0);
+			PendingRestoreCount = RestoreSource->InteractedActors.Num();
+			RestoreCursor = 0;
+			continue;
+		}
+
+		// Whether the Actor implements the interface was checked when it registered
+		const int32 Index = RestoreCursor++;
+		const FRegisteredLevelActor* Registered = ActorRegistry.Find(RestoreSource->InteractedActors.GetId(Index));
+		AActor* Actor = Registered && Registered->bImplementsInterface ? Registered->Actor.Get() : nullptr;
+		if(Actor)
+		{
+			ILevelSaveInterface::Execute_UpdateActor(Actor, RestoreSource->InteractedActors.Get(Index));
+		}
+
+		if(BudgetSeconds >= 0.0 && ++SinceTimeCheck >= ActorsPerTimeCheck)
+		{
+			SinceTimeCheck = 0;
+			if(FPlatformTime::Seconds() >= EndTime)
+			{
+				break;
+			}
+		}
+	}
+
+	int32 QueuedRestoreCount = 0;
+	for(const ULevelSaveObject* Queued : RestoreQueue)
+	{
+		QueuedRestoreCount += Queued->InteractedActors.Num();
+	}
+	OnRestoreProgress.Broadcast(TransformCursor + CompletedRestoreCount + RestoreCursor,
+		PendingTransforms.Num() + CompletedRestoreCount + PendingRestoreCount + QueuedRestoreCount);
+
+	if(!IsRestoring())
+	{
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("Restored %d Moved Actors in %.2fms and %d Interacted Actors"),
+			PendingTransforms.Num(), TransformRestoreSeconds * 1000.0, CompletedRestoreCount + PendingRestoreCount);
+		PendingTransforms.Empty();
+		TransformCursor = 0;
+		RestoreSource = nullptr;
+		PendingRestoreCount = 0;
+		CompletedRestoreCount = 0;
+		RestoreCursor = 0;
+		OnRestoreComplete.Broadcast();
+	}
+}
+
+int32 ULevelSaveSubsystem::ApplyTransformBatch(TArrayView<const TPair<TWeakObjectPtr<USceneComponent>, FTransform>> Batch)
+{
+	int32 MovedComponents = 0;
+	for(const TPair<TWeakObjectPtr<USceneComponent>, FTransform>& Entry : Batch)
+	{
+		USceneComponent* Root = Entry.Key.Get();
+		if(!Root)
+		{
+			continue;
+		}
+
+		// Teleport so that physics doesn't sweep or derive a velocity from the move, and settle anything that is simulating
+		const ETeleportType Teleport = Root->IsSimulatingPhysics() ? ETeleportType::ResetPhysics : ETeleportType::TeleportPhysics;
+		Root->SetWorldTransform(Entry.Value, false, nullptr, Teleport);
+		MovedComponents++;
+	}
+	return MovedComponents;
+}
+
+void ULevelSaveSubsystem::BuildActorIndex(bool bIncludeMovableActors)
+{
+	ActorRegistry.Reset();
+
+	for(TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		AActor* Actor = *It;
+		if(LevelSaveSubsystem::IsSaveableActor(Actor, bIncludeMovableActors))
+		{
+			ActorRegistry.Register(Actor);
+		}
+	}
+
+	// From here on the registry is kept up to date as Actors come and go
+	bRegistryBuilt = true;
+	bRegistryIncludesMovable = bIncludeMovableActors;
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Registered %d Saveable Actors"), ActorRegistry.Num());
+}
+
+AActor* ULevelSaveSubsystem::ResolveActor(const FLevelActorId& ActorId) const
+{
+	return ActorRegistry.Resolve(ActorId);
+}
+
+void ULevelSaveSubsystem::RegisterActor(AActor* Actor, ULevelSaveObject*& Restore)
+{
+	const FLevelActorId ActorId = FLevelActorId::FromActor(Actor);
+	const bool bAlreadyRegistered = ActorRegistry.Contains(ActorId);
+	ActorRegistry.Register(ActorId, Actor);
+
+	const ULevelSaveObject* Source = nullptr;
+	if(bPartitionIntoCells)
+	{
+		if(ActorCells.Contains(ActorId))
+		{
+			return;
+		}
+
+		// Actors stream in where they were placed, so that fixes the cell their state is kept in
+		const FIntPoint Cell = GetCellAt(Actor->GetActorLocation());
+		ActorCells.Add(ActorId, Cell);
+		FLevelSaveCell& SaveCell = FindOrLoadCell(Cell);
+		SaveCell.ResidentActors++;
+
+		// Actors in a cell that is still loading are restored along with the rest of it
+		Source = SaveCell.bLoading ? nullptr : SaveCell.Data.Get();
+	}
+	else if(!bAlreadyRegistered && bStateLoaded)
+	{
+		Source = LevelSaveObject;
+	}
+
+	if(!Source)
+	{
+		return;
+	}
+
+	bool bInteracted = false;
+	const bool bHasInteracted = Source->InteractedActors.Find(ActorId, bInteracted);
+	const FTransform* Transform = Source->MovedActors.Find(ActorId);
+	if(!bHasInteracted && !Transform)
+	{
+		return;
+	}
+
+	if(!Restore)
+	{
+		Restore = NewObject<ULevelSaveObject>(this);
+	}
+	if(bHasInteracted)
+	{
+		Restore->InteractedActors.Set(ActorId, bInteracted);
+	}
+	if(Transform)
+	{
+		Restore->MovedActors.Add(ActorId, *Transform);
+	}
+}
+
+void ULevelSaveSubsystem::UnregisterActor(const AActor* Actor, TSet<FIntPoint>& OutEmptiedCells)
+{
+	const FLevelActorId ActorId = FLevelActorId::FromActor(Actor);
+	ActorRegistry.Unregister(ActorId, Actor);
+
+	FIntPoint Cell;
+	if(!bPartitionIntoCells || !ActorCells.RemoveAndCopyValue(ActorId, Cell))
+	{
+		return;
+	}
+
+	FLevelSaveCell* SaveCell = Cells.Find(Cell);
+	if(SaveCell && --SaveCell->ResidentActors <= 0)
+	{
+		OutEmptiedCells.Add(Cell);
+	}
+}
+
+void ULevelSaveSubsystem::OnActorSpawned(AActor* Actor)
+{
+	// Only Actors with a persistent Guid keep the same Id when they are spawned again. Any other spawned Actor would get
+	// an Id from its generated name, which could match the saved state of an unrelated Actor
+	if(!bRegistryBuilt || !IsValid(Actor) || !Actor->Implements<ULevelSaveInterface>()
+		|| !ILevelSaveInterface::Execute_GetPersistentGuid(Actor).IsValid())
+	{
+		return;
+	}
+
+	ULevelSaveObject* Restore = nullptr;
+	RegisterActor(Actor, Restore);
+	BeginRestore(Restore);
+}
+
+void ULevelSaveSubsystem::OnActorDestroyed(AActor* Actor)
+{
+	if(!bRegistryBuilt || !LevelSaveSubsystem::IsSaveableActor(Actor, bRegistryIncludesMovable))
+	{
+		return;
+	}
+
+	TSet<FIntPoint> EmptiedCells;
+	UnregisterActor(Actor, EmptiedCells);
+	for(const FIntPoint& Cell : EmptiedCells)
+	{
+		ReleaseCell(Cell);
+	}
 }
 
 void ULevelSaveSubsystem::OnAsyncSaveFinished(const FString& SlotName, const int32 UserIndex, bool bSuccess)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Level Async Saving Finished"));
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Level Async Saving Finished"));
 	if(bSuccess)
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Level Save was Successful"));
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("Level Save was Successful"));
 	}
 }
 
 void ULevelSaveSubsystem::SaveData()
 {
-	UE_LOG(LogSaveSystem, Display, TEXT( "Saving Level Data"));
+	UE_LOG(LogSaveSystemLevel, Display, TEXT( "Saving Level Data"));
+
+	if(bPartitionIntoCells)
+	{
+		SaveCells();
+		return;
+	}
+
+	// Only one write at a time, as a base and a delta in flight together could finish out of order
+	if(bSaveInFlight)
+	{
+		bSavePending = true;
+		return;
+	}
+
 	// If it isn't Valid, Create a new instance
 	if(!IsValid(LevelSaveObject))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Player Save is NOT Valid. Creating New Instance"));
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("Player Save is NOT Valid. Creating New Instance"));
 		LevelSaveObject = Cast<ULevelSaveObject>(UGameplayStatics::CreateSaveGameObject(ULevelSaveObject::StaticClass()));
 	}
-	FAsyncSaveGameToSlotDelegate asyncSaveDelegate;
-	asyncSaveDelegate.BindUObject(this, &ULevelSaveSubsystem::OnAsyncSaveFinished);
-	UGameplayStatics::AsyncSaveGameToSlot(LevelSaveObject, LevelSaveSlot, 0, asyncSaveDelegate);
 
+	if(!bBaseOnDisk || bForceCompaction || StoredDeltaCount >= MaxDeltasBeforeCompaction)
+	{
+		WriteBase();
+		return;
+	}
+
+	// Nothing has changed since the last save, so there is nothing to write
+	if(DirtyInteractedActors.IsEmpty() && DirtyMovedActors.IsEmpty())
+	{
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("No Level Changes since the last Save"));
+		return;
+	}
+
+	WriteDelta();
+}
+
+void ULevelSaveSubsystem::CompactSaveData()
+{
+	// Cells are always written whole, so there are no deltas to compact
+	if(bPartitionIntoCells)
+	{
+		SaveCells();
+		return;
+	}
+
+	if(bSaveInFlight)
+	{
+		bForceCompaction = true;
+		bSavePending = true;
+		return;
+	}
+
+	if(!IsValid(LevelSaveObject))
+	{
+		LevelSaveObject = Cast<ULevelSaveObject>(UGameplayStatics::CreateSaveGameObject(ULevelSaveObject::StaticClass()));
+	}
+
+	WriteBase();
+}
+
+void ULevelSaveSubsystem::WriteBase()
+{
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Compacting %d Level Deltas into a new Base"), StoredDeltaCount);
+
+	// The new base replaces every delta on disk, so start a new generation so that none of them are applied to it
+	const int32 PreviousGeneration = LevelSaveObject->Generation;
+	LevelSaveObject->Generation++;
+
+	DirtyInteractedActors.Empty();
+	DirtyMovedActors.Empty();
+
+	LevelSaveObject->bQuantizeMovedActors = bQuantizeMovedActors;
+	bSaveInFlight = true;
+	if(!FSavePipeline::SaveAsync(LevelSaveObject, LevelSaveSlot, 0, MakeWriteFinishedDelegate(FString(), PreviousGeneration), CompressionCodec))
+	{
+		OnBaseSaveFinished(false, FSavePipelineStats(), PreviousGeneration);
+	}
+}
+
+void ULevelSaveSubsystem::WriteDelta()
+{
+	ULevelSaveObject* Delta = NewObject<ULevelSaveObject>(this);
+	Delta->Generation = LevelSaveObject->Generation;
+	Delta->bQuantizeMovedActors = bQuantizeMovedActors;
+
+	Delta->InteractedActors.Reserve(DirtyInteractedActors.Num());
+	for(const FLevelActorId& DirtyActor : DirtyInteractedActors)
+	{
+		bool bInteracted = false;
+		if(LevelSaveObject->InteractedActors.Find(DirtyActor, bInteracted))
+		{
+			Delta->InteractedActors.Set(DirtyActor, bInteracted);
+		}
+	}
+
+	for(const FLevelActorId& DirtyActor : DirtyMovedActors)
+	{
+		if(const FTransform* Transform = LevelSaveObject->MovedActors.Find(DirtyActor))
+		{
+			Delta->MovedActors.Add(DirtyActor, *Transform);
+		}
+	}
+
+	DirtyInteractedActors.Empty();
+	DirtyMovedActors.Empty();
+
+	const FString DeltaSlotName = GetDeltaSlotName(StoredDeltaCount);
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Writing Level Delta %s with %d Interacted and %d Moved Actors"),
+		*DeltaSlotName, Delta->InteractedActors.Num(), Delta->MovedActors.Num());
+
+	// The Delta is snapshotted straight away, so it is fine for it to be collected once this returns
+	bSaveInFlight = true;
+	if(!FSavePipeline::SaveAsync(Delta, DeltaSlotName, 0, MakeWriteFinishedDelegate(DeltaSlotName, Delta->Generation), DeltaCompressionCodec))
+	{
+		OnDeltaSaveFinished(false, FSavePipelineStats(), DeltaSlotName);
+	}
+}
+
+void ULevelSaveSubsystem::OnBaseSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, int32 PreviousGeneration)
+{
+	if(bSuccess)
+	{
+		// The deltas are now part of the base, so they can be removed
+		for(int32 DeltaIndex = 0; DeltaIndex < StoredDeltaCount; DeltaIndex++)
+		{
+			FSaveStorage::Get()->Delete(GetDeltaSlotName(DeltaIndex), 0);
+		}
+		StoredDeltaCount = 0;
+		bBaseOnDisk = true;
+		bForceCompaction = false;
+	}
+	else if(IsValid(LevelSaveObject))
+	{
+		// The old base and its deltas are still what is on disk
+		LevelSaveObject->Generation = PreviousGeneration;
+		bForceCompaction = true;
+	}
+
+	OnAsyncSaveFinished(LevelSaveSlot, 0, bSuccess);
+	FinishSave();
+}
+
+void ULevelSaveSubsystem::OnDeltaSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, FString DeltaSlotName)
+{
+	if(bSuccess)
+	{
+		StoredDeltaCount++;
+	}
+	else
+	{
+		// The changes in the delta are lost from the dirty sets, so write everything next time
+		bForceCompaction = true;
+	}
+
+	OnAsyncSaveFinished(DeltaSlotName, 0, bSuccess);
+	FinishSave();
+}
+
+FOnSavePipelineFinished ULevelSaveSubsystem::MakeWriteFinishedDelegate(const FString& DeltaSlotName, int32 PreviousGeneration)
+{
+	// Not bound to this Subsystem, which can be torn down and collected while the write runs
+	return FOnSavePipelineFinished::CreateLambda([WeakThis = TWeakObjectPtr<ULevelSaveSubsystem>(this), WeakCache = TWeakObjectPtr<ULevelStateCacheSubsystem>(ULevelStateCacheSubsystem::Get(GetWorld())),
+		SlotName = LevelSaveSlot, DeltaSlotName, PreviousGeneration](bool bSuccess, const FSavePipelineStats& Stats)
+	{
+		ULevelSaveSubsystem* This = WeakThis.Get();
+		if(This && !This->bStateCheckedIn)
+		{
+			if(DeltaSlotName.IsEmpty())
+			{
+				This->OnBaseSaveFinished(bSuccess, Stats, PreviousGeneration);
+			}
+			else
+			{
+				This->OnDeltaSaveFinished(bSuccess, Stats, DeltaSlotName);
+			}
+			return;
+		}
+
+		if(ULevelStateCacheSubsystem* Cache = WeakCache.Get())
+		{
+			Cache->OnCheckedInWriteFinished(bSuccess, Stats, SlotName, DeltaSlotName, PreviousGeneration);
+		}
+	});
+}
+
+void ULevelSaveSubsystem::FinishSave()
+{
+	bSaveInFlight = false;
+	if(bSavePending)
+	{
+		bSavePending = false;
+		SaveData();
+	}
 }
 
 void ULevelSaveSubsystem::LoadData()
 {
-	UE_LOG(LogSaveSystem, Display, TEXT( "Attempting to Load Level Data"));
+	UE_LOG(LogSaveSystemLevel, Display, TEXT( "Attempting to Load Level Data"));
+
+	if(bPartitionIntoCells)
+	{
+		LoadCells();
+		return;
+	}
+
+	// The load replaces the state with its base before the deltas are folded in, so it can't be handed to the cache until then
+	bStateLoaded = false;
+
+	if(LoadFromCache())
+	{
+		ApplyLevelSaveObject();
+		return;
+	}
 
 	// If a save game exists in a slot, then load it
-	if(UGameplayStatics::DoesSaveGameExist(LevelSaveSlot, 0))
+	if(FSaveStorage::Get()->Exists(LevelSaveSlot, 0))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Level Save Data Exists. Async Loading"));
-		
-		FAsyncLoadGameFromSlotDelegate asyncLoadDelegate;
-		asyncLoadDelegate.BindUObject(this, &ULevelSaveSubsystem::OnAsyncLoadFinished);
-		UGameplayStatics::AsyncLoadGameFromSlot(LevelSaveSlot, 0, asyncLoadDelegate);
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("Level Save Data Exists. Async Loading"));
+
+		FSavePipeline::LoadAsync(LevelSaveSlot, 0, FOnLoadPipelineFinished::CreateUObject(this, &ULevelSaveSubsystem::OnBaseLoaded));
 	}
 
 	// Otherwise, create one
 	else
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("No Player Save Data Exists. Creating New One"));
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("No Player Save Data Exists. Creating New One"));
+		bBaseOnDisk = false;
 		OnAsyncLoadFinished(LevelSaveSlot, 0, UGameplayStatics::CreateSaveGameObject(ULevelSaveObject::StaticClass()));
 	}
 }
+
+bool ULevelSaveSubsystem::LoadFromCache()
+{
+	ULevelStateCacheSubsystem* Cache = bCacheLevelState ? ULevelStateCacheSubsystem::Get(GetWorld()) : nullptr;
+	FLevelStateCacheEntry Cached;
+	if(!Cache || !Cache->CheckOut(LevelSaveSlot, this, Cached))
+	{
+		return false;
+	}
+
+	LevelSaveObject = Cached.State;
+	bBaseOnDisk = Cached.bBaseOnDisk;
+	StoredDeltaCount = Cached.StoredDeltaCount;
+
+	// Changes that were never written aren't in the dirty sets, so the next save has to write a full base. A write back
+	// that is still running is finished through OnBaseSaveFinished, and holds back saves until then like any other
+	bForceCompaction = Cached.bDirty;
+	bSaveInFlight = Cached.bWriteInFlight;
+	return true;
+}
+
+void ULevelSaveSubsystem::OnBaseLoaded(USaveGame* SaveGame, const FSavePipelineStats& Stats)
+{
+	bBaseOnDisk = IsValid(SaveGame);
+	StoredDeltaCount = 0;
+	OnAsyncLoadFinished(LevelSaveSlot, 0, SaveGame);
+}
+
+void ULevelSaveSubsystem::LoadDelta(int32 DeltaIndex)
+{
+	FSavePipeline::LoadAsync(GetDeltaSlotName(DeltaIndex), 0,
+		FOnLoadPipelineFinished::CreateUObject(this, &ULevelSaveSubsystem::OnDeltaLoaded, DeltaIndex));
+}
+
+void ULevelSaveSubsystem::OnDeltaLoaded(USaveGame* SaveGame, const FSavePipelineStats& Stats, int32 DeltaIndex)
+{
+	// Deltas are stored consecutively, so the first missing one is the end of the chain
+	if(!IsValid(SaveGame))
+	{
+		UE_LOG(LogSaveSystemLevel, Display, TEXT("Loaded %d Level Deltas"), DeltaIndex);
+		ApplyLevelSaveObject();
+		return;
+	}
+
+	StoredDeltaCount = DeltaIndex + 1;
+
+	// Deltas from an older generation were already folded into the base, but failed to be deleted
+	const ULevelSaveObject* Delta = Cast<ULevelSaveObject>(SaveGame);
+	if(Delta && LevelSaveObject && Delta->Generation == LevelSaveObject->Generation)
+	{
+		LevelSaveObject->MergeFrom(Delta);
+	}
+	else
+	{
+		UE_LOG(LogSaveSystemLevel, Warning, TEXT("Skipping stale Level Delta %s"), *GetDeltaSlotName(DeltaIndex));
+	}
+
+	LoadDelta(DeltaIndex + 1);
+}
+
+FString ULevelSaveSubsystem::GetDeltaSlotName(int32 DeltaIndex) const
+{
+	return MakeDeltaSlotName(LevelSaveSlot, DeltaIndex);
+}
+
+FString ULevelSaveSubsystem::MakeDeltaSlotName(const FString& LevelSlotName, int32 DeltaIndex)
+{
+	return FString::Printf(TEXT("%s_Delta_%d"), *LevelSlotName, DeltaIndex);
+}
+
+FString ULevelSaveSubsystem::GetCellSlotName(const FIntPoint& Cell) const
+{
+	return FString::Printf(TEXT("%s_Cell_%d_%d"), *LevelSaveSlot, Cell.X, Cell.Y);
+}
+
+FIntPoint ULevelSaveSubsystem::GetCellAt(const FVector& Location) const
+{
+	const double Size = FMath::Max(CellSize, 100.f);
+	return FIntPoint(FMath::FloorToInt32(Location.X / Size), FMath::FloorToInt32(Location.Y / Size));
+}
+
+void ULevelSaveSubsystem::LoadCells()
+{
+	ActorRegistry.Reset();
+	bRegistryBuilt = true;
+	bRegistryIncludesMovable = true;
+
+	// Levels that streamed in before the World began play were ignored until now
+	for(ULevel* Level : GetWorld()->GetLevels())
+	{
+		if(Level && Level->bIsVisible)
+		{
+			OnLevelAdded(Level, GetWorld());
+		}
+	}
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Registered %d Saveable Actors across %d Level Save Cells"), ActorRegistry.Num(), Cells.Num());
+}
+
+void ULevelSaveSubsystem::SaveCells()
+{
+	TArray<FIntPoint> DirtyCells;
+	for(const TPair<FIntPoint, FLevelSaveCell>& Entry : Cells)
+	{
+		if(Entry.Value.bDirty)
+		{
+			DirtyCells.Add(Entry.Key);
+		}
+	}
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Writing %d of %d Level Save Cells"), DirtyCells.Num(), Cells.Num());
+	for(const FIntPoint& Cell : DirtyCells)
+	{
+		WriteCell(Cell);
+	}
+}
+
+void ULevelSaveSubsystem::WriteCellsSync()
+{
+	bShuttingDown = true;
+
+	// A load still in flight has to be merged before its cell can be written, and a write in flight has to land before
+	// a newer one. Both finish on the Game Thread, so that has to keep going while waiting
+	const auto HasCellInFlight = [this]()
+	{
+		for(const TPair<FIntPoint, FLevelSaveCell>& Entry : Cells)
+		{
+			if(Entry.Value.bLoading || Entry.Value.bWriteInFlight)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	const double EndTime = FPlatformTime::Seconds() + LevelSaveSubsystem::ShutdownWriteTimeoutSeconds;
+	while(HasCellInFlight() && FPlatformTime::Seconds() < EndTime)
+	{
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::SleepNoStats(0.f);
+	}
+
+	int32 WrittenCells = 0;
+	for(TPair<FIntPoint, FLevelSaveCell>& Entry : Cells)
+	{
+		FLevelSaveCell& SaveCell = Entry.Value;
+		if(!SaveCell.bDirty || SaveCell.bLoadFailed)
+		{
+			continue;
+		}
+
+		const FString SlotName = GetCellSlotName(Entry.Key);
+		if(SaveCell.bLoading || SaveCell.bWriteInFlight)
+		{
+			UE_LOG(LogSaveSystemLevel, Error, TEXT("Gave up waiting for Level Save Cell %s, its latest changes are lost"), *SlotName);
+			continue;
+		}
+
+		SaveCell.Data->bQuantizeMovedActors = bQuantizeMovedActors;
+		FSavePipelineStats Stats;
+		if(FSavePipeline::SaveSync(SaveCell.Data, SlotName, 0, Stats, CompressionCodec))
+		{
+			SaveCell.bDirty = false;
+			WrittenCells++;
+		}
+		else
+		{
+			UE_LOG(LogSaveSystemLevel, Error, TEXT("Could not write Level Save Cell %s before the World was torn down"), *SlotName);
+		}
+	}
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Wrote %d Level Save Cells before the World was torn down"), WrittenCells);
+}
+
+void ULevelSaveSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if(!bRegistryBuilt || !Level || World != GetWorld())
+	{
+		return;
+	}
+
+	// Actors whose state is already loaded are restored from it straight away, the rest once their cell has loaded
+	ULevelSaveObject* Restore = nullptr;
+	int32 RegisteredActors = 0;
+	{
+		SAVESYSTEM_SCOPE(LevelRestore);
+
+		for(AActor* Actor : Level->Actors)
+		{
+			if(LevelSaveSubsystem::IsSaveableActor(Actor, bRegistryIncludesMovable))
+			{
+				RegisterActor(Actor, Restore);
+				RegisteredActors++;
+			}
+		}
+	}
+
+	UE_LOG(LogSaveSystemLevel, Verbose, TEXT("Level %s streamed in with %d Saveable Actors"), *GetNameSafe(Level->GetOuter()), RegisteredActors);
+	BeginRestore(Restore);
+}
+
+void ULevelSaveSubsystem::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if(!bRegistryBuilt || !Level || World != GetWorld())
+	{
+		return;
+	}
+
+	// The state of the Actors is already saved, so all that is left is to let go of them and of the cells nothing uses
+	TSet<FIntPoint> EmptiedCells;
+	for(AActor* Actor : Level->Actors)
+	{
+		if(LevelSaveSubsystem::IsSaveableActor(Actor, bRegistryIncludesMovable))
+		{
+			UnregisterActor(Actor, EmptiedCells);
+		}
+	}
+
+	for(const FIntPoint& Cell : EmptiedCells)
+	{
+		ReleaseCell(Cell);
+	}
+}
+
+FLevelSaveCell& ULevelSaveSubsystem::FindOrLoadCell(const FIntPoint& Cell)
+{
+	if(FLevelSaveCell* SaveCell = Cells.Find(Cell))
+	{
+		return *SaveCell;
+	}
+
+	// A cell that has never been written simply loads as nothing, leaving the empty Save Object as it is
+	FLevelSaveCell& SaveCell = Cells.Add(Cell);
+	SaveCell.Data = NewObject<ULevelSaveObject>(this);
+	SaveCell.bLoading = true;
+	FSavePipeline::LoadAsync(GetCellSlotName(Cell), 0, FOnLoadPipelineFinished::CreateUObject(this, &ULevelSaveSubsystem::OnCellLoaded, Cell));
+	return SaveCell;
+}
+
+void ULevelSaveSubsystem::OnCellLoaded(USaveGame* SaveGame, const FSavePipelineStats& Stats, FIntPoint Cell)
+{
+	FLevelSaveCell* SaveCell = Cells.Find(Cell);
+	if(!SaveCell)
+	{
+		return;
+	}
+	SaveCell->bLoading = false;
+
+	// Anything recorded while the cell was loading is newer than what is on disk. Nothing loading only means the cell
+	// is new if its Slot isn't there, otherwise the load failed
+	if(ULevelSaveObject* Loaded = Cast<ULevelSaveObject>(SaveGame))
+	{
+		Loaded->MergeFrom(SaveCell->Data);
+		SaveCell->Data = Loaded;
+	}
+	else if(FSaveStorage::Get()->Exists(GetCellSlotName(Cell), 0))
+	{
+		UE_LOG(LogSaveSystemLevel, Error, TEXT("Could not read Level Save Cell %s, it won't be restored or written"), *GetCellSlotName(Cell));
+		SaveCell->bLoadFailed = true;
+	}
+
+	UE_LOG(LogSaveSystemLevel, Verbose, TEXT("Loaded Level Save Cell %s with %d Interacted and %d Moved Actors"), *GetCellSlotName(Cell),
+		SaveCell->Data->InteractedActors.Num(), SaveCell->Data->MovedActors.Num());
+
+	// Restoring can call back into UpdateActors and add cells, so it has to come after the last use of SaveCell
+	ULevelSaveObject* Data = SaveCell->Data;
+	const bool bRestore = SaveCell->ResidentActors > 0 && !SaveCell->bLoadFailed && !bShuttingDown;
+	if(SaveCell->bWritePending)
+	{
+		SaveCell->bWritePending = false;
+		WriteCell(Cell);
+	}
+	else if(!bRestore)
+	{
+		ReleaseCell(Cell);
+	}
+
+	if(bRestore)
+	{
+		BeginRestore(Data);
+	}
+}
+
+void ULevelSaveSubsystem::WriteCell(const FIntPoint& Cell)
+{
+	FLevelSaveCell* SaveCell = Cells.Find(Cell);
+	if(!SaveCell)
+	{
+		return;
+	}
+
+	// Its changes are dropped rather than written over the save that couldn't be read
+	if(SaveCell->bLoadFailed)
+	{
+		if(SaveCell->bDirty)
+		{
+			UE_LOG(LogSaveSystemLevel, Error, TEXT("Not writing Level Save Cell %s, as it could not be read"), *GetCellSlotName(Cell));
+		}
+		SaveCell->bDirty = false;
+		SaveCell->bWritePending = false;
+		ReleaseCell(Cell);
+		return;
+	}
+
+	// Writing a cell that is still loading would replace what is on disk with only the changes made since, and two
+	// writes to the same Slot could finish out of order
+	if(SaveCell->bLoading || SaveCell->bWriteInFlight)
+	{
+		SaveCell->bWritePending = true;
+		return;
+	}
+
+	SaveCell->bDirty = false;
+	SaveCell->bWriteInFlight = true;
+	SaveCell->Data->bQuantizeMovedActors = bQuantizeMovedActors;
+	if(!FSavePipeline::SaveAsync(SaveCell->Data, GetCellSlotName(Cell), 0,
+		FOnSavePipelineFinished::CreateUObject(this, &ULevelSaveSubsystem::OnCellSaveFinished, Cell), CompressionCodec))
+	{
+		OnCellSaveFinished(false, FSavePipelineStats(), Cell);
+	}
+}
+
+void ULevelSaveSubsystem::OnCellSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, FIntPoint Cell)
+{
+	OnAsyncSaveFinished(GetCellSlotName(Cell), 0, bSuccess);
+
+	FLevelSaveCell* SaveCell = Cells.Find(Cell);
+	if(!SaveCell)
+	{
+		return;
+	}
+	SaveCell->bWriteInFlight = false;
+
+	// Keep the cell until a later save manages to write it, rather than dropping its changes
+	if(!bSuccess)
+	{
+		UE_LOG(LogSaveSystemLevel, Warning, TEXT("Could not write Level Save Cell %s"), *GetCellSlotName(Cell));
+		SaveCell->bDirty = true;
+		SaveCell->bWritePending = false;
+		return;
+	}
+
+	if(SaveCell->bWritePending)
+	{
+		SaveCell->bWritePending = false;
+		WriteCell(Cell);
+		return;
+	}
+
+	ReleaseCell(Cell);
+}
+
+void ULevelSaveSubsystem::ReleaseCell(const FIntPoint& Cell)
+{
+	FLevelSaveCell* SaveCell = Cells.Find(Cell);
+	if(!SaveCell || SaveCell->ResidentActors > 0 || SaveCell->bLoading || SaveCell->bWriteInFlight)
+	{
+		return;
+	}
+
+	// Released once the write has finished
+	if(SaveCell->bDirty)
+	{
+		WriteCell(Cell);
+		return;
+	}
+
+	UE_LOG(LogSaveSystemLevel, Verbose, TEXT("Released Level Save Cell %s"), *GetCellSlotName(Cell));
+	Cells.Remove(Cell);
+}
@@ -0,0 +1,375 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Subsystems/LevelStateCacheSubsystem.h"
+#include "SaveSystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/LevelSaveObject.h"
+#include "Storage/SaveStorageBackend.h"
+#include "Subsystems/LevelSaveSubsystem.h"
+#include "Async/TaskGraphInterfaces.h"
+
+namespace LevelStateCacheSubsystem
+{
+	// The longest shutdown waits for writes that are already in flight before writing back what is still dirty
+	static constexpr double ShutdownWriteTimeoutSeconds = 10.0;
+}
+
+void ULevelStateCacheSubsystem::Deinitialize()
+{
+	// A write in flight has to land first, or it would overwrite the newer state written below. It finishes on the Game
+	// Thread, which may also leave its Level dirty again, so that has to keep going while waiting
+	const auto HasWriteInFlight = [this]()
+	{
+		for(const TPair<FString, FLevelStateCacheEntry>& Entry : Entries)
+		{
+			if(Entry.Value.bWriteInFlight)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	const double EndTime = FPlatformTime::Seconds() + LevelStateCacheSubsystem::ShutdownWriteTimeoutSeconds;
+	while(HasWriteInFlight() && FPlatformTime::Seconds() < EndTime)
+	{
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::SleepNoStats(0.f);
+	}
+
+	// Nothing will be around to finish an async write, so whatever is left is written out here
+	for(TPair<FString, FLevelStateCacheEntry>& Entry : Entries)
+	{
+		if(!Entry.Value.bDirty)
+		{
+			continue;
+		}
+		if(Entry.Value.bWriteInFlight)
+		{
+			UE_LOG(LogSaveSystemLevel, Error, TEXT("Gave up waiting for the write in flight to cached Level %s, it may overwrite the final write back"), *Entry.Key);
+		}
+
+		ULevelSaveObject* State = Entry.Value.State;
+		State->Generation++;
+
+		FSavePipelineStats Stats;
+		if(FSavePipeline::SaveSync(State, Entry.Key, 0, Stats, Entry.Value.Codec))
+		{
+			for(int32 DeltaIndex = 0; DeltaIndex < Entry.Value.StoredDeltaCount; DeltaIndex++)
+			{
+				FSaveStorage::Get()->Delete(ULevelSaveSubsystem::MakeDeltaSlotName(Entry.Key, DeltaIndex), 0);
+			}
+		}
+		else
+		{
+			UE_LOG(LogSaveSystemLevel, Error, TEXT("Could not write back cached Level %s"), *Entry.Key);
+		}
+	}
+
+	Entries.Empty();
+	DirtyEntries = 0;
+	CacheStats = FSaveSlotCacheStats();
+
+	Super::Deinitialize();
+}
+
+void ULevelStateCacheSubsystem::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+
+	TArray<FString> DueSlots;
+	for(const TPair<FString, FLevelStateCacheEntry>& Entry : Entries)
+	{
+		const FLevelStateCacheEntry& Level = Entry.Value;
+		if(Level.bDirty && !Level.bWriteInFlight && !Level.Owner.IsValid() && Now - Level.DirtyTime >= WriteBackDelaySeconds)
+		{
+			DueSlots.Add(Entry.Key);
+		}
+	}
+
+	for(const FString& SlotName : DueSlots)
+	{
+		WriteBack(SlotName);
+	}
+}
+
+TStatId ULevelStateCacheSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULevelStateCacheSubsystem, STATGROUP_Tickables);
+}
+
+ULevelStateCacheSubsystem* ULevelStateCacheSubsystem::Get(const UWorld* World)
+{
+	const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<ULevelStateCacheSubsystem>() : nullptr;
+}
+
+bool ULevelStateCacheSubsystem::CheckOut(const FString& SlotName, ULevelSaveSubsystem* Owner, FLevelStateCacheEntry& OutEntry)
+{
+	FLevelStateCacheEntry* Entry = Entries.Find(SlotName);
+	if(!Entry || !Entry->State)
+	{
+		CacheStats.Misses++;
+		return false;
+	}
+
+	CacheStats.Hits++;
+	Entry->LastAccess = ++AccessCounter;
+	Entry->Owner = Owner;
+	Entry->bEvictAfterWrite = false;
+	OutEntry = *Entry;
+
+	// Any unsaved changes are now the Owner's to write
+	SetDirty(*Entry, false);
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Level %s restored from the Level State Cache%s"), *SlotName, OutEntry.bDirty ? TEXT(" with unsaved changes") : TEXT(""));
+	return true;
+}
+
+void ULevelStateCacheSubsystem::CheckIn(const FString& SlotName, ULevelSaveObject* State, bool bBaseOnDisk, int32 StoredDeltaCount, bool bWriteInFlight,
+	bool bUnsaved, ESaveCompressionCodec Codec)
+{
+	if(!IsValid(State))
+	{
+		return;
+	}
+
+	FLevelStateCacheEntry& Entry = Entries.FindOrAdd(SlotName);
+	if(Entry.State)
+	{
+		CacheStats.ResidentBytes -= Entry.EstimatedBytes;
+		CacheStats.ResidentSlots--;
+	}
+
+	Entry.State = State;
+	Entry.EstimatedBytes = EstimateBytes(State);
+	Entry.LastAccess = ++AccessCounter;
+	Entry.bBaseOnDisk = bBaseOnDisk;
+	Entry.StoredDeltaCount = StoredDeltaCount;
+	Entry.Codec = Codec;
+	Entry.Owner = nullptr;
+	Entry.bEvictAfterWrite = false;
+
+	// The Subsystem's write can only be running if the cache's own write back had already finished
+	if(bWriteInFlight && !Entry.bWriteInFlight)
+	{
+		Entry.bWriteInFlight = true;
+		Entry.bCheckedInWriteInFlight = true;
+	}
+
+	// A write back that is still running only covers the state from when it started, so a dirty Level stays dirty
+	SetDirty(Entry, bUnsaved || Entry.bDirty);
+
+	CacheStats.ResidentBytes += Entry.EstimatedBytes;
+	CacheStats.ResidentSlots++;
+
+	EnforceBudget();
+}
+
+void ULevelStateCacheSubsystem::FlushDirtyLevels()
+{
+	TArray<FString> DirtySlots;
+	for(const TPair<FString, FLevelStateCacheEntry>& Entry : Entries)
+	{
+		if(Entry.Value.bDirty && !Entry.Value.bWriteInFlight && !Entry.Value.Owner.IsValid())
+		{
+			DirtySlots.Add(Entry.Key);
+		}
+	}
+
+	for(const FString& SlotName : DirtySlots)
+	{
+		WriteBack(SlotName);
+	}
+}
+
+void ULevelStateCacheSubsystem::ClearCache()
+{
+	TArray<FString> EvictSlots;
+	for(const TPair<FString, FLevelStateCacheEntry>& Entry : Entries)
+	{
+		if(!Entry.Value.bDirty && !Entry.Value.bWriteInFlight && !Entry.Value.Owner.IsValid())
+		{
+			EvictSlots.Add(Entry.Key);
+		}
+	}
+
+	for(const FString& SlotName : EvictSlots)
+	{
+		Evict(SlotName);
+	}
+}
+
+void ULevelStateCacheSubsystem::WriteBack(const FString& SlotName)
+{
+	FLevelStateCacheEntry* Entry = Entries.Find(SlotName);
+	if(!Entry || !Entry->bDirty || Entry->bWriteInFlight || Entry->Owner.IsValid())
+	{
+		return;
+	}
+
+	UE_LOG(LogSaveSystemLevel, Display, TEXT("Writing back cached Level %s"), *SlotName);
+
+	const int32 PreviousGeneration = Entry->State->Generation;
+	Entry->State->Generation++;
+	Entry->bWriteInFlight = true;
+	SetDirty(*Entry, false);
+
+	// The Snapshot is taken straight away, so the state can keep changing, or be evicted, while the write runs
+	if(!FSavePipeline::SaveAsync(Entry->State, SlotName, 0, FOnSavePipelineFinished::CreateUObject(this, &ULevelStateCacheSubsystem::OnWriteBackFinished,
+		SlotName, PreviousGeneration, Entry->StoredDeltaCount), Entry->Codec))
+	{
+		OnWriteBackFinished(false, FSavePipelineStats(), SlotName, PreviousGeneration, Entry->StoredDeltaCount);
+	}
+}
+
+void ULevelStateCacheSubsystem::OnWriteBackFinished(bool bSuccess, const FSavePipelineStats& Stats, FString SlotName, int32 PreviousGeneration, int32 DeltaCount)
+{
+	FLevelStateCacheEntry* Entry = Entries.Find(SlotName);
+	if(!Entry)
+	{
+		return;
+	}
+	Entry->bWriteInFlight = false;
+
+	// The Level was loaded again while it was being written, and its Subsystem now keeps track of what is on disk
+	if(ULevelSaveSubsystem* Owner = Entry->Owner.Get())
+	{
+		Owner->OnBaseSaveFinished(bSuccess, Stats, PreviousGeneration);
+		return;
+	}
+
+	if(!bSuccess)
+	{
+		UE_LOG(LogSaveSystemLevel, Warning, TEXT("Could not write back cached Level %s, trying again later"), *SlotName);
+		Entry->State->Generation = PreviousGeneration;
+		SetDirty(*Entry, true);
+		return;
+	}
+
+	// The deltas are now part of the base, so they can be removed
+	for(int32 DeltaIndex = 0; DeltaIndex < DeltaCount; DeltaIndex++)
+	{
+		FSaveStorage::Get()->Delete(ULevelSaveSubsystem::MakeDeltaSlotName(SlotName, DeltaIndex), 0);
+	}
+	Entry->bBaseOnDisk = true;
+	Entry->StoredDeltaCount = 0;
+
+	if(Entry->bEvictAfterWrite && !Entry->bDirty)
+	{
+		Evict(SlotName);
+		EnforceBudget();
+	}
+}
+
+void ULevelStateCacheSubsystem::OnCheckedInWriteFinished(bool bSuccess, const FSavePipelineStats& Stats, const FString& SlotName, const FString& DeltaSlotName,
+	int32 PreviousGeneration)
+{
+	FLevelStateCacheEntry* Entry = Entries.Find(SlotName);
+	if(!Entry || !Entry->bCheckedInWriteInFlight)
+	{
+		return;
+	}
+	Entry->bCheckedInWriteInFlight = false;
+
+	// A base snapshot finishes just like a write back of the cache's own
+	if(DeltaSlotName.IsEmpty())
+	{
+		OnWriteBackFinished(bSuccess, Stats, SlotName, PreviousGeneration, Entry->StoredDeltaCount);
+		return;
+	}
+
+	Entry->bWriteInFlight = false;
+	if(ULevelSaveSubsystem* Owner = Entry->Owner.Get())
+	{
+		Owner->OnDeltaSaveFinished(bSuccess, Stats, DeltaSlotName);
+		return;
+	}
+
+	// The changes in a delta that failed are only in the state now, so the whole state has to be written back
+	if(bSuccess)
+	{
+		Entry->StoredDeltaCount++;
+	}
+	else
+	{
+		UE_LOG(LogSaveSystemLevel, Warning, TEXT("Could not write Level Delta %s, writing back the cached Level instead"), *DeltaSlotName);
+		SetDirty(*Entry, true);
+	}
+
+	if(Entry->bEvictAfterWrite && !Entry->bDirty)
+	{
+		Evict(SlotName);
+		EnforceBudget();
+	}
+}
+
+void ULevelStateCacheSubsystem::EnforceBudget()
+{
+	while(CacheStats.ResidentBytes > MemoryBudgetBytes)
+	{
+		// Find the least recently used Level that can be evicted. Loaded Levels, and ones already waiting on a write, stay
+		FString EvictSlotName;
+		FLevelStateCacheEntry* EvictEntry = nullptr;
+		for(TPair<FString, FLevelStateCacheEntry>& Entry : Entries)
+		{
+			const FLevelStateCacheEntry& Level = Entry.Value;
+			if(!Level.Owner.IsValid() && !Level.bEvictAfterWrite && (!EvictEntry || Level.LastAccess < EvictEntry->LastAccess))
+			{
+				EvictSlotName = Entry.Key;
+				EvictEntry = &Entry.Value;
+			}
+		}
+
+		if(!EvictEntry)
+		{
+			return;
+		}
+
+		if(!EvictEntry->bDirty && !EvictEntry->bWriteInFlight)
+		{
+			Evict(EvictSlotName);
+			continue;
+		}
+
+		// Evicted once the write back has finished, so unsaved changes are never dropped
+		EvictEntry->bEvictAfterWrite = true;
+		WriteBack(EvictSlotName);
+		return;
+	}
+}
+
+void ULevelStateCacheSubsystem::Evict(const FString& SlotName)
+{
+	FLevelStateCacheEntry Entry;
+	if(!Entries.RemoveAndCopyValue(SlotName, Entry))
+	{
+		return;
+	}
+
+	UE_LOG(LogSaveSystemLevel, Verbose, TEXT("Evicting Level %s from the Level State Cache"), *SlotName);
+	SetDirty(Entry, false);
+	CacheStats.ResidentBytes -= Entry.EstimatedBytes;
+	CacheStats.ResidentSlots--;
+	CacheStats.Evictions++;
+}
+
+void ULevelStateCacheSubsystem::SetDirty(FLevelStateCacheEntry& Entry, bool bDirty)
+{
+	if(bDirty)
+	{
+		Entry.DirtyTime = FPlatformTime::Seconds();
+	}
+
+	if(Entry.bDirty != bDirty)
+	{
+		Entry.bDirty = bDirty;
+		DirtyEntries += bDirty ? 1 : -1;
+	}
+}
+
+int64 ULevelStateCacheSubsystem::EstimateBytes(const ULevelSaveObject* State)
+{
+	return sizeof(ULevelSaveObject) + State->InteractedActors.GetAllocatedSize() + State->MovedActors.GetAllocatedSize();
+}
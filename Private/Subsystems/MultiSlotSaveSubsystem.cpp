@@ -8,12 +8,24 @@
 #include "GameFramework/SaveGame.h"
 #include "Interfaces/SaveObjectInterface.h"
 #include "Kismet/GameplayStatics.h"
+#include "SaveSystemLog.h"
+#include "SaveSystemStats.h"
+#include "Storage/SaveStorageBackend.h"
+#include "UObject/StrongObjectPtr.h"
+
+void UMultiSlotSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LoadManifest();
+}
 
 void UMultiSlotSaveSubsystem::Deinitialize()
 {
 	// Cleaning up the event dispatchers, to prevent undefined behaviour
 	OnSlotRemoved.Clear();
 	OnSlotAdded.Clear();
+	OnSlotsLoaded.Clear();
 		
 	Super::Deinitialize();
 }
@@ -29,10 +41,10 @@ bool UMultiSlotSaveSubsystem::AddEmptySlot(FString SlotName)
 	}
 
 	
-	// Since we are creating an empty slot, we don't want to create a new Save Game Object, so we pass nullptr
-	SaveSlots.Add(SlotName, nullptr);
+	// Since we are creating an empty slot, we don't want to create a new Save Game Object, so the entry is left non resident
+	SaveSlots.Add(SlotName, FSaveSlotCacheEntry());
 
-	UE_LOG(LogSaveSystem, Display, TEXT("Empty Slot %s added"), *SlotName);
+	UE_LOG(LogSaveSystemSlots, Display, TEXT("Empty Slot %s added"), *SlotName);
 	
 	return true;
 }
@@ -51,18 +63,21 @@ bool UMultiSlotSaveSubsystem::AddSlot(FString SlotName)
 	
 
 	// Check if the Save Game Object already exists on disk. If not then create a new one, otherwise load it
-	if(!UGameplayStatics::DoesSaveGameExist(SlotName, 0))
+	if(!FSaveStorage::Get()->Exists(SlotName, 0))
 	{
 		
-		UE_LOG(LogSaveSystem, Display, TEXT("Creating Save Game Object for Slot %s"), *SlotName);
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Creating Save Game Object for Slot %s"), *SlotName);
 
 		// Creates a new Save Game Object, and adds it to the SaveSlots Map
 		const TObjectPtr<USaveGame> NewSaveGame = UGameplayStatics::CreateSaveGameObject(GetSaveGameClass());
 		if(IsValid(NewSaveGame))
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Save Game Object Created for Slot %s"), *SlotName);
-			SaveSlots.Add(SlotName, NewSaveGame);
-			CreatedSaveGames.Add(NewSaveGame);
+			UE_LOG(LogSaveSystemSlots, Display, TEXT("Save Game Object Created for Slot %s"), *SlotName);
+			CacheSlot(SlotName, NewSaveGame, NewSaveGame->GetClass()->GetStructureSize());
+
+			// A new Slot only exists in memory, so it has to be written before it can be evicted
+			SaveSlots[SlotName].bDirty = true;
+			UpdateManifestEntry(SlotName, NewSaveGame, 0);
 			OnSlotAdded.Broadcast(SlotName);
 			OnSaveCreated.Broadcast(SlotName);
 			return true;
@@ -86,12 +101,12 @@ bool UMultiSlotSaveSubsystem::AddSlot(FString SlotName)
 
 bool UMultiSlotSaveSubsystem::AddSlotAndSetActive(FString SlotName, bool bLoad)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Adding Slot %s and setting it as active"), *SlotName);
+	UE_LOG(LogSaveSystemSlots, Display, TEXT("Adding Slot %s and setting it as active"), *SlotName);
 
 	// If the slot was added successfully or the Slot already exists, then set it as active
 	if(AddSlot(SlotName))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Slot %s added and can be set as active"), *SlotName);
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Slot %s added and can be set as active"), *SlotName);
 		return SetActiveSlot(SlotName, bLoad);
 	}
 	
@@ -104,27 +119,19 @@ bool UMultiSlotSaveSubsystem::RemoveSlot(FString SlotName)
 	// Remove the slot if it exists
 	if(SaveSlots.Contains(SlotName))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Removing Slot %s"), *SlotName);
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Removing Slot %s"), *SlotName);
 		
-		// get a reference to the save game object
-		TWeakObjectPtr<USaveGame> SaveGame = SaveSlots[SlotName];
+		// Release the resident Save Game Object along with the entry, it will be collected once nothing else references it
+		if(SaveSlots[SlotName].SaveGame)
+		{
+			SlotCacheStats.ResidentBytes -= SaveSlots[SlotName].EstimatedBytes;
+			SlotCacheStats.ResidentSlots--;
+		}
 
 		// If the number of removed items is greater than 0, then the slot was removed as well as any duplicates that may have existed
 		const bool bResult = SaveSlots.Remove(SlotName) > 0;
 		OnSlotRemoved.Broadcast(SlotName);
 
-		// If the save game object is still valid, then we can destroy it
-		// TODO: This may not be necessary as the save game object should be destroyed when the slot is removed as it is a weak pointer
-		if(bResult && SaveGame.IsValid())
-		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Save Game Object for Slot %s is valid, attempting Destroy"), *SlotName);
-			SaveGame.Get()->ConditionalBeginDestroy();
-		}
-		else if(!SaveGame.IsValid())
-		{
-			UE_LOG(LogSaveSystem, Warning, TEXT("Save Game Object for Slot %s is invalid, Cannot Destroy"), *SlotName);
-		}
-
 		if(bResult)
 		{
 			// Check that the SlotName was not the active slot
@@ -150,13 +157,35 @@ bool UMultiSlotSaveSubsystem::RemoveActiveSlot()
 
 bool UMultiSlotSaveSubsystem::DeleteSlot(FString SlotName)
 {
-	if(RemoveSlot(SlotName) && UGameplayStatics::DoesSaveGameExist(SlotName, 0))
+	// The Slot may only be known from the Manifest, or may not have been written yet, so a Slot missing from any one of
+	// them is still deleted from the others
+	const bool bWasCached = SaveSlots.Contains(SlotName) && RemoveSlot(SlotName);
+	const bool bWasListed = SlotManifest && SlotManifest->RemoveEntry(SlotName);
+	if(bWasListed)
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Deleting Slot %s"), *SlotName);
-		return UGameplayStatics::DeleteGameInSlot(SlotName, 0);
+		WriteManifest();
 	}
 
-	return false;
+	if(!bWasCached && !bWasListed && !FSaveStorage::Get()->Exists(SlotName, 0))
+	{
+		UE_LOG(LogSaveSystem, Warning, TEXT("Slot %s does not exist, Cannot Delete"), *SlotName);
+		return false;
+	}
+
+	UE_LOG(LogSaveSystemSlots, Display, TEXT("Deleting Slot %s"), *SlotName);
+
+	// Queued behind anything still writing to the Slot, so an older write can't bring the deleted Slot back. Whether it
+	// is on disk is only known once those writes have finished
+	EnqueueSlotOperation(SlotName, [this, SlotName]()
+	{
+		ForgetSlotWrite(SlotName);
+		if(FSaveStorage::Get()->Exists(SlotName, 0))
+		{
+			FSaveStorage::Get()->Delete(SlotName, 0);
+		}
+		return false;
+	});
+	return true;
 }
 
 bool UMultiSlotSaveSubsystem::DeleteActiveSlot()
@@ -166,47 +195,82 @@ bool UMultiSlotSaveSubsystem::DeleteActiveSlot()
 
 bool UMultiSlotSaveSubsystem::SaveSlot(FString SlotName, bool bAsync)
 {
-	
-	// Save the slot if it exists
-	if(SaveSlots.Contains(SlotName) && SaveSlots[SlotName].IsValid())
+	if(!GetResidentSlot(SlotName))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Game Object does not exist for Slot %s or Save Game Object is Invalid"), *SlotName);
+		return false;
+	}
+
+	// Async saves go through the scheduler, so repeated saves of the same Slot collapse into as few writes as possible
+	if(bAsync)
+	{
+		RequestSave(SlotName, [this, SlotName](bool bAsyncWrite)
+		{
+			return WriteSlot(SlotName, bAsyncWrite);
+		});
+		return true;
+	}
+
+	return WriteSlot(SlotName, false);
+}
+
+bool UMultiSlotSaveSubsystem::WriteSlot(const FString& SlotName, bool bAsync)
+{
+	// Save the slot if it exists. It may have been evicted or removed while the write was waiting to be scheduled
+	if(USaveGame* SaveGame = GetResidentSlot(SlotName))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Saving Slot %s"), *SlotName);
+		UE_LOG(LogSaveSystemSlots, Verbose, TEXT("Saving Slot %s"), *SlotName);
 
 		// Call the OnObjectPreSave Interface on the Save Game Object
-		if(SaveSlots[SlotName].Get()->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
+		if(SaveGame->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
 		{
-			ISaveObjectInterface::Execute_OnObjectPreSave(SaveSlots[SlotName].Get(), this);
+			ISaveObjectInterface::Execute_OnObjectPreSave(SaveGame, this);
 		}
+
+		// The Snapshot is taken before this returns, so the Slot is clean again as far as eviction is concerned
+		SaveSlots[SlotName].bDirty = false;
 		
 		// Save the slot asynchronously if requested, otherwise save it synchronously
 		if(bAsync)
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Saving Slot %s asynchronously"), *SlotName);
-			
-			FAsyncSaveGameToSlotDelegate asyncSaveDelegate;
-			asyncSaveDelegate.BindUObject(this, &USaveSubsystem::OnAsyncSaveFinished);
-			
-			UGameplayStatics::AsyncSaveGameToSlot(SaveSlots[SlotName].Get(), SlotName, 0, asyncSaveDelegate);
+			UE_LOG(LogSaveSystemSlots, Display, TEXT("Saving Slot %s asynchronously"), *SlotName);
+
+			// Only the Snapshot is taken on the Game Thread, serialization, compression and the write happen on a worker
+			if(!FSavePipeline::SaveAsync(SaveGame, SlotName, 0,
+				FOnSavePipelineFinished::CreateUObject(this, &UMultiSlotSaveSubsystem::OnSlotSaveFinished, SlotName, ESlotWriteKind::Scheduled), GetSlotWriteOptions(SlotName)))
+			{
+				UE_LOG(LogSaveSystem, Error, TEXT("Failed to start saving Slot %s asynchronously"), *SlotName);
+				SaveSlots[SlotName].bDirty = true;
+				return false;
+			}
 		}
 		else
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Saving Slot %s synchronously"), *SlotName);
+			UE_LOG(LogSaveSystemSlots, Display, TEXT("Saving Slot %s synchronously"), *SlotName);
 			
 			// Save the slot synchronously and return the result
-			if(UGameplayStatics::SaveGameToSlot(SaveSlots[SlotName].Get(), SlotName, 0))
+			FSavePipelineStats Stats;
+			const bool bSaved = FSavePipeline::SaveSync(SaveGame, SlotName, 0, Stats, GetSlotWriteOptions(SlotName));
+			RecordSlotWrite(SlotName, bSaved, Stats);
+			ReportSaveStats(SlotName, Stats);
+			if(bSaved)
 			{
-				// If the save succeeds, then for the sake of consistency, we call the OnAsyncSaveFinished function with a success result
-				OnAsyncSaveFinished(SlotName, 0, true);
-
-				if(SaveSlots[SlotName].Get()->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
+				SlotCacheStats.ResidentBytes += Stats.RawBytes - SaveSlots[SlotName].EstimatedBytes;
+				SaveSlots[SlotName].EstimatedBytes = Stats.RawBytes;
+				if(!Stats.bSkippedUnchanged)
 				{
-					ISaveObjectInterface::Execute_OnObjectSaved(SaveSlots[SlotName].Get(), this);
+					UpdateManifestEntry(SlotName, SaveGame, Stats.StoredBytes);
 				}
+
+				// If the save succeeds, then for the sake of consistency, we call the OnAsyncSaveFinished function with a success result.
+				// This also calls OnObjectSaved on the Slot's Save Game Object
+				OnAsyncSaveFinished(SlotName, 0, true);
 				
 				return true;
 			}
 			
 			UE_LOG(LogSaveSystem, Error, TEXT("Failed to save Slot %s synchronously"), *SlotName);
+			SaveSlots[SlotName].bDirty = true;
 			// If the save fails, return false
 			return false;
 		}
@@ -218,6 +282,23 @@ bool UMultiSlotSaveSubsystem::SaveSlot(FString SlotName, bool bAsync)
 	
 }
 
+TSharedRef<FSaveOperation> UMultiSlotSaveSubsystem::BeginSaveSlot(const FString& SlotName)
+{
+	TSharedRef<FSaveOperation> Operation = MakeTrackedOperation(SlotName);
+	if(!GetResidentSlot(SlotName))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Game Object does not exist for Slot %s or Save Game Object is Invalid"), *SlotName);
+		Operation->Complete(false, FSavePipelineStats());
+		return Operation;
+	}
+
+	RequestSave(SlotName, [this, SlotName](bool bAsyncWrite)
+	{
+		return WriteSlot(SlotName, bAsyncWrite);
+	}, Operation);
+	return Operation;
+}
+
 bool UMultiSlotSaveSubsystem::SaveActiveSlot(bool bAsync)
 {
 	// Save the Active Slot if it exists
@@ -225,11 +306,97 @@ bool UMultiSlotSaveSubsystem::SaveActiveSlot(bool bAsync)
 
 }
 
+bool UMultiSlotSaveSubsystem::SaveSlotBatch(const TArray<FString>& SlotNames)
+{
+	TArray<FString> BatchSlotNames;
+	for(const FString& SlotName : SlotNames)
+	{
+		if(GetResidentSlot(SlotName))
+		{
+			BatchSlotNames.AddUnique(SlotName);
+		}
+		else
+		{
+			UE_LOG(LogSaveSystem, Warning, TEXT("Slot %s is not resident, leaving it out of the batch"), *SlotName);
+		}
+	}
+
+	if(BatchSlotNames.Num() == 0)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("No resident Slots to save"));
+		return false;
+	}
+
+	// Like LoadSlots, the batch takes a turn in every Slot's queue and only starts once it holds all of them
+	TSharedRef<int32> SlotsWaiting = MakeShared<int32>(BatchSlotNames.Num());
+	for(const FString& SlotName : BatchSlotNames)
+	{
+		EnqueueSlotOperation(SlotName, [this, SlotsWaiting, BatchSlotNames]()
+		{
+			if(--(*SlotsWaiting) > 0)
+			{
+				return true;
+			}
+
+			// Slots may have been evicted or removed while the batch was waiting, those are finished straight away
+			TArray<USaveGame*> SaveGames;
+			TArray<FString> WriteSlotNames;
+			TArray<FSaveWriteOptions> WriteOptions;
+			for(const FString& BatchSlotName : BatchSlotNames)
+			{
+				USaveGame* SaveGame = GetResidentSlot(BatchSlotName);
+				if(!SaveGame)
+				{
+					CompleteSlotOperation(BatchSlotName);
+					continue;
+				}
+
+				if(SaveGame->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
+				{
+					ISaveObjectInterface::Execute_OnObjectPreSave(SaveGame, this);
+				}
+				SaveSlots[BatchSlotName].bDirty = false;
+				SaveGames.Add(SaveGame);
+				WriteSlotNames.Add(BatchSlotName);
+				WriteOptions.Add(GetSlotWriteOptions(BatchSlotName));
+			}
+
+			if(WriteSlotNames.Num() > 0 && !FSavePipeline::SaveBatchAsync(SaveGames, WriteSlotNames, 0,
+				FOnSaveBatchPipelineFinished::CreateUObject(this, &UMultiSlotSaveSubsystem::OnSlotBatchSaveFinished, WriteSlotNames), WriteOptions))
+			{
+				OnSlotBatchSaveFinished(false, TArray<FSavePipelineStats>(), WriteSlotNames);
+			}
+			return true;
+		});
+	}
+	return true;
+}
+
+void UMultiSlotSaveSubsystem::OnSlotBatchSaveFinished(bool bSuccess, const TArray<FSavePipelineStats>& Stats, TArray<FString> SlotNames)
+{
+	UE_LOG(LogSaveSystem, Display, TEXT("Batch save of %d Slots %s"), SlotNames.Num(), bSuccess ? TEXT("succeeded") : TEXT("failed"));
+
+	for(int32 Index = 0; Index < SlotNames.Num(); Index++)
+	{
+		OnSlotSaveFinished(bSuccess, Stats.IsValidIndex(Index) ? Stats[Index] : FSavePipelineStats(), SlotNames[Index], ESlotWriteKind::Queued);
+	}
+}
+
 bool UMultiSlotSaveSubsystem::SetActiveSlot(const FString& String, bool bLoad)
 {
-	// Set the Active Slot if it exists and is valid
-	if(SaveSlots.Contains(String) && SaveSlots[String].IsValid())
+	// Set the Active Slot if it exists and is resident
+	if(FSaveSlotCacheEntry* Entry = SaveSlots.Find(String); Entry && Entry->SaveGame)
 	{
+		// The game changes the Active Slot through GetSaveGameObject without telling the Slot cache, so the Slot it
+		// replaces is written back before it can be evicted
+		if(String != CurrentSaveSlot)
+		{
+			if(FSaveSlotCacheEntry* PreviousEntry = SaveSlots.Find(CurrentSaveSlot); PreviousEntry && PreviousEntry->SaveGame)
+			{
+				PreviousEntry->bDirty = true;
+			}
+		}
+		Entry->LastAccess = ++SlotAccessCounter;
 		CurrentSaveSlot = String;
 		if(bLoad)
 		{
@@ -239,7 +406,7 @@ bool UMultiSlotSaveSubsystem::SetActiveSlot(const FString& String, bool bLoad)
 	}
 	if(SaveSlots.Contains(String) && bLoad)
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Save Game Object for Slot %s is invalid, attempting to load from disk"), *String);
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Save Game Object for Slot %s is invalid, attempting to load from disk"), *String);
 		return LoadSlot(String);
 	}
 
@@ -253,33 +420,193 @@ TArray<FString> UMultiSlotSaveSubsystem::GetAllSaveSlotNames() const
 	// Get all the save slot names
 	TArray<FString> SlotNames;
 	SaveSlots.GetKeys(SlotNames);
-	// Iterate over the slot names
-	for(auto SlotName : SlotNames)
+
+	// Slots on disk that haven't been loaded yet are only known to the manifest
+	if(SlotManifest)
 	{
-		// If the slot name is empty, remove it from the array
-		if(SlotName.IsEmpty())
+		for(const FSaveSlotManifestEntry& Entry : SlotManifest->GetEntries())
 		{
-			SlotNames.Remove(SlotName);
+			SlotNames.AddUnique(Entry.SlotName);
 		}
+	}
+
+	// If the slot name is empty, remove it from the array
+	SlotNames.RemoveAll([](const FString& SlotName) { return SlotName.IsEmpty(); });
+
+	SAVESYSTEM_LOG_AGGREGATED(LogSaveSystemSlots, Verbose, TEXT("Get All Save Slot Names: %d Slots"), SlotNames.Num());
+	return SlotNames;
+}
+
+TArray<FString> UMultiSlotSaveSubsystem::GetSlotNamesModifiedSince(FDateTime Since) const
+{
+	TArray<FString> SlotNames;
+	if(FSaveStorage::Get()->GetSlotsModifiedSince(Since, 0, SlotNames))
+	{
+		// The backend may also hold Slots that aren't managed by this Subsystem, such as the manifest itself
+		SlotNames.Remove(ManifestSlotName);
+		return SlotNames;
+	}
 
-		UE_LOG(LogSaveSystem, Display, TEXT("Get All Save Slot Names: Slot Name: %s"), *SlotName);
+	if(SlotManifest)
+	{
+		for(const FSaveSlotManifestEntry& Entry : SlotManifest->GetEntries())
+		{
+			if(Entry.Timestamp >= Since)
+			{
+				SlotNames.Add(Entry.SlotName);
+			}
+		}
 	}
 	return SlotNames;
 }
 
+TArray<FSaveSlotManifestEntry> UMultiSlotSaveSubsystem::GetSlotManifestEntries() const
+{
+	return SlotManifest ? SlotManifest->GetEntries() : TArray<FSaveSlotManifestEntry>();
+}
+
+bool UMultiSlotSaveSubsystem::GetSlotManifestEntry(const FString& SlotName, FSaveSlotManifestEntry& OutEntry) const
+{
+	const FSaveSlotManifestEntry* Entry = SlotManifest ? SlotManifest->FindEntry(SlotName) : nullptr;
+	if(!Entry)
+	{
+		return false;
+	}
+
+	OutEntry = *Entry;
+	return true;
+}
+
+bool UMultiSlotSaveSubsystem::SetSlotMetadata(const FString& SlotName, const TArray<uint8>& Metadata)
+{
+	FSaveSlotManifestEntry* Entry = SlotManifest ? SlotManifest->FindEntry(SlotName) : nullptr;
+	if(!Entry)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Slot %s is not in the Slot Manifest, Cannot Set Metadata"), *SlotName);
+		return false;
+	}
+
+	Entry->Metadata = Metadata;
+	WriteManifest();
+	return true;
+}
+
+void UMultiSlotSaveSubsystem::OnSlotSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, FString SlotName, ESlotWriteKind WriteKind)
+{
+	// The Slot was marked clean when its Snapshot was taken, so a failed write has to be retried before it can be evicted
+	if(!bSuccess)
+	{
+		if(FSaveSlotCacheEntry* Entry = SaveSlots.Find(SlotName); Entry && Entry->SaveGame)
+		{
+			Entry->bDirty = true;
+		}
+		else
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Failed to write back evicted Slot %s, its unsaved changes are lost"), *SlotName);
+		}
+	}
+	else
+	{
+		if(FSaveSlotCacheEntry* Entry = SaveSlots.Find(SlotName))
+		{
+			if(Entry->SaveGame)
+			{
+				SlotCacheStats.ResidentBytes += Stats.RawBytes - Entry->EstimatedBytes;
+				Entry->EstimatedBytes = Stats.RawBytes;
+			}
+		}
+		// The manifest entry already describes an unchanged Slot
+		if(!Stats.bSkippedUnchanged)
+		{
+			UpdateManifestEntry(SlotName, GetResidentSlot(SlotName), Stats.StoredBytes);
+		}
+	}
+
+	OnSavePipelineFinished(bSuccess, Stats, SlotName, WriteKind);
+}
+
+void UMultiSlotSaveSubsystem::LoadManifest()
+{
+	// The manifest is small, so a single synchronous read here saves every menu from checking or loading each Slot
+	if(FSaveStorage::Get()->Exists(ManifestSlotName, 0))
+	{
+		FSavePipelineStats Stats;
+		SlotManifest = Cast<USaveSlotManifest>(FSavePipeline::LoadSync(ManifestSlotName, 0, Stats));
+	}
+
+	if(!SlotManifest)
+	{
+		SlotManifest = NewObject<USaveSlotManifest>(this);
+	}
+
+	UE_LOG(LogSaveSystem, Display, TEXT("Slot Manifest loaded with %d Slots"), SlotManifest->GetEntries().Num());
+}
+
+void UMultiSlotSaveSubsystem::UpdateManifestEntry(const FString& SlotName, const USaveGame* SaveGame, int64 SizeBytes)
+{
+	if(!SlotManifest)
+	{
+		return;
+	}
+
+	FSaveSlotManifestEntry& Entry = SlotManifest->FindOrAddEntry(SlotName);
+	Entry.Timestamp = FDateTime::UtcNow();
+	if(SizeBytes >= 0)
+	{
+		Entry.SizeBytes = SizeBytes;
+	}
+	if(SaveGame)
+	{
+		Entry.SaveGameClass = FSoftClassPath(SaveGame->GetClass());
+	}
+
+	WriteManifest();
+}
+
+void UMultiSlotSaveSubsystem::WriteManifest()
+{
+	// Only one write at a time, so that an older manifest can never finish after a newer one
+	if(bManifestWriteInFlight)
+	{
+		bManifestWritePending = true;
+		return;
+	}
+
+	bManifestWriteInFlight = true;
+	const bool bStarted = FSavePipeline::SaveAsync(SlotManifest, ManifestSlotName, 0, FOnSavePipelineFinished::CreateWeakLambda(this, [this](bool bSuccess, const FSavePipelineStats& Stats)
+	{
+		bManifestWriteInFlight = false;
+		if(!bSuccess)
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Failed to write the Slot Manifest"));
+		}
+
+		if(bManifestWritePending)
+		{
+			bManifestWritePending = false;
+			WriteManifest();
+		}
+	}));
+
+	if(!bStarted)
+	{
+		bManifestWriteInFlight = false;
+	}
+}
+
 TArray<USaveGame*> UMultiSlotSaveSubsystem::GetAllSaveSlots()
 {
-	// Get All the Created Save Games and add them to a temp array if they are valid
+	// Get All the resident Save Games
 	TArray<USaveGame*> TempArray;
-	for (auto SaveGame : CreatedSaveGames)
+	for(const TPair<FString, FSaveSlotCacheEntry>& Slot : SaveSlots)
 	{
-		if(SaveGame.IsValid())
+		if(Slot.Value.SaveGame)
 		{
-			TempArray.Add(SaveGame.Get());
+			TempArray.Add(Slot.Value.SaveGame);
 		}
 	}
 
-	UE_LOG(LogTemp, Warning, TEXT("Created and Valid Save Games: %d"), TempArray.Num());
+	UE_LOG(LogSaveSystem, Display, TEXT("Resident Save Games: %d"), TempArray.Num());
 	
 	return TempArray;
 }
@@ -292,13 +619,14 @@ USaveGame* UMultiSlotSaveSubsystem::GetSaveSlot(FString SlotName)
 		return nullptr;
 	}
 
-	if(!SaveSlots[SlotName].IsValid())
+	USaveGame* SaveGame = AccessSlot(SlotName);
+	if(!SaveGame)
 	{
-		UE_LOG(LogSaveSystem, Error, TEXT("Save Game Object is invalid for Slot %s"), *SlotName);
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Game Object is not resident for Slot %s"), *SlotName);
 		return nullptr;
 	}
 	
-	return SaveSlots[SlotName].Get();
+	return SaveGame;
 }
 
 USaveGame* UMultiSlotSaveSubsystem::GetActiveSaveSlot()
@@ -306,55 +634,179 @@ USaveGame* UMultiSlotSaveSubsystem::GetActiveSaveSlot()
 	return GetSaveSlot(CurrentSaveSlot);
 }
 
+bool UMultiSlotSaveSubsystem::MarkSlotDirty(const FString& SlotName)
+{
+	FSaveSlotCacheEntry* Entry = SaveSlots.Find(SlotName);
+	if(!Entry || !Entry->SaveGame)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Save Game Object is not resident for Slot %s, Cannot Mark it Dirty"), *SlotName);
+		return false;
+	}
+
+	Entry->bDirty = true;
+	return true;
+}
+
 USaveGame* UMultiSlotSaveSubsystem::GetSaveGameObject(const TSubclassOf<USaveGame> SaveGameClass)
 {
 	// Get the Active Save Game if it exists
  	if(SaveSlots.Contains(GetPlayerSaveSlot()))
  	{
- 		return SaveSlots[CurrentSaveSlot].Get();
+ 		return AccessSlot(CurrentSaveSlot);
  	}
  	return nullptr;
 }
 
 USaveGame* UMultiSlotSaveSubsystem::GetRawSaveGameObject()
 {
-	// Get the Active Save Game if it exists
-	if(SaveSlots.Contains(GetPlayerSaveSlot()))
+	// The Save Subsystem reads this itself when saving, so it does not count as an access of the Slot cache
+	return GetResidentSlot(CurrentSaveSlot);
+}
+
+USaveGame* UMultiSlotSaveSubsystem::GetSaveGameForSlot(const FString& SlotName)
+{
+	if(SaveSlots.Contains(SlotName))
+	{
+		return GetResidentSlot(SlotName);
+	}
+	return Super::GetSaveGameForSlot(SlotName);
+}
+
+FSaveSlotCacheStats UMultiSlotSaveSubsystem::GetSlotCacheStats() const
+{
+	return SlotCacheStats;
+}
+
+void UMultiSlotSaveSubsystem::OnLoadPipelineFinished(USaveGame* SaveGame, const FSavePipelineStats& Stats, FString SlotName)
+{
+	// Reloading a known Slot replaces its resident Save Game Object
+	if(IsValid(SaveGame) && SaveSlots.Contains(SlotName))
+	{
+		CacheSlot(SlotName, SaveGame, Stats.RawBytes);
+	}
+
+	Super::OnLoadPipelineFinished(SaveGame, Stats, SlotName);
+}
+
+void UMultiSlotSaveSubsystem::CacheSlot(const FString& SlotName, USaveGame* SaveGame, int64 EstimatedBytes)
+{
+	FSaveSlotCacheEntry& Entry = SaveSlots.FindOrAdd(SlotName);
+	if(Entry.SaveGame)
+	{
+		SlotCacheStats.ResidentBytes -= Entry.EstimatedBytes;
+		SlotCacheStats.ResidentSlots--;
+	}
+
+	Entry.SaveGame = SaveGame;
+	Entry.EstimatedBytes = EstimatedBytes;
+	Entry.LastAccess = ++SlotAccessCounter;
+	Entry.bDirty = false;
+
+	SlotCacheStats.ResidentBytes += EstimatedBytes;
+	SlotCacheStats.ResidentSlots++;
+
+	EnforceSlotCacheBudget();
+}
+
+USaveGame* UMultiSlotSaveSubsystem::GetResidentSlot(const FString& SlotName) const
+{
+	const FSaveSlotCacheEntry* Entry = SaveSlots.Find(SlotName);
+	return Entry ? Entry->SaveGame.Get() : nullptr;
+}
+
+USaveGame* UMultiSlotSaveSubsystem::AccessSlot(const FString& SlotName)
+{
+	FSaveSlotCacheEntry* Entry = SaveSlots.Find(SlotName);
+	if(!Entry || !Entry->SaveGame)
 	{
-		return SaveSlots[CurrentSaveSlot].Get();
+		SlotCacheStats.Misses++;
+		return nullptr;
+	}
+
+	SlotCacheStats.Hits++;
+	Entry->LastAccess = ++SlotAccessCounter;
+	return Entry->SaveGame;
+}
+
+void UMultiSlotSaveSubsystem::EnforceSlotCacheBudget()
+{
+	while(SlotCacheStats.ResidentBytes > SlotCacheBudgetBytes)
+	{
+		// Find the least recently used Slot that can be evicted. The Active Slot always stays resident, and so do Slots with
+		// a save scheduled, as the scheduled write snapshots the resident Slot and would otherwise drop the save
+		FString EvictSlotName;
+		FSaveSlotCacheEntry* EvictEntry = nullptr;
+		for(TPair<FString, FSaveSlotCacheEntry>& Slot : SaveSlots)
+		{
+			if(Slot.Value.SaveGame && Slot.Key != CurrentSaveSlot && !HasScheduledSave(Slot.Key)
+				&& (!EvictEntry || Slot.Value.LastAccess < EvictEntry->LastAccess))
+			{
+				EvictSlotName = Slot.Key;
+				EvictEntry = &Slot.Value;
+			}
+		}
+
+		if(!EvictEntry)
+		{
+			return;
+		}
+
+		// Write back anything that may have changed, the Snapshot is taken straight away so the object can be released after
+		if(EvictEntry->bDirty)
+		{
+			UE_LOG(LogSaveSystemSlots, Display, TEXT("Writing back Slot %s before evicting it"), *EvictSlotName);
+
+			// Hold the Save Game Object until the write back gets its turn in the Slot's queue
+			EnqueueSlotOperation(EvictSlotName, [this, EvictSlotName, SaveGame = TStrongObjectPtr<USaveGame>(EvictEntry->SaveGame)]()
+			{
+				return FSavePipeline::SaveAsync(SaveGame.Get(), EvictSlotName, 0,
+					FOnSavePipelineFinished::CreateUObject(this, &UMultiSlotSaveSubsystem::OnSlotSaveFinished, EvictSlotName, ESlotWriteKind::Queued), GetSlotWriteOptions(EvictSlotName));
+			});
+		}
+
+		SAVESYSTEM_LOG_AGGREGATED(LogSaveSystemSlots, Display, TEXT("Evicting Slot %s from the Slot Cache"), *EvictSlotName);
+		SlotCacheStats.ResidentBytes -= EvictEntry->EstimatedBytes;
+		SlotCacheStats.ResidentSlots--;
+		SlotCacheStats.Evictions++;
+		EvictEntry->SaveGame = nullptr;
+		EvictEntry->bDirty = false;
 	}
-	return nullptr;
 }
 
 
 bool UMultiSlotSaveSubsystem::LoadSlot(FString SlotName, bool bAsync)
 {
 	// Load the slot if it exists
-	if(SaveSlots.Contains(SlotName) && SaveSlots[SlotName].IsValid())
+	if(GetResidentSlot(SlotName))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Loading Slot %s"), *SlotName);
+		UE_LOG(LogSaveSystemSlots, Verbose, TEXT("Loading Slot %s"), *SlotName);
 
 		// If the slot is being loaded asynchronously, bind the delegate and load the slot
 		if(bAsync)
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Loading Slot %s asynchronously"), *SlotName);
-			
-			FAsyncLoadGameFromSlotDelegate asyncLoadDelegate;
-			asyncLoadDelegate.BindUObject(this, &USaveSubsystem::OnAsyncLoadFinished);
-			
-			UGameplayStatics::AsyncLoadGameFromSlot(SlotName, 0, asyncLoadDelegate);
+			UE_LOG(LogSaveSystemSlots, Display, TEXT("Loading Slot %s asynchronously"), *SlotName);
+
+			EnqueueSlotLoad(SlotName, [this, SlotName](USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats)
+			{
+				OnLoadPipelineFinished(LoadedSaveGame, Stats, SlotName);
+			});
 		}
 		// If the slot is being loaded synchronously, load the slot and call the function to handle the loaded slot
 		else
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Loading Slot %s synchronously"), *SlotName);
-			
-			OnAsyncLoadFinished(SlotName, 0, UGameplayStatics::LoadGameFromSlot(SlotName, 0));
+			UE_LOG(LogSaveSystemSlots, Display, TEXT("Loading Slot %s synchronously"), *SlotName);
+
+			// Read storage directly, so anything still queued or scheduled on the Slot has to land first
+			WaitForSlotWrites(SlotName);
+			FSavePipelineStats Stats;
+			USaveGame* LoadedSaveGame = FSavePipeline::LoadSync(SlotName, 0, Stats);
+			OnLoadPipelineFinished(LoadedSaveGame, Stats, SlotName);
 		}
 		return true;
 	}
 
-	// If the Slot is not found, try to load it from disk
+	// If the Slot is not resident, try to load it from disk
+	SlotCacheStats.Misses++;
 	if(LoadSlotFromDisk(SlotName))
 	{
 		return true;
@@ -372,30 +824,141 @@ bool UMultiSlotSaveSubsystem::LoadActiveSlot(bool bAsync)
 bool UMultiSlotSaveSubsystem::LoadSlotFromDisk(FString SlotName)
 {
 	// Load the slot if it exists on disk
-	if(UGameplayStatics::DoesSaveGameExist(SlotName, 0))
+	if(FSaveStorage::Get()->Exists(SlotName, 0))
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Loading Slot %s from disk"), *SlotName);
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Loading Slot %s from disk"), *SlotName);
 
-		FAsyncLoadGameFromSlotDelegate asyncLoadDelegate;
-		asyncLoadDelegate.BindLambda([this](const FString& SlotName, const int32 UserIndex, USaveGame* LoadedSaveGame)
+		EnqueueSlotLoad(SlotName, [this, SlotName](USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats)
 		{
-			if(!IsValid(LoadedSaveGame))
-			{
-				UE_LOG(LogSaveSystem, Error, TEXT("Failed to load Slot %s from disk"), *SlotName);
-				return;
-			}
-		
-			SaveSlots.Add(SlotName, LoadedSaveGame);
-			
-			if(SaveSlots[SlotName].IsValid() && SaveSlots[SlotName]->Implements<USaveObjectInterface>())
-			{
-				ISaveObjectInterface::Execute_OnObjectLoaded(SaveSlots[SlotName].Get(), this);
-			}
-			UE_LOG(LogSaveSystem, Display, TEXT("Successful Async Load Slot %s from disk"), *SlotName);
-			OnPlayerDataLoaded.Broadcast(SaveSlots[SlotName].Get());
+			OnSlotLoadedFromDisk(LoadedSaveGame, Stats, SlotName);
 		});
-		UGameplayStatics::AsyncLoadGameFromSlot(SlotName, 0, asyncLoadDelegate);
 		return true;
 	}
 	return false;
 }
+
+TSharedRef<FSaveOperation> UMultiSlotSaveSubsystem::BeginLoadSlot(const FString& SlotName)
+{
+	TSharedRef<FSaveOperation> Operation = MakeTrackedOperation(SlotName);
+	if(GetResidentSlot(SlotName))
+	{
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Loading Slot %s asynchronously"), *SlotName);
+		EnqueueSlotLoad(SlotName, [this, SlotName](USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats)
+		{
+			OnLoadPipelineFinished(LoadedSaveGame, Stats, SlotName);
+		}, Operation);
+	}
+	else if(FSaveStorage::Get()->Exists(SlotName, 0))
+	{
+		UE_LOG(LogSaveSystemSlots, Display, TEXT("Loading Slot %s from disk"), *SlotName);
+		SlotCacheStats.Misses++;
+		EnqueueSlotLoad(SlotName, [this, SlotName](USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats)
+		{
+			OnSlotLoadedFromDisk(LoadedSaveGame, Stats, SlotName);
+		}, Operation);
+	}
+	else
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Slot %s is neither resident nor on disk"), *SlotName);
+		Operation->Complete(false, FSavePipelineStats());
+	}
+	return Operation;
+}
+
+void UMultiSlotSaveSubsystem::OnSlotLoadedFromDisk(USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats, FString SlotName)
+{
+	LastLoadStats = Stats;
+	if(!IsValid(LoadedSaveGame))
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("Failed to load Slot %s from disk"), *SlotName);
+		return;
+	}
+
+	CacheSlot(SlotName, LoadedSaveGame, Stats.RawBytes);
+	
+	if(LoadedSaveGame->Implements<USaveObjectInterface>())
+	{
+		SAVESYSTEM_SCOPE(OnObjectLoaded);
+		ISaveObjectInterface::Execute_OnObjectLoaded(LoadedSaveGame, this);
+	}
+	// Slots written before the manifest existed are picked up the first time they are loaded
+	if(SlotManifest && !SlotManifest->FindEntry(SlotName))
+	{
+		UpdateManifestEntry(SlotName, LoadedSaveGame, Stats.StoredBytes);
+	}
+	UE_LOG(LogSaveSystemSlots, Display, TEXT("Successful Async Load Slot %s from disk"), *SlotName);
+	OnPlayerDataLoaded.Broadcast(LoadedSaveGame);
+}
+
+bool UMultiSlotSaveSubsystem::LoadSlots(const TArray<FString>& SlotNames, int32 MaxConcurrency)
+{
+	// Drop empty and duplicate names, so each Slot is only read once
+	TArray<FString> UniqueSlotNames;
+	for(const FString& SlotName : SlotNames)
+	{
+		if(!SlotName.IsEmpty())
+		{
+			UniqueSlotNames.AddUnique(SlotName);
+		}
+	}
+
+	if(UniqueSlotNames.Num() == 0)
+	{
+		UE_LOG(LogSaveSystem, Error, TEXT("No Slots to load"));
+		return false;
+	}
+
+	UE_LOG(LogSaveSystem, Display, TEXT("Loading %d Slots from disk with up to %d at once"), UniqueSlotNames.Num(), MaxConcurrency);
+
+	// The batch takes a turn in every Slot's queue, and only starts reading once it holds all of them. Missing Slots are
+	// found by the worker when the read fails, rather than checking each one on the Game Thread first
+	TSharedRef<int32> SlotsWaiting = MakeShared<int32>(UniqueSlotNames.Num());
+	for(const FString& SlotName : UniqueSlotNames)
+	{
+		EnqueueSlotOperation(SlotName, [this, SlotsWaiting, UniqueSlotNames, MaxConcurrency]()
+		{
+			if(--(*SlotsWaiting) == 0)
+			{
+				FSavePipeline::LoadBatchAsync(UniqueSlotNames, 0, MaxConcurrency,
+					FOnLoadBatchPipelineFinished::CreateUObject(this, &UMultiSlotSaveSubsystem::OnSlotsBatchLoaded));
+			}
+			return true;
+		});
+	}
+	return true;
+}
+
+void UMultiSlotSaveSubsystem::OnSlotsBatchLoaded(const TArray<FSaveSlotLoadResult>& Results)
+{
+	for(const FSaveSlotLoadResult& Result : Results)
+	{
+		CompleteSlotOperation(Result.SlotName);
+	}
+
+	int32 LoadedSlots = 0;
+	for(const FSaveSlotLoadResult& Result : Results)
+	{
+		if(!Result.bSuccess)
+		{
+			UE_LOG(LogSaveSystem, Warning, TEXT("Failed to load Slot %s from disk"), *Result.SlotName);
+			continue;
+		}
+
+		LoadedSlots++;
+		CacheSlot(Result.SlotName, Result.SaveGame, Result.Stats.RawBytes);
+
+		if(Result.SaveGame->Implements<USaveObjectInterface>())
+		{
+			SAVESYSTEM_SCOPE(OnObjectLoaded);
+			ISaveObjectInterface::Execute_OnObjectLoaded(Result.SaveGame, this);
+		}
+		// Slots written before the manifest existed are picked up the first time they are loaded
+		if(SlotManifest && !SlotManifest->FindEntry(Result.SlotName))
+		{
+			UpdateManifestEntry(Result.SlotName, Result.SaveGame, Result.Stats.StoredBytes);
+		}
+	}
+
+	UE_LOG(LogSaveSystem, Display, TEXT("Loaded %d of %d Slots from disk"), LoadedSlots, Results.Num());
+	OnSlotsLoaded.Broadcast(Results);
+}
@@ -2,9 +2,24 @@
 
 
 #include "Subsystems/SaveSubsystem.h"
+#include "TimerManager.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "CoreGlobals.h"
+#include "Engine/GameInstance.h"
 #include "GameFramework/SaveGame.h"
 #include "Interfaces/SaveObjectInterface.h"
 #include "Kismet/GameplayStatics.h"
+#include "SaveSystemStats.h"
+#include "Storage/SaveStorageBackend.h"
+
+namespace SaveSubsystem
+{
+	// The longest shutdown waits for writes that are already in flight before writing what is still scheduled
+	static constexpr double ShutdownWriteTimeoutSeconds = 10.0;
+
+	// The longest a synchronous load waits for the writes queued on its Slot before reading it anyway
+	static constexpr double SyncLoadWriteTimeoutSeconds = 10.0;
+}
 
 void USaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
@@ -13,17 +28,139 @@ void USaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 void USaveSubsystem::Deinitialize()
 {
+	StopAutosave();
+
+	// Saves still waiting for their debounce window are written now, so saving right before quitting isn't lost
+	WriteScheduledSavesSync();
+	SaveSchedules.Empty();
+	for(const TPair<FString, FSlotOperationQueue>& Queue : SlotOperationQueues)
+	{
+		SaveSystemStats::RecordQueuedOperations(-Queue.Value.Pending.Num());
+	}
+	SlotOperationQueues.Empty();
+	PersistedPayloads.Empty();
+
+	// Their completions were bound to this Subsystem, so they would never finish otherwise
+	for(const TWeakPtr<FSaveOperation>& WeakOperation : TArray<TWeakPtr<FSaveOperation>>(MoveTemp(TrackedOperations)))
+	{
+		if(const TSharedPtr<FSaveOperation> Operation = WeakOperation.Pin())
+		{
+			Operation->Complete(false, FSavePipelineStats());
+		}
+	}
+
 	OnPlayerDataLoaded.Clear();
 	OnPlayerDataSaved.Clear();
 	Super::Deinitialize();
 }
 
-void USaveSubsystem::StartNewSave(bool bLoad)
+void USaveSubsystem::Tick(float DeltaTime)
 {
-	if(UGameplayStatics::DoesSaveGameExist(GetPlayerSaveSlot(), 0))
+	// Game Thread time rather than frame time, so waiting on vsync or the GPU doesn't count as a busy frame
+	const float GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	SmoothedGameThreadMs = SmoothedGameThreadMs <= 0.f ? GameThreadMs : FMath::Lerp(SmoothedGameThreadMs, GameThreadMs, 0.2f);
+
+	// Autosaves are timed in game time, which stops while the game is paused as this doesn't tick then
+	AutosaveClockSeconds += DeltaTime;
+	const double Now = AutosaveClockSeconds;
+	if(Now < NextAutosaveTime)
 	{
-		UGameplayStatics::DeleteGameInSlot(GetPlayerSaveSlot(), 0);
+		return;
+	}
+
+	const double DelaySeconds = Now - NextAutosaveTime;
+	const bool bForced = DelaySeconds >= AutosaveMaxDelaySeconds;
+	const bool bOverBudget = AutosaveFrameBudgetMs > 0.f && SmoothedGameThreadMs > AutosaveFrameBudgetMs;
+	if(!bForced && (bOverBudget || AutosaveBlockers.Num() > 0))
+	{
+		if(!bAutosaveDeferred)
+		{
+			bAutosaveDeferred = true;
+			AutosaveStats.AutosavesDeferred++;
+			const FString Reason = bOverBudget
+				? FString::Printf(TEXT("Game Thread %.2fms over a %.2fms budget"), SmoothedGameThreadMs, AutosaveFrameBudgetMs)
+				: FString::Printf(TEXT("blocked by %s"), *FString::JoinBy(AutosaveBlockers, TEXT(", "), [](const TPair<FName, int32>& Blocker) { return Blocker.Key.ToString(); }));
+			UE_LOG(LogSaveSystem, Display, TEXT("Autosave deferred, %s"), *Reason);
+		}
+		return;
 	}
+
+	// The next one is due an interval after this one ran, so a late autosave isn't followed straight away by another
+	NextAutosaveTime = Now + FMath::Max(AutosaveIntervalSeconds, 1.f);
+	bAutosaveDeferred = false;
+
+	const double StartTime = FPlatformTime::Seconds();
+	PerformAutosave();
+	const float GameThreadCostMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	AutosaveStats.AutosavesRun++;
+	AutosaveStats.AutosavesForced += bForced ? 1 : 0;
+	AutosaveStats.LastAutosaveTime = FDateTime::UtcNow();
+	AutosaveStats.LastDelaySeconds = static_cast<float>(DelaySeconds);
+	AutosaveStats.LastGameThreadMs = GameThreadCostMs;
+	AutosaveStats.MaxGameThreadMs = FMath::Max(AutosaveStats.MaxGameThreadMs, GameThreadCostMs);
+	AutosaveStats.TotalGameThreadMs += GameThreadCostMs;
+	UE_LOG(LogSaveSystem, Display, TEXT("Autosave %d started %.1fs after it was due%s, %.2fms on the Game Thread"),
+		AutosaveStats.AutosavesRun, DelaySeconds, bForced ? TEXT(" (maximum delay reached)") : TEXT(""), GameThreadCostMs);
+}
+
+TStatId USaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USaveSubsystem, STATGROUP_Tickables);
+}
+
+void USaveSubsystem::StartAutosave()
+{
+	bAutosaveRunning = true;
+	bAutosaveDeferred = false;
+	NextAutosaveTime = AutosaveClockSeconds + FMath::Max(AutosaveIntervalSeconds, 1.f);
+}
+
+void USaveSubsystem::StopAutosave()
+{
+	bAutosaveRunning = false;
+	bAutosaveDeferred = false;
+}
+
+void USaveSubsystem::AddAutosaveBlocker(FName Reason)
+{
+	AutosaveBlockers.FindOrAdd(Reason)++;
+}
+
+void USaveSubsystem::RemoveAutosaveBlocker(FName Reason)
+{
+	int32* Count = AutosaveBlockers.Find(Reason);
+	if(!Count)
+	{
+		UE_LOG(LogSaveSystem, Warning, TEXT("Autosave Blocker %s was removed more times than it was added"), *Reason.ToString());
+		return;
+	}
+
+	if(--(*Count) <= 0)
+	{
+		AutosaveBlockers.Remove(Reason);
+	}
+}
+
+void USaveSubsystem::PerformAutosave()
+{
+	SaveData(true);
+	FlushScheduledSave(GetPlayerSaveSlot());
+}
+
+void USaveSubsystem::StartNewSave(bool bLoad)
+{
+	// Queued behind anything still writing to the Slot, so an older write can't bring the deleted save back
+	const FString SlotName = GetPlayerSaveSlot();
+	EnqueueSlotOperation(SlotName, [this, SlotName]()
+	{
+		ForgetSlotWrite(SlotName);
+		if(FSaveStorage::Get()->Exists(SlotName, 0))
+		{
+			FSaveStorage::Get()->Delete(SlotName, 0);
+		}
+		return false;
+	});
 	if(bLoad)
 	{
 		LoadData();
@@ -41,6 +178,7 @@ void USaveSubsystem::OnAsyncLoadFinished(const FString& SlotName, const int32 Us
 		if(PlayerSaveObject->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
 		{
 			UE_LOG(LogSaveSystem, Display, TEXT("Save Game Object Implements Save Object Interface"));
+			SAVESYSTEM_SCOPE(OnObjectLoaded);
 			ISaveObjectInterface::Execute_OnObjectLoaded(PlayerSaveObject, this);
 		}
 		else
@@ -57,18 +195,17 @@ void USaveSubsystem::OnAsyncLoadFinished(const FString& SlotName, const int32 Us
 
 void USaveSubsystem::OnAsyncSaveFinished(const FString& SlotName, const int32 UserIndex, bool bSuccess)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Async Saving Finished"));
+	UE_LOG(LogSaveSystem, Display, TEXT("Async Saving Finished for Slot %s"), *SlotName);
 
-	// Validate the Save Game Object
-	if(!IsValid(GetRawSaveGameObject()))
+	// Notify the Save Game Object of the Slot that was saved, which isn't necessarily the Player's
+	USaveGame* SaveGame = GetSaveGameForSlot(SlotName);
+	if(!IsValid(SaveGame))
 	{
-		UE_LOG(LogSaveSystem, Error, TEXT("Save Game Object is Invalid"));
-		return;
+		UE_LOG(LogSaveSystem, Warning, TEXT("Save Game Object for Slot %s is no longer in memory"), *SlotName);
 	}
-	
-	if(GetRawSaveGameObject()->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
+	else if(SaveGame->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
 	{
-		ISaveObjectInterface::Execute_OnObjectSaved(GetRawSaveGameObject(), this);
+		ISaveObjectInterface::Execute_OnObjectSaved(SaveGame, this);
 	}
 	
 	OnPlayerDataSaved.Broadcast(bSuccess);
@@ -81,26 +218,493 @@ void USaveSubsystem::OnAsyncSaveFinished(const FString& SlotName, const int32 Us
 }
 
 void USaveSubsystem::OnPreSaveObjectComplete(bool bAsyncSave)
+{
+	WritePlayerData(bAsyncSave, GetPlayerSaveSlot(), false);
+}
+
+bool USaveSubsystem::WritePlayerData(bool bAsync, const FString& SlotName, bool bScheduled)
 {
 	UE_LOG(LogSaveSystem, Display, TEXT("Pre Save Object Complete"));
-	if(bAsyncSave){
-		FAsyncSaveGameToSlotDelegate asyncSaveDelegate;
-		asyncSaveDelegate.BindUObject(this, &USaveSubsystem::OnAsyncSaveFinished);
-		UGameplayStatics::AsyncSaveGameToSlot(PlayerSaveObject, GetPlayerSaveSlot(), 0, asyncSaveDelegate);
+	if(bAsync){
+		// Only the Snapshot is taken on the Game Thread, serialization, compression and the write happen on a worker
+		const ESlotWriteKind WriteKind = bScheduled ? ESlotWriteKind::Scheduled : ESlotWriteKind::Unqueued;
+		if(!FSavePipeline::SaveAsync(PlayerSaveObject, SlotName, 0,
+			FOnSavePipelineFinished::CreateUObject(this, &USaveSubsystem::OnSavePipelineFinished, SlotName, WriteKind), GetSlotWriteOptions(SlotName)))
+		{
+			// Reported like a write that failed, so listeners hear about it and the Slot's queue carries on
+			UE_LOG(LogSaveSystem, Error, TEXT("Failed to start saving Slot %s asynchronously"), *SlotName);
+			OnSavePipelineFinished(false, FSavePipelineStats(), SlotName, WriteKind);
+			return true;
+		}
 		UE_LOG(LogSaveSystem, Display, TEXT("Saving Player Data Asynchronously"));
+		return true;
+	}
+
+	FSavePipelineStats Stats;
+	const bool bSaved = FSavePipeline::SaveSync(PlayerSaveObject, SlotName, 0, Stats, GetSlotWriteOptions(SlotName));
+	RecordSlotWrite(SlotName, bSaved, Stats);
+	ReportSaveStats(SlotName, Stats);
+	UE_LOG(LogSaveSystem, Display, TEXT("Saving Player Data Synchronously"));
+
+	if(GetRawSaveGameObject()->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
+	{
+		ISaveObjectInterface::Execute_OnObjectSaved(PlayerSaveObject, this);
+	}
+	return bSaved;
+}
+
+void USaveSubsystem::OnSavePipelineFinished(bool bSuccess, const FSavePipelineStats& Stats, FString SlotName, ESlotWriteKind WriteKind)
+{
+	RecordSlotWrite(SlotName, bSuccess, Stats);
+	ReportSaveStats(SlotName, Stats);
+	OnAsyncSaveFinished(SlotName, 0, bSuccess);
+
+	// A write started outside the queue must not finish whatever operation the Slot happens to be running
+	if(WriteKind != ESlotWriteKind::Unqueued)
+	{
+		CompleteSlotOperation(SlotName);
+	}
+
+	// Any other write finishing can't stand in for the scheduled one, which may still be waiting in the queue behind it
+	if(WriteKind == ESlotWriteKind::Scheduled)
+	{
+		FinishScheduledSave(SlotName, bSuccess, Stats);
+	}
+}
+
+void USaveSubsystem::OnLoadPipelineFinished(USaveGame* SaveGame, const FSavePipelineStats& Stats, FString SlotName)
+{
+	LastLoadStats = Stats;
+	UE_LOG(LogSaveSystemPipeline, Display, TEXT("Load Pipeline for Slot %s: Read %.2fms | Decompress %.2fms | Deserialize %.2fms (Game Thread)"),
+		*SlotName, Stats.ReadMs, Stats.DecompressMs, Stats.DeserializeMs);
+	OnAsyncLoadFinished(SlotName, 0, SaveGame);
+}
+
+void USaveSubsystem::RequestSave(const FString& SlotName, TFunction<bool(bool)> StartWrite, TSharedPtr<FSaveOperation> Operation)
+{
+	SaveSchedulerStats.RequestsReceived++;
+
+	// The latest request always wins, as it will see the latest state of the Save Game Object anyway
+	FSlotSaveSchedule& Schedule = SaveSchedules.FindOrAdd(SlotName);
+	Schedule.StartWrite = MoveTemp(StartWrite);
+	if(Schedule.FirstRequestTime == 0.0)
+	{
+		Schedule.FirstRequestTime = FPlatformTime::Seconds();
+	}
+	if(Operation.IsValid())
+	{
+		Operation->SetExpediteHandler([WeakThis = TWeakObjectPtr<USaveSubsystem>(this), SlotName]()
+		{
+			if(WeakThis.IsValid())
+			{
+				WeakThis->FlushScheduledSave(SlotName);
+			}
+		});
+		Schedule.WaitingOperations.Add(Operation.ToSharedRef());
 	}
 	else
 	{
-		
-		UGameplayStatics::SaveGameToSlot(PlayerSaveObject, GetPlayerSaveSlot(), 0);
-		UE_LOG(LogSaveSystem, Display, TEXT("Saving Player Data Synchronously"));
+		Schedule.bUntrackedRequest = true;
+	}
+
+	const UGameInstance* GameInstance = GetGameInstance();
+	if(SaveDebounceSeconds <= 0.f || !GameInstance)
+	{
+		DispatchScheduledSave(SlotName);
+		return;
+	}
+
+	// The window is fixed from the first request rather than restarted by each one, so constant requests can't starve the write
+	FTimerManager& TimerManager = GameInstance->GetTimerManager();
+	if(TimerManager.IsTimerActive(Schedule.DebounceTimer))
+	{
+		SaveSchedulerStats.RequestsCoalesced++;
+		return;
+	}
+
+	TimerManager.SetTimer(Schedule.DebounceTimer,
+		FTimerDelegate::CreateUObject(this, &USaveSubsystem::DispatchScheduledSave, SlotName), SaveDebounceSeconds, false);
+}
+
+void USaveSubsystem::DispatchScheduledSave(FString SlotName)
+{
+	FSlotSaveSchedule* Schedule = SaveSchedules.Find(SlotName);
+	if(!Schedule || !Schedule->StartWrite)
+	{
+		return;
+	}
+
+	// Only one write per Slot at a time. Anything requested meanwhile becomes a single follow-up write
+	if(Schedule->bWriteInFlight)
+	{
+		if(Schedule->bFollowUpPending)
+		{
+			SaveSchedulerStats.RequestsCoalesced++;
+		}
+		Schedule->bFollowUpPending = true;
+		return;
+	}
+
+	// Nothing is left to write for if every request was made through a handle that has since been cancelled
+	Schedule->WaitingOperations.RemoveAll([](const TSharedRef<FSaveOperation>& Operation) { return Operation->IsDone(); });
+	if(Schedule->WaitingOperations.Num() == 0 && !Schedule->bUntrackedRequest)
+	{
+		UE_LOG(LogSaveSystem, Display, TEXT("Every save requested for Slot %s was cancelled, skipping the write"), *SlotName);
+		Schedule->FirstRequestTime = 0.0;
+		return;
+	}
+
+	// Handles can't be cancelled once their write is on its way
+	Schedule->InFlightOperations = MoveTemp(Schedule->WaitingOperations);
+	Schedule->WaitingOperations.Reset();
+	Schedule->bUntrackedRequest = false;
+	Schedule->InFlightRequestTime = Schedule->FirstRequestTime;
+	Schedule->FirstRequestTime = 0.0;
+	for(const TSharedRef<FSaveOperation>& Operation : Schedule->InFlightOperations)
+	{
+		Operation->Start();
+	}
+
+	Schedule->bWriteInFlight = true;
+	SaveSchedulerStats.WritesPerformed++;
+	UE_LOG(LogSaveSystem, Display, TEXT("Starting scheduled save for Slot %s (%d requests, %d writes)"),
+		*SlotName, SaveSchedulerStats.RequestsReceived, SaveSchedulerStats.WritesPerformed);
+
+	// The write waits its turn behind any other operation on the Slot, such as a load that is still reading it
+	EnqueueSlotOperation(SlotName, [this, SlotName, StartWrite = Schedule->StartWrite]()
+	{
+		if(!StartWrite(true))
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Scheduled save for Slot %s could not be started"), *SlotName);
+			FinishScheduledSave(SlotName, false, FSavePipelineStats());
+			return false;
+		}
+		return true;
+	});
+}
+
+void USaveSubsystem::FinishScheduledSave(const FString& SlotName, bool bSuccess, const FSavePipelineStats& Stats)
+{
+	FSlotSaveSchedule* Schedule = SaveSchedules.Find(SlotName);
+	if(!Schedule || !Schedule->bWriteInFlight)
+	{
+		return;
+	}
+
+	Schedule->bWriteInFlight = false;
+	SaveSystemStats::RecordSaveLatency(SlotName, (FPlatformTime::Seconds() - Schedule->InFlightRequestTime) * 1000.0);
+	const TArray<TSharedRef<FSaveOperation>> FinishedOperations = MoveTemp(Schedule->InFlightOperations);
+	Schedule->InFlightOperations.Reset();
+
+	// While shutting down the follow-up is left to WriteScheduledSavesSync
+	if(Schedule->bFollowUpPending && !bShuttingDown)
+	{
+		Schedule->bFollowUpPending = false;
+		DispatchScheduledSave(SlotName);
+	}
+
+	// Completed last, as their callbacks can request more saves and change the Schedules
+	for(const TSharedRef<FSaveOperation>& Operation : FinishedOperations)
+	{
+		Operation->Complete(bSuccess, Stats);
+	}
+}
+
+bool USaveSubsystem::HasScheduledSave(const FString& SlotName) const
+{
+	const FSlotSaveSchedule* Schedule = SaveSchedules.Find(SlotName);
+	return Schedule && (Schedule->FirstRequestTime != 0.0 || Schedule->bWriteInFlight || Schedule->bFollowUpPending);
+}
+
+bool USaveSubsystem::WaitForSlotWrites(const FString& SlotName)
+{
+	check(IsInGameThread());
+
+	const auto HasWritesLeft = [this, &SlotName]()
+	{
+		return HasPendingSlotOperations(SlotName) || HasScheduledSave(SlotName);
+	};
+	if(!HasWritesLeft())
+	{
+		return true;
+	}
+
+	// The writes finish from Game Thread tasks, which can't be pumped again from inside one of them
+	if(FTaskGraphInterface::Get().IsThreadProcessingTasks(ENamedThreads::GameThread))
+	{
+		UE_LOG(LogSaveSystem, Warning, TEXT("Can't wait for the writes to Slot %s from inside a Save System callback, reading it as it is"), *SlotName);
+		return false;
+	}
+
+	const double EndTime = FPlatformTime::Seconds() + SaveSubsystem::SyncLoadWriteTimeoutSeconds;
+	while(HasWritesLeft())
+	{
+		if(FPlatformTime::Seconds() >= EndTime)
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Gave up waiting for the writes to Slot %s, reading it as it is"), *SlotName);
+			return false;
+		}
+
+		// Also catches a save requested by a callback of a write that just finished
+		FlushScheduledSave(SlotName);
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::SleepNoStats(0.f);
+	}
+	return true;
+}
+
+void USaveSubsystem::WriteScheduledSavesSync()
+{
+	bShuttingDown = true;
+
+	const UGameInstance* GameInstance = GetGameInstance();
+	if(GameInstance)
+	{
+		for(TPair<FString, FSlotSaveSchedule>& Schedule : SaveSchedules)
+		{
+			GameInstance->GetTimerManager().ClearTimer(Schedule.Value.DebounceTimer);
+		}
+	}
+
+	// A write already in flight has to land first, or it would overwrite the newer state written below. Its completion
+	// runs on the Game Thread, so that has to keep going while waiting
+	const auto HasWriteInFlight = [this]()
+	{
+		for(const TPair<FString, FSlotSaveSchedule>& Schedule : SaveSchedules)
+		{
+			if(Schedule.Value.bWriteInFlight)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	const double EndTime = FPlatformTime::Seconds() + SaveSubsystem::ShutdownWriteTimeoutSeconds;
+	while(HasWriteInFlight() && FPlatformTime::Seconds() < EndTime)
+	{
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FPlatformProcess::SleepNoStats(0.f);
+	}
+
+	TArray<FString> SlotNames;
+	SaveSchedules.GenerateKeyArray(SlotNames);
+	for(const FString& SlotName : SlotNames)
+	{
+		FSlotSaveSchedule* Schedule = SaveSchedules.Find(SlotName);
+		if(!Schedule || !Schedule->StartWrite || Schedule->FirstRequestTime == 0.0)
+		{
+			continue;
+		}
+
+		Schedule->WaitingOperations.RemoveAll([](const TSharedRef<FSaveOperation>& Operation) { return Operation->IsDone(); });
+		if(Schedule->WaitingOperations.Num() == 0 && !Schedule->bUntrackedRequest)
+		{
+			continue;
+		}
+		if(Schedule->bWriteInFlight)
+		{
+			UE_LOG(LogSaveSystem, Error, TEXT("Gave up waiting for the write in flight to Slot %s, it may overwrite the final save"), *SlotName);
+		}
 
-		if(GetRawSaveGameObject()->GetClass()->ImplementsInterface(USaveObjectInterface::StaticClass()))
+		UE_LOG(LogSaveSystem, Display, TEXT("Writing the scheduled save for Slot %s before shutting down"), *SlotName);
+		const TArray<TSharedRef<FSaveOperation>> Operations = MoveTemp(Schedule->WaitingOperations);
+		const TFunction<bool(bool)> StartWrite = Schedule->StartWrite;
+		Schedule->WaitingOperations.Reset();
+		Schedule->bUntrackedRequest = false;
+		Schedule->FirstRequestTime = 0.0;
+		Schedule->bFollowUpPending = false;
+
+		const bool bSaved = StartWrite(false);
+		for(const TSharedRef<FSaveOperation>& Operation : Operations)
 		{
-			ISaveObjectInterface::Execute_OnObjectSaved(PlayerSaveObject, this);
+			Operation->Start();
+			Operation->Complete(bSaved, LastSaveStats);
 		}
+	}
+}
 
+void USaveSubsystem::FlushScheduledSave(const FString& SlotName)
+{
+	FSlotSaveSchedule* Schedule = SaveSchedules.Find(SlotName);
+	const UGameInstance* GameInstance = GetGameInstance();
+	if(!Schedule || !GameInstance || !GameInstance->GetTimerManager().IsTimerActive(Schedule->DebounceTimer))
+	{
+		return;
 	}
+
+	GameInstance->GetTimerManager().ClearTimer(Schedule->DebounceTimer);
+	DispatchScheduledSave(SlotName);
+}
+
+void USaveSubsystem::EnqueueSlotOperation(const FString& SlotName, TFunction<bool()> StartOperation)
+{
+	check(IsInGameThread());
+
+	FSlotOperationQueue& Queue = SlotOperationQueues.FindOrAdd(SlotName);
+	Queue.Pending.Add(MoveTemp(StartOperation));
+	SaveSystemStats::RecordQueuedOperations(1);
+	RunNextSlotOperation(SlotName);
+}
+
+void USaveSubsystem::EnqueueSlotLoad(const FString& SlotName, TFunction<void(USaveGame*, const FSavePipelineStats&)> OnLoaded,
+	TSharedPtr<FSaveOperation> Operation)
+{
+	// Queued so that the load can't read the Slot while a save to it is still being written
+	const double QueuedTime = FPlatformTime::Seconds();
+	EnqueueSlotOperation(SlotName, [this, SlotName, OnLoaded = MoveTemp(OnLoaded), Operation, QueuedTime]()
+	{
+		// A cancelled load gives its turn straight to the next operation on the Slot
+		if(Operation.IsValid() && !Operation->Start())
+		{
+			return false;
+		}
+
+		StartSlotLoad(SlotName, OnLoaded, Operation, QueuedTime);
+		return true;
+	});
+}
+
+void USaveSubsystem::StartSlotLoad(const FString& SlotName, TFunction<void(USaveGame*, const FSavePipelineStats&)> OnLoaded,
+	TSharedPtr<FSaveOperation> Operation, double QueuedTime)
+{
+	FSavePipeline::LoadAsync(SlotName, 0, FOnLoadPipelineFinished::CreateWeakLambda(this, [this, SlotName, OnLoaded = MoveTemp(OnLoaded), Operation, QueuedTime](USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats)
+	{
+		OnLoaded(LoadedSaveGame, Stats);
+		SaveSystemStats::RecordLoadLatency(SlotName, (FPlatformTime::Seconds() - QueuedTime) * 1000.0);
+		CompleteSlotOperation(SlotName);
+		if(Operation.IsValid())
+		{
+			Operation->Complete(IsValid(LoadedSaveGame), Stats, LoadedSaveGame);
+		}
+	}));
+}
+
+TSharedRef<FSaveOperation> USaveSubsystem::MakeTrackedOperation(const FString& SlotName)
+{
+	TrackedOperations.RemoveAll([](const TWeakPtr<FSaveOperation>& WeakOperation)
+	{
+		const TSharedPtr<FSaveOperation> Operation = WeakOperation.Pin();
+		return !Operation.IsValid() || Operation->IsDone();
+	});
+
+	TSharedRef<FSaveOperation> Operation = MakeShared<FSaveOperation>(SlotName);
+	TrackedOperations.Add(Operation);
+	return Operation;
+}
+
+void USaveSubsystem::CompleteSlotOperation(const FString& SlotName)
+{
+	FSlotOperationQueue* Queue = SlotOperationQueues.Find(SlotName);
+	if(!Queue || !Queue->bRunning)
+	{
+		return;
+	}
+
+	Queue->bRunning = false;
+	RunNextSlotOperation(SlotName);
+}
+
+void USaveSubsystem::RunNextSlotOperation(const FString& SlotName)
+{
+	while(true)
+	{
+		// Look the Queue up each time, as an operation can queue more operations and reallocate the Map
+		FSlotOperationQueue* Queue = SlotOperationQueues.Find(SlotName);
+		if(!Queue || Queue->bRunning)
+		{
+			return;
+		}
+		if(Queue->Pending.Num() == 0)
+		{
+			SlotOperationQueues.Remove(SlotName);
+			return;
+		}
+
+		const TFunction<bool()> StartOperation = MoveTemp(Queue->Pending[0]);
+		Queue->Pending.RemoveAt(0);
+		Queue->bRunning = true;
+		SaveSystemStats::RecordQueuedOperations(-1);
+
+		// Still running, its completion will carry on with the rest of the Queue
+		if(StartOperation())
+		{
+			return;
+		}
+
+		if(FSlotOperationQueue* FinishedQueue = SlotOperationQueues.Find(SlotName))
+		{
+			FinishedQueue->bRunning = false;
+		}
+	}
+}
+
+void USaveSubsystem::SetSlotCompressionCodec(const FString& SlotName, ESaveCompressionCodec Codec)
+{
+	SlotCompressionCodecs.Add(SlotName, Codec);
+}
+
+void USaveSubsystem::ClearSlotCompressionCodec(const FString& SlotName)
+{
+	SlotCompressionCodecs.Remove(SlotName);
+}
+
+ESaveCompressionCodec USaveSubsystem::GetSlotCompressionCodec(const FString& SlotName) const
+{
+	const ESaveCompressionCodec* Codec = SlotCompressionCodecs.Find(SlotName);
+	return Codec ? *Codec : CompressionCodec;
+}
+
+FSaveWriteOptions USaveSubsystem::GetSlotWriteOptions(const FString& SlotName) const
+{
+	FSaveWriteOptions Options(GetSlotCompressionCodec(SlotName));
+
+	// The hash only says what is in the backend it was written to, so switching backend always rewrites the Slot
+	const FPersistedPayload* Persisted = PersistedPayloads.Find(SlotName);
+	if(Persisted && Persisted->Storage.HasSameObject(&FSaveStorage::Get().Get()))
+	{
+		Options.SkipIfHash = Persisted->Hash;
+	}
+	return Options;
+}
+
+void USaveSubsystem::RecordSlotWrite(const FString& SlotName, bool bSuccess, const FSavePipelineStats& Stats)
+{
+	// A failed write may have left anything in the Slot, so the next save must write it no matter what
+	if(!bSuccess || Stats.PayloadHash == 0)
+	{
+		PersistedPayloads.Remove(SlotName);
+		return;
+	}
+
+	if(Stats.bSkippedUnchanged)
+	{
+		SaveSchedulerStats.WritesSkippedUnchanged++;
+		UE_LOG(LogSaveSystemPipeline, Display, TEXT("Slot %s is unchanged, skipped the write (%d skipped so far)"),
+			*SlotName, SaveSchedulerStats.WritesSkippedUnchanged);
+		return;
+	}
+
+	FPersistedPayload& Persisted = PersistedPayloads.FindOrAdd(SlotName);
+	Persisted.Hash = Stats.PayloadHash;
+	Persisted.Storage = FSaveStorage::Get();
+}
+
+void USaveSubsystem::ForgetSlotWrite(const FString& SlotName)
+{
+	PersistedPayloads.Remove(SlotName);
+}
+
+USaveGame* USaveSubsystem::GetSaveGameForSlot(const FString& SlotName)
+{
+	return SlotName == GetPlayerSaveSlot() ? GetRawSaveGameObject() : nullptr;
+}
+
+void USaveSubsystem::ReportSaveStats(const FString& SlotName, const FSavePipelineStats& Stats)
+{
+	LastSaveStats = Stats;
+	UE_LOG(LogSaveSystemPipeline, Display, TEXT("Save Pipeline for Slot %s: Snapshot %.2fms (Game Thread) | Serialize %.2fms | Compress %.2fms | Write %.2fms | %lld -> %lld bytes"),
+		*SlotName, Stats.SnapshotMs, Stats.SerializeMs, Stats.CompressMs, Stats.WriteMs, Stats.RawBytes, Stats.StoredBytes);
+	OnSaveStatsReported.Broadcast(SlotName, Stats);
 }
 
 void USaveSubsystem::SetSaveGameClass(TSubclassOf<USaveGame> SaveGameSubClass, bool bResetSaveObject)
@@ -172,6 +776,35 @@ void USaveSubsystem::SaveData(bool bAsync)
 {
 	UE_LOG(LogSaveSystem, Display, TEXT("Saving Player Data"));
 
+	// Async saves go through the scheduler, so that saving after every small change doesn't stack up writes to the Slot
+	const FString SlotName = GetPlayerSaveSlot();
+	if(bAsync)
+	{
+		RequestSave(SlotName, [this, SlotName](bool bAsyncWrite)
+		{
+			return SavePlayerData(bAsyncWrite, SlotName);
+		});
+		return;
+	}
+
+	SavePlayerData(false, SlotName);
+}
+
+TSharedRef<FSaveOperation> USaveSubsystem::BeginSaveData()
+{
+	UE_LOG(LogSaveSystem, Display, TEXT("Saving Player Data"));
+
+	const FString SlotName = GetPlayerSaveSlot();
+	TSharedRef<FSaveOperation> Operation = MakeTrackedOperation(SlotName);
+	RequestSave(SlotName, [this, SlotName](bool bAsyncWrite)
+	{
+		return SavePlayerData(bAsyncWrite, SlotName);
+	}, Operation);
+	return Operation;
+}
+
+bool USaveSubsystem::SavePlayerData(bool bAsync, const FString& SlotName)
+{
 	if(!IsValid(GetRawSaveGameObject()))
 	{
 		UE_LOG(LogSaveSystem, Warning, TEXT("Player Save is NOT Valid. Creating New Instance"));
@@ -186,45 +819,100 @@ void USaveSubsystem::SaveData(bool bAsync)
 		ISaveObjectInterface::Execute_OnObjectPreSave(PlayerSaveObject, this);
 	}
 
-	OnPreSaveObjectComplete(bAsync);
-	
+	// Async writes of the Player Data only ever start from the scheduler, as an operation in the Slot's queue
+	return WritePlayerData(bAsync, SlotName, bAsync);
 }
 
 void USaveSubsystem::LoadData(bool bAsync)
 {
-	UE_LOG(LogSaveSystem, Display, TEXT("Attempting to Load Data from Slot: %s"),* GetPlayerSaveSlot());
+	LoadPlayerData(bAsync, nullptr);
+}
 
-	// If a save game exists in a slot, then load it
-	if(UGameplayStatics::DoesSaveGameExist(GetPlayerSaveSlot(), 0))
+TSharedRef<FSaveOperation> USaveSubsystem::BeginLoadData()
+{
+	TSharedRef<FSaveOperation> Operation = MakeTrackedOperation(GetPlayerSaveSlot());
+	LoadPlayerData(true, Operation);
+	return Operation;
+}
+
+void USaveSubsystem::LoadPlayerData(bool bAsync, TSharedPtr<FSaveOperation> Operation)
+{
+	const FString SlotName = GetPlayerSaveSlot();
+	UE_LOG(LogSaveSystem, Display, TEXT("Attempting to Load Data from Slot: %s"), *SlotName);
+
+	// Async loads only check the Slot once they get their turn in its queue, so a delete queued ahead of them, such as
+	// the one from StartNewSave or ClearSave, is always seen
+	if(bAsync)
 	{
-		if(bAsync){
+		const double QueuedTime = FPlatformTime::Seconds();
+		EnqueueSlotOperation(SlotName, [this, SlotName, Operation, QueuedTime]()
+		{
+			if(Operation.IsValid() && !Operation->Start())
+			{
+				return false;
+			}
+			if(!FSaveStorage::Get()->Exists(SlotName, 0))
+			{
+				CreatePlayerData(SlotName, Operation);
+				return false;
+			}
+
 			UE_LOG(LogSaveSystem, Display, TEXT("Player Save Data Exists. Async Loading"));
-		
-			FAsyncLoadGameFromSlotDelegate asyncLoadDelegate;
-			asyncLoadDelegate.BindUObject(this, &USaveSubsystem::OnAsyncLoadFinished);
-			UGameplayStatics::AsyncLoadGameFromSlot(GetPlayerSaveSlot(), 0, asyncLoadDelegate);
-		}
-		else
+			StartSlotLoad(SlotName, [this, SlotName](USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats)
+			{
+				OnLoadPipelineFinished(LoadedSaveGame, Stats, SlotName);
+			}, Operation, QueuedTime);
+			return true;
+		});
+		return;
+	}
+
+	// Sync loads read storage directly, so anything still queued or scheduled on the Slot has to land first
+	WaitForSlotWrites(SlotName);
+
+	// If a save game exists in a slot, then load it
+	if(FSaveStorage::Get()->Exists(SlotName, 0))
+	{
+		UE_LOG(LogSaveSystem, Display, TEXT("Player Save Data Exists. Sync Loading"));
+		FSavePipelineStats Stats;
+		USaveGame* LoadedSaveGame = FSavePipeline::LoadSync(SlotName, 0, Stats);
+		OnLoadPipelineFinished(LoadedSaveGame, Stats, SlotName);
+		if(Operation.IsValid())
 		{
-			UE_LOG(LogSaveSystem, Display, TEXT("Player Save Data Exists. Sync Loading"));
-			OnAsyncLoadFinished(GetPlayerSaveSlot(), 0, UGameplayStatics::LoadGameFromSlot(GetPlayerSaveSlot(), 0));
+			Operation->Complete(IsValid(LoadedSaveGame), Stats, LoadedSaveGame);
 		}
 	}
 
 	// Otherwise, create one
 	else
 	{
-		UE_LOG(LogSaveSystem, Warning, TEXT("No Player Save Data Exists. Creating New One with Class: %s"), *GetNameSafe(_SaveGameClass));
-		OnAsyncLoadFinished(GetPlayerSaveSlot(), 0, UGameplayStatics::CreateSaveGameObject(_SaveGameClass));
+		CreatePlayerData(SlotName, Operation);
 	}
 }
 
-void USaveSubsystem::ClearSave()
+void USaveSubsystem::CreatePlayerData(const FString& SlotName, TSharedPtr<FSaveOperation> Operation)
 {
-	if(UGameplayStatics::DoesSaveGameExist(GetPlayerSaveSlot(), 0))
+	UE_LOG(LogSaveSystem, Warning, TEXT("No Player Save Data Exists. Creating New One with Class: %s"), *GetNameSafe(_SaveGameClass));
+	USaveGame* NewSaveGame = UGameplayStatics::CreateSaveGameObject(_SaveGameClass);
+	OnAsyncLoadFinished(SlotName, 0, NewSaveGame);
+	if(Operation.IsValid())
 	{
-		UE_LOG(LogSaveSystem, Display, TEXT("Deleting Save Data"));
-		UGameplayStatics::DeleteGameInSlot(GetPlayerSaveSlot(), 0);
+		Operation->Complete(IsValid(NewSaveGame), FSavePipelineStats(), NewSaveGame);
 	}
+}
+
+void USaveSubsystem::ClearSave()
+{
+	const FString SlotName = GetPlayerSaveSlot();
+	EnqueueSlotOperation(SlotName, [this, SlotName]()
+	{
+		ForgetSlotWrite(SlotName);
+		if(FSaveStorage::Get()->Exists(SlotName, 0))
+		{
+			UE_LOG(LogSaveSystem, Display, TEXT("Deleting Save Data"));
+			FSaveStorage::Get()->Delete(SlotName, 0);
+		}
+		return false;
+	});
 	PlayerSaveObject = nullptr;
 }
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/LevelActorId.h"
+#include "LevelActorFlags.generated.h"
+
+/**
+ * A single flag for each of a set of Level Actors, stored as a dense array of Actor Ids and a packed bitset in the same
+ * order. Each entry costs the 8 bytes of its Id and one bit, both in memory and on disk, rather than a Map node per
+ * Actor, and walking the entries in order touches memory sequentially.
+ * \n \n
+ * Entries are only ever appended or updated, so an entry keeps its index for as long as the set exists. Ids are found
+ * through an open addressing table of entry indices, which adds about 8 bytes per entry. It is not saved, and is rebuilt
+ * the first time it is needed after loading.
+ */
+USTRUCT()
+struct SAVESYSTEM_API FLevelActorFlags
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Set the flag of an Actor, adding an entry for it if it doesn't have one yet
+	 * @return The index of the Actor's entry
+	 */
+	int32 Set(const FLevelActorId& ActorId, bool bFlag);
+
+	/**
+	 * @brief Get the flag of an Actor
+	 * @return False if the Actor has no entry, in which case bOutFlag is left alone
+	 */
+	bool Find(const FLevelActorId& ActorId, bool& bOutFlag) const;
+
+	bool Contains(const FLevelActorId& ActorId) const { return FindIndex(ActorId) != INDEX_NONE; }
+
+	int32 Num() const { return ActorIds.Num(); }
+
+	bool IsEmpty() const { return ActorIds.IsEmpty(); }
+
+	FLevelActorId GetId(int32 Index) const { return FLevelActorId(ActorIds[Index]); }
+
+	bool Get(int32 Index) const { return (Bits[Index >> 5] >> (Index & 31)) & 1u; }
+
+	/**
+	 * @brief Get the number of entries whose flag is set
+	 */
+	int32 CountSet() const;
+
+	/**
+	 * @brief Set every entry in Other on this set, overwriting the flags of Actors that are in both
+	 */
+	void Append(const FLevelActorFlags& Other);
+
+	void Reserve(int32 Number);
+
+	void Empty();
+
+	/**
+	 * @brief Get the memory used by the entries and the lookup, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	int32 FindIndex(const FLevelActorId& ActorId) const;
+
+	/**
+	 * @brief Rebuild the lookup with room for at least MinEntries entries at no more than half load
+	 */
+	void RebuildLookup(int32 MinEntries) const;
+
+	/**
+	 * @brief The Id of the Actor of each entry. Stored as raw values, so each one is saved as 8 bytes without a tag
+	 */
+	UPROPERTY()
+	TArray<uint64> ActorIds;
+
+	/**
+	 * @brief The flag of each entry, 32 to a word
+	 */
+	UPROPERTY()
+	TArray<uint32> Bits;
+
+	/**
+	 * @brief Id to index lookup. A power of two number of slots, each holding an entry index or INDEX_NONE, probed
+	 * linearly from the low bits of the Id. Actor Ids are already hashes, so they don't need hashing again
+	 */
+	mutable TArray<int32> LookupSlots;
+
+	/**
+	 * @brief The number of entries in the lookup, which falls behind ActorIds after loading
+	 */
+	mutable int32 LookupEntries = 0;
+};
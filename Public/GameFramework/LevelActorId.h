@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LevelActorId.generated.h"
+
+/**
+ * A compact identifier for an Actor that stays the same across level loads and play sessions, so that it can be used
+ * as a key in save data. It is a 64 bit hash of either the Actor's persistent Guid (see ILevelSaveInterface::GetPersistentGuid)
+ * or, for Actors placed in a Level, of the Level's package and the Actor's name.
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FLevelActorId
+{
+	GENERATED_BODY()
+
+	FLevelActorId() = default;
+
+	explicit FLevelActorId(uint64 InValue) : Value(InValue) {}
+
+	/**
+	 * @brief Builds the persistent Id for an Actor
+	 * @param Actor The Actor to build the Id for
+	 * @return The Id of the Actor, or an invalid Id if the Actor is invalid
+	 */
+	static FLevelActorId FromActor(const AActor* Actor);
+
+	bool IsValid() const { return Value != 0; }
+
+	FString ToString() const { return FString::Printf(TEXT("%016llx"), Value); }
+
+	bool operator==(const FLevelActorId& Other) const { return Value == Other.Value; }
+
+	bool operator!=(const FLevelActorId& Other) const { return Value != Other.Value; }
+
+	friend uint32 GetTypeHash(const FLevelActorId& Id) { return GetTypeHash(Id.Value); }
+
+	UPROPERTY()
+	uint64 Value = 0;
+};
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/LevelActorId.h"
+
+/**
+ * A live Actor in the Level Actor Registry
+ */
+struct SAVESYSTEM_API FRegisteredLevelActor
+{
+	FLevelActorId Id;
+
+	TWeakObjectPtr<AActor> Actor;
+
+	/**
+	 * @brief Whether the Actor implements ILevelSaveInterface, checked once when it was registered
+	 */
+	bool bImplementsInterface = false;
+};
+
+/**
+ * The live Actors of a World that can have saved state, stored as a dense array with a Map from persistent Id to index.
+ * \n \n
+ * Each Actor's Id and whether it implements ILevelSaveInterface are worked out once as it registers, so resolving a
+ * saved entry is a single lookup. Unregistering moves the last entry into the gap, so indices are only stable until the
+ * next Unregister.
+ */
+class SAVESYSTEM_API FLevelActorRegistry
+{
+public:
+
+	/**
+	 * @brief Register an Actor, working out its persistent Id and whether it implements ILevelSaveInterface
+	 * @return The index of the Actor's entry, or INDEX_NONE if the Actor is invalid
+	 */
+	int32 Register(AActor* Actor);
+
+	/**
+	 * @brief Register an Actor whose persistent Id is already known. An Actor already registered under the Id is replaced
+	 * @return The index of the Actor's entry
+	 */
+	int32 Register(const FLevelActorId& ActorId, AActor* Actor);
+
+	/**
+	 * @brief Remove the entry of an Actor
+	 * @param Actor If set, the entry is only removed if it is still this Actor's, and not one that has replaced it
+	 * @return If an entry was removed
+	 */
+	bool Unregister(const FLevelActorId& ActorId, const AActor* Actor = nullptr);
+
+	const FRegisteredLevelActor* Find(const FLevelActorId& ActorId) const
+	{
+		const int32* Index = IndexById.Find(ActorId);
+		return Index ? &Entries[*Index] : nullptr;
+	}
+
+	bool Contains(const FLevelActorId& ActorId) const { return IndexById.Contains(ActorId); }
+
+	/**
+	 * @brief Find the live Actor for a persistent Id
+	 * @return The Actor, or nullptr if no live Actor has that Id
+	 */
+	AActor* Resolve(const FLevelActorId& ActorId) const
+	{
+		const FRegisteredLevelActor* Entry = Find(ActorId);
+		return Entry ? Entry->Actor.Get() : nullptr;
+	}
+
+	int32 Num() const { return Entries.Num(); }
+
+	bool IsEmpty() const { return Entries.IsEmpty(); }
+
+	void Reserve(int32 Number);
+
+	void Reset();
+
+	/**
+	 * @brief Get the memory used by the entries and the lookup, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const { return Entries.GetAllocatedSize() + IndexById.GetAllocatedSize(); }
+
+private:
+
+	void RemoveAt(int32 Index);
+
+	TArray<FRegisteredLevelActor> Entries;
+
+	TMap<FLevelActorId, int32> IndexById;
+};
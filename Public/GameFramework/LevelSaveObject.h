@@ -3,11 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameFramework/LevelActorFlags.h"
+#include "GameFramework/LevelActorId.h"
+#include "GameFramework/QuantizedActorTransforms.h"
 #include "GameFramework/SaveGame.h"
 #include "LevelSaveObject.generated.h"
 
 /**
- * 
+ * Holds the saved state of a Level. The same class is used for the full base snapshot of a Level and for the
+ * delta records that are written in between, which only contain the entries that changed since the previous save.
  */
 UCLASS()
 class SAVESYSTEM_API ULevelSaveObject : public USaveGame
@@ -15,11 +19,64 @@ class SAVESYSTEM_API ULevelSaveObject : public USaveGame
 	GENERATED_BODY()
 
 public:
+	/**
+	 * @brief The interacted state of each saved Actor, as a dense array of persistent Ids and a packed bitset
+	 */
+	UPROPERTY()
+	FLevelActorFlags InteractedActors;
+
+	/**
+	 * @brief The saved transform of each moved Actor, keyed by its persistent Id
+	 */
 	UPROPERTY(BlueprintReadOnly)
-	TMap<TObjectPtr<AActor>, bool> InteractedWithActors;
-	
-	UPROPERTY(BlueprintReadOnly)
-	TMap<TObjectPtr<AActor>, FTransform> MovedActors;
+	TMap<FLevelActorId, FTransform> MovedActors;
+
+	/**
+	 * @brief Save MovedActors in the compact quantized layout of FQuantizedActorTransforms rather than at full precision.
+	 * MovedActors itself always holds full transforms in memory, the conversion happens while serializing
+	 */
+	UPROPERTY()
+	bool bQuantizeMovedActors = false;
+
+	/**
+	 * @brief The generation of the base snapshot. Bumped every time the deltas are compacted into a new base, so that
+	 * deltas left over from an older base are never applied on top of a newer one
+	 */
+	UPROPERTY()
+	int32 Generation = 0;
+
+	/**
+	 * @brief Overwrites the entries in this Save Object with the ones from Other
+	 * @param Other The Save Object (usually a delta) to fold into this one
+	 */
+	void MergeFrom(const ULevelSaveObject* Other);
+
+	/**
+	 * @brief Whether this Save Object has no entries at all
+	 */
+	bool IsEmpty() const { return InteractedActors.IsEmpty() && MovedActors.IsEmpty(); }
+
+	/**
+	 * @brief Get the saved interacted state of an Actor
+	 * @return False if the Actor has no saved state
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level Save System")
+	bool GetInteractedState(const FLevelActorId& ActorId, bool& bInteracted) const { return InteractedActors.Find(ActorId, bInteracted); }
+
+	/**
+	 * @brief Moves the interacted states of saves written before the packed layout into it, and converts MovedActors to
+	 * and from the quantized layout
+	 */
+	virtual void Serialize(FArchive& Ar) override;
+
+private:
+
+	UPROPERTY()
+	TMap<FLevelActorId, bool> InteractedWithActors_DEPRECATED;
 
-	
+	/**
+	 * @brief MovedActors as they are saved when bQuantizeMovedActors is set. Only filled while serializing
+	 */
+	UPROPERTY()
+	FQuantizedActorTransforms QuantizedMovedActors;
 };
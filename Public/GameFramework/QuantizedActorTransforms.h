@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/LevelActorId.h"
+#include "QuantizedActorTransforms.generated.h"
+
+/**
+ * A compact, structure of arrays encoding of the transforms of many Level Actors, for saves where props don't need full
+ * precision. Each entry costs 24 bytes: its Id, its position and its rotation.
+ * \n \n
+ * - Position: three integers in steps of PositionStep from Origin, the centre of the encoded positions. Positions
+ * within about 2 billion steps of the centre decode exactly to the step, anything further out is clamped
+ * \n - Rotation: smallest three quaternion, dropping the largest component and storing the other three in 10 bits each,
+ * a step of about 0.0014 per component, which is accurate to about 0.1 degrees in the worst case
+ * \n - Scale: only stored for the entries whose scale isn't 1, which are listed in ScaledIndices
+ * \n \n
+ * Decoding rebuilds the rotations of four entries at a time in vector registers. The lanes are still gathered from the
+ * component arrays, and the positions scaled and transforms assembled, one entry at a time.
+ */
+USTRUCT()
+struct SAVESYSTEM_API FQuantizedActorTransforms
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Replace the contents with the given transforms
+	 * @param InPositionStep The size of a position step, in cm
+	 */
+	void Encode(const TMap<FLevelActorId, FTransform>& Transforms, float InPositionStep = 0.1f);
+
+	/**
+	 * @brief Decode every entry, in the order they were encoded
+	 */
+	void Decode(TArray<FLevelActorId>& OutActorIds, TArray<FTransform>& OutTransforms) const;
+
+	/**
+	 * @brief Decode every entry into a Map, adding to or overwriting what is already in it
+	 */
+	void Decode(TMap<FLevelActorId, FTransform>& OutTransforms) const;
+
+	int32 Num() const { return ActorIds.Num(); }
+
+	bool IsEmpty() const { return ActorIds.IsEmpty(); }
+
+	void Empty();
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	UPROPERTY()
+	FVector Origin = FVector::ZeroVector;
+
+	UPROPERTY()
+	float PositionStep = 0.1f;
+
+	UPROPERTY()
+	TArray<uint64> ActorIds;
+
+	UPROPERTY()
+	TArray<int32> PositionsX;
+
+	UPROPERTY()
+	TArray<int32> PositionsY;
+
+	UPROPERTY()
+	TArray<int32> PositionsZ;
+
+	/**
+	 * @brief The index of the dropped component in the top 2 bits, then the other three components at 10 bits each
+	 */
+	UPROPERTY()
+	TArray<uint32> Rotations;
+
+	/**
+	 * @brief The entries whose scale isn't 1, in increasing order, and their scales
+	 */
+	UPROPERTY()
+	TArray<int32> ScaledIndices;
+
+	UPROPERTY()
+	TArray<FVector3f> Scales;
+};
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "SaveSlotManifest.generated.h"
+
+/**
+ * Describes a single Save Slot on disk without needing to load it
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FSaveSlotManifestEntry
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The Name of the Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Slot Manifest")
+	FString SlotName;
+
+	/**
+	 * @brief When the Slot was last written, in UTC
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Slot Manifest")
+	FDateTime Timestamp;
+
+	/**
+	 * @brief The size of the Slot on disk, in bytes
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Slot Manifest")
+	int64 SizeBytes = 0;
+
+	/**
+	 * @brief The Save Game Class stored in the Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Slot Manifest")
+	FSoftClassPath SaveGameClass;
+
+	/**
+	 * @brief Small game-defined data to show alongside the Slot, for example in a load game menu
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Slot Manifest")
+	TArray<uint8> Metadata;
+};
+
+/**
+ * The Save Slot Manifest is a single small Save Game that indexes every Slot that a Multi Slot Save Subsystem has written,
+ * so that the Slots can be listed with one read rather than by checking or loading each of them.
+ */
+UCLASS()
+class SAVESYSTEM_API USaveSlotManifest : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * @brief Find the entry for a Slot
+	 * @return The entry, or nullptr if the Slot is not in the manifest
+	 */
+	FSaveSlotManifestEntry* FindEntry(const FString& SlotName);
+
+	const FSaveSlotManifestEntry* FindEntry(const FString& SlotName) const;
+
+	/**
+	 * @brief Find the entry for a Slot, adding an empty one if the Slot is not in the manifest yet
+	 */
+	FSaveSlotManifestEntry& FindOrAddEntry(const FString& SlotName);
+
+	/**
+	 * @brief Remove the entry for a Slot
+	 * @return If the Slot was in the manifest
+	 */
+	bool RemoveEntry(const FString& SlotName);
+
+	const TArray<FSaveSlotManifestEntry>& GetEntries() const { return Entries; }
+
+private:
+
+	UPROPERTY()
+	TArray<FSaveSlotManifestEntry> Entries;
+};
@@ -26,5 +26,14 @@ public:
 
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
 	void UpdateActor(bool Interacted);
+
+	/**
+	 * @brief Provides a Guid that identifies this Actor in save data across play sessions. Only needs to be implemented
+	 * by Actors that are spawned at runtime, placed Actors are identified by their Level and name when this returns an invalid Guid
+	 */
+	UFUNCTION(BlueprintNativeEvent, BlueprintCallable)
+	FGuid GetPersistentGuid();
+
+	virtual FGuid GetPersistentGuid_Implementation();
 	
 };
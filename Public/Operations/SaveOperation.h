@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Event.h"
+#include "Serialization/SavePipeline.h"
+#include <atomic>
+#include "SaveOperation.generated.h"
+
+class USaveGame;
+
+/**
+ * Where a Save Operation is in its lifetime
+ */
+UENUM(BlueprintType)
+enum class ESaveOperationState : uint8
+{
+	/** Waiting for its turn on the Slot, or for its debounce window. Only a queued operation can be cancelled */
+	Queued,
+	/** Reading or writing the Slot */
+	Running,
+	Succeeded,
+	Failed,
+	/** Cancelled before it started. The Slot was not touched */
+	Cancelled
+};
+
+/**
+ * A handle to a single async save or load, returned by the Begin functions of the Save Subsystems. It reports the
+ * result of that one request, so callers don't have to pick it out of the shared OnPlayerDataSaved and
+ * OnPlayerDataLoaded Events.
+ * \n \n
+ * Saves are still scheduled: every save requested for a Slot before its write starts is completed by that same write.
+ * \n \n
+ * Callbacks always run on the Game Thread. OnComplete, Then and Cancel must be called from the Game Thread, while the
+ * state can be read and waited on from any thread.
+ */
+class SAVESYSTEM_API FSaveOperation : public TSharedFromThis<FSaveOperation>
+{
+public:
+
+	explicit FSaveOperation(const FString& InSlotName);
+
+	const FString& GetSlotName() const { return SlotName; }
+
+	ESaveOperationState GetState() const { return State.load(); }
+
+	/**
+	 * @brief Whether the operation has succeeded, failed or been cancelled
+	 */
+	bool IsDone() const { return GetState() > ESaveOperationState::Running; }
+
+	bool WasSuccessful() const { return GetState() == ESaveOperationState::Succeeded; }
+
+	/**
+	 * @brief Get the stats of the pass through the Save Pipeline. Only valid once the operation is done
+	 */
+	const FSavePipelineStats& GetStats() const { return Stats; }
+
+	/**
+	 * @brief Get the Save Game Object that was loaded. Only set by successful loads
+	 */
+	USaveGame* GetSaveGame() const { return SaveGame.Get(); }
+
+	/**
+	 * @brief Call a function once the operation is done, or straight away if it already is
+	 * @return This operation, so calls can be chained
+	 */
+	FSaveOperation& OnComplete(TFunction<void(const FSaveOperation&)> Callback);
+
+	/**
+	 * @brief Start another operation once this one is done, whatever its result
+	 * @param Next Given this operation, starts the next one and returns it. Returning nullptr cancels the chain
+	 * @return An operation that finishes with the result of the one Next started. Cancelling it before Next has run
+	 * stops Next from being called, cancelling it afterwards cancels the operation Next started
+	 */
+	TSharedRef<FSaveOperation> Then(TFunction<TSharedPtr<FSaveOperation>(const FSaveOperation&)> Next);
+
+	/**
+	 * @brief Block until the operation is done. On the Game Thread the tasks that finish saves and loads keep running
+	 * while waiting, and a save that is waiting out its debounce window is started straight away. Must not be called on
+	 * the Game Thread from an OnComplete or Then callback, which already runs inside one of those tasks. Doing so fails an
+	 * ensure and returns without waiting
+	 * @param TimeoutSeconds The longest time to wait. Negative waits forever
+	 * @return If the operation is done
+	 */
+	bool Wait(float TimeoutSeconds = -1.f);
+
+	/**
+	 * @brief Cancel the operation if it hasn't started yet
+	 * @return If the operation was cancelled
+	 */
+	bool Cancel();
+
+	/**
+	 * @brief Move from Queued to Running. Called by whatever runs the operation, right before it touches the Slot
+	 * @return False if the operation was cancelled and must not run
+	 */
+	bool Start();
+
+	/**
+	 * @brief Finish the operation. Called by whatever runs the operation. Does nothing if it is already done
+	 */
+	void Complete(bool bSuccess, const FSavePipelineStats& InStats, USaveGame* InSaveGame = nullptr);
+
+	/**
+	 * @brief Set the function Wait calls to make a queued operation start sooner
+	 */
+	void SetExpediteHandler(TFunction<void()> Handler) { ExpediteHandler = MoveTemp(Handler); }
+
+private:
+
+	void Expedite();
+
+	void Finish(ESaveOperationState FinalState, const FSavePipelineStats& InStats, USaveGame* InSaveGame);
+
+	FString SlotName;
+
+	std::atomic<ESaveOperationState> State{ESaveOperationState::Queued};
+
+	FSavePipelineStats Stats;
+
+	TWeakObjectPtr<USaveGame> SaveGame;
+
+	TArray<TFunction<void(const FSaveOperation&)>> Callbacks;
+
+	TFunction<void()> ExpediteHandler;
+
+	/**
+	 * @brief Set on operations created by Then, to pass a cancel on to the operation they are following
+	 */
+	TFunction<bool()> CancelHandler;
+
+	FEventRef DoneEvent{EEventMode::ManualReset};
+};
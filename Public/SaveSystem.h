@@ -5,6 +5,29 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogSaveSystem, Log, Display);
 
+// The most detailed verbosity compiled into each of the high frequency categories below. Anything more detailed is
+// stripped at compile time, arguments and all. Set per configuration in SaveSystem.Build.cs
+#ifndef SAVESYSTEM_LEVEL_LOG_VERBOSITY
+#define SAVESYSTEM_LEVEL_LOG_VERBOSITY All
+#endif
+
+#ifndef SAVESYSTEM_SLOTS_LOG_VERBOSITY
+#define SAVESYSTEM_SLOTS_LOG_VERBOSITY All
+#endif
+
+#ifndef SAVESYSTEM_PIPELINE_LOG_VERBOSITY
+#define SAVESYSTEM_PIPELINE_LOG_VERBOSITY All
+#endif
+
+/** Level Actor tracking, delta writes and restores */
+DECLARE_LOG_CATEGORY_EXTERN(LogSaveSystemLevel, Log, SAVESYSTEM_LEVEL_LOG_VERBOSITY);
+
+/** Per Slot activity of the Multi Slot Subsystem: adding, caching, evicting, saving and loading single Slots */
+DECLARE_LOG_CATEGORY_EXTERN(LogSaveSystemSlots, Log, SAVESYSTEM_SLOTS_LOG_VERBOSITY);
+
+/** The per stage timings of every pass through the Save Pipeline */
+DECLARE_LOG_CATEGORY_EXTERN(LogSaveSystemPipeline, Log, SAVESYSTEM_PIPELINE_LOG_VERBOSITY);
+
 class FSaveSystemModule : public IModuleInterface
 {
 public:
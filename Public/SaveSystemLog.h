@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SaveSystem.h"
+#include <atomic>
+
+/**
+ * Folds a high frequency log line into at most one line per interval (SaveSystem.Log.AggregateSeconds), which reports
+ * how many times the event happened since the last line. The first occurrence is always logged straight away.
+ * \n \n
+ * Use it through SAVESYSTEM_LOG_AGGREGATED rather than directly, which gives every call site its own aggregator.
+ */
+class SAVESYSTEM_API FSaveLogAggregator
+{
+public:
+
+	/**
+	 * @brief Count an occurrence of the event
+	 * @param OutCount Set to the number of occurrences the line being logged stands for
+	 * @return If the line should be logged now
+	 */
+	bool Add(int32& OutCount);
+
+private:
+
+	std::atomic<int32> PendingCount{0};
+
+	std::atomic<double> LastLogTime{0.0};
+};
+
+/**
+ * Logs like UE_LOG, but folds repeats of the line into one line per interval with a count. The line shows the arguments
+ * of the call that logged it, which is the last of the calls it counts, so it reads as "(last of N)". Nothing is
+ * formatted unless the category and verbosity are active, and nothing at all is compiled in past the category's compile
+ * time verbosity
+ */
+#define SAVESYSTEM_LOG_AGGREGATED(CategoryName, Verbosity, Format, ...) \
+	do \
+	{ \
+		if(UE_LOG_ACTIVE(CategoryName, Verbosity)) \
+		{ \
+			static FSaveLogAggregator SaveLogAggregator; \
+			int32 SaveLogCount = 0; \
+			if(SaveLogAggregator.Add(SaveLogCount)) \
+			{ \
+				UE_LOG(CategoryName, Verbosity, Format TEXT(" (last of %d)"), ##__VA_ARGS__, SaveLogCount); \
+			} \
+		} \
+	} while(false)
@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Trace/Trace.h"
+
+/**
+ * Stats and Unreal Insights tracing for the Save System.
+ * \n \n
+ * Every stage of saving and loading is timed as a cycle stat in STATGROUP_SaveSystem ("stat SaveSystem") and as a CPU
+ * scope on the SaveSystem trace channel, which can be turned on with -trace=cpu,SaveSystem. Bytes, queue depth and the
+ * latency of each save and load are traced as counters, and hitches are bookmarked with the Slot that caused them.
+ * Stats are compiled out of Shipping builds, while the trace scopes stay as long as the build has tracing enabled.
+ */
+
+DECLARE_STATS_GROUP(TEXT("Save System"), STATGROUP_SaveSystem, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Snapshot"), STAT_SaveSystem_Snapshot, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Serialize"), STAT_SaveSystem_Serialize, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compress"), STAT_SaveSystem_Compress, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Write"), STAT_SaveSystem_Write, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Read"), STAT_SaveSystem_Read, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decompress"), STAT_SaveSystem_Decompress, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Deserialize"), STAT_SaveSystem_Deserialize, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("OnObjectLoaded"), STAT_SaveSystem_OnObjectLoaded, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Level Restore"), STAT_SaveSystem_LevelRestore, STATGROUP_SaveSystem, SAVESYSTEM_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Written"), STAT_SaveSystem_BytesWritten, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Bytes Read"), STAT_SaveSystem_BytesRead, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Queued Slot Operations"), STAT_SaveSystem_QueuedOperations, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Last Save Latency (ms)"), STAT_SaveSystem_SaveLatency, STATGROUP_SaveSystem, SAVESYSTEM_API);
+DECLARE_FLOAT_ACCUMULATOR_STAT_EXTERN(TEXT("Last Load Latency (ms)"), STAT_SaveSystem_LoadLatency, STATGROUP_SaveSystem, SAVESYSTEM_API);
+
+UE_TRACE_CHANNEL_EXTERN(SaveSystemChannel, SAVESYSTEM_API);
+
+/**
+ * Times the enclosing scope as a Save System cycle stat, and as a CPU scope on the SaveSystem trace channel
+ */
+#define SAVESYSTEM_SCOPE(StatName) \
+	SCOPE_CYCLE_COUNTER(STAT_SaveSystem_##StatName); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("SaveSystem::" #StatName, SaveSystemChannel)
+
+namespace SaveSystemStats
+{
+	SAVESYSTEM_API void RecordBytesWritten(int64 Bytes);
+
+	SAVESYSTEM_API void RecordBytesRead(int64 Bytes);
+
+	/**
+	 * @param Delta The number of operations added to (positive) or taken off (negative) the Slot queues
+	 */
+	SAVESYSTEM_API void RecordQueuedOperations(int32 Delta);
+
+	/**
+	 * @brief Record the time from a save being requested to its write finishing, bookmarking it in the trace if it hitched
+	 */
+	SAVESYSTEM_API void RecordSaveLatency(const FString& SlotName, double LatencyMs);
+
+	/**
+	 * @brief Record the time from a load being queued to the Save Game Object being ready, bookmarking it in the trace if it hitched
+	 */
+	SAVESYSTEM_API void RecordLoadLatency(const FString& SlotName, double LatencyMs);
+}
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SavePipeline.generated.h"
+
+class USaveGame;
+
+/**
+ * The compression applied to Save Game Objects before they are written
+ */
+UENUM(BlueprintType)
+enum class ESaveCompressionCodec : uint8
+{
+	/** Store the serialized bytes as they are */
+	None,
+	/** Oodle Mermaid, cheap enough to run on every save */
+	Fast,
+	/** Oodle Kraken at an optimal level. Much slower to encode, but decodes quickly and suits large, redundant saves */
+	HighRatio
+};
+
+/**
+ * Per-stage statistics for a single pass through the Save Pipeline. All timings are in milliseconds.
+ * Only the Snapshot (save) and Deserialize (load) stages run on the Game Thread.
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FSavePipelineStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief Time spent on the Game Thread copying the Save Game Object into a Snapshot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float SnapshotMs = 0.f;
+
+	/**
+	 * @brief Time spent serializing the Snapshot into bytes
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float SerializeMs = 0.f;
+
+	/**
+	 * @brief Time spent compressing the serialized bytes
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float CompressMs = 0.f;
+
+	/**
+	 * @brief Time spent writing the compressed bytes to the Save Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float WriteMs = 0.f;
+
+	/**
+	 * @brief Time spent reading the bytes from the Save Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float ReadMs = 0.f;
+
+	/**
+	 * @brief Time spent decompressing the bytes read from the Save Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float DecompressMs = 0.f;
+
+	/**
+	 * @brief Time spent on the Game Thread turning the bytes back into a Save Game Object
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	float DeserializeMs = 0.f;
+
+	/**
+	 * @brief Size of the serialized Save Game Object before compression
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	int64 RawBytes = 0;
+
+	/**
+	 * @brief Size of the data that was written to or read from the Save Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	int64 StoredBytes = 0;
+
+	/**
+	 * @brief The compression that was asked for. The bytes are stored uncompressed if compressing them didn't save anything
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	ESaveCompressionCodec Codec = ESaveCompressionCodec::Fast;
+
+	/**
+	 * @brief Whether the write was skipped because the payload was the same as the one already stored in the Slot
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	bool bSkippedUnchanged = false;
+
+	/**
+	 * @brief The hash of the serialized payload and codec, or 0 if nothing was serialized
+	 */
+	uint64 PayloadHash = 0;
+};
+
+/**
+ * How a Save Game Object should be written by the Save Pipeline
+ */
+struct SAVESYSTEM_API FSaveWriteOptions
+{
+	FSaveWriteOptions() = default;
+
+	FSaveWriteOptions(ESaveCompressionCodec InCodec) : Codec(InCodec) {}
+
+	/**
+	 * @brief The compression to apply before writing
+	 */
+	ESaveCompressionCodec Codec = ESaveCompressionCodec::Fast;
+
+	/**
+	 * @brief The hash of the payload that is already stored in the Slot. If the new payload hashes the same, compression
+	 * and the write are skipped and the save still succeeds. 0 always writes
+	 */
+	uint64 SkipIfHash = 0;
+};
+
+/**
+ * The result of loading a single Slot as part of a batch
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FSaveSlotLoadResult
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The Name of the Slot that was loaded
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	FString SlotName;
+
+	/**
+	 * @brief The loaded Save Game Object, or nullptr if the Slot could not be loaded
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	TObjectPtr<USaveGame> SaveGame;
+
+	/**
+	 * @brief If the Slot was read, decompressed and deserialized successfully
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	bool bSuccess = false;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Pipeline")
+	FSavePipelineStats Stats;
+};
+
+DECLARE_DELEGATE_TwoParams(FOnSavePipelineFinished, bool /*bSuccess*/, const FSavePipelineStats& /*Stats*/);
+DECLARE_DELEGATE_TwoParams(FOnLoadPipelineFinished, USaveGame* /*SaveGame*/, const FSavePipelineStats& /*Stats*/);
+DECLARE_DELEGATE_OneParam(FOnLoadBatchPipelineFinished, const TArray<FSaveSlotLoadResult>& /*Results*/);
+DECLARE_DELEGATE_TwoParams(FOnSaveBatchPipelineFinished, bool /*bSuccess*/, const TArray<FSavePipelineStats>& /*Stats*/);
+
+/**
+ * The Save Pipeline moves the expensive parts of saving off the Game Thread. Saving is split into three stages:
+ * \n - Snapshot: a property-wise copy of the Save Game Object, taken on the Game Thread
+ * \n - Serialize + Compress: run on a worker task against the Snapshot
+ * \n - Write: run on the same worker task through the active Save Storage Backend
+ * \n \n
+ * Loading runs the reverse, with only the final deserialization happening on the Game Thread.
+ * Data written by older versions (uncompressed engine save data) is still loaded transparently.
+ */
+class SAVESYSTEM_API FSavePipeline
+{
+public:
+
+	/**
+	 * @brief Snapshot the Save Game Object and serialize, compress and write it on a worker task
+	 * @param SaveGameObject The Save Game Object to save
+	 * @param SlotName The Name of the Slot to save to
+	 * @param UserIndex The User Index to save to
+	 * @param OnFinished Called on the Game Thread when the write has finished
+	 * @param Options The compression to apply, and the hash of the stored payload to skip unchanged writes
+	 * @return If the save was started
+	 */
+	static bool SaveAsync(USaveGame* SaveGameObject, const FString& SlotName, int32 UserIndex, FOnSavePipelineFinished OnFinished,
+		const FSaveWriteOptions& Options = FSaveWriteOptions());
+
+	/**
+	 * @brief Snapshot several Save Game Objects and write them on a worker task as a single batch, which the storage
+	 * backend can commit as one transaction
+	 * @param SaveGameObjects The Save Game Objects to save
+	 * @param SlotNames The Name of the Slot to save each Save Game Object to
+	 * @param UserIndex The User Index to save to
+	 * @param OnFinished Called on the Game Thread when the batch has been written, with the stats of each Slot in order
+	 * @param Options The write options for each Slot. Slots without an entry use the defaults. Unchanged Slots are left
+	 * out of the batch
+	 * @return If the save was started
+	 */
+	static bool SaveBatchAsync(const TArray<USaveGame*>& SaveGameObjects, const TArray<FString>& SlotNames, int32 UserIndex, FOnSaveBatchPipelineFinished OnFinished,
+		const TArray<FSaveWriteOptions>& Options = TArray<FSaveWriteOptions>());
+
+	/**
+	 * @brief Serialize, compress and write the Save Game Object on the calling thread
+	 * @return If the Save Game Object was written successfully
+	 */
+	static bool SaveSync(USaveGame* SaveGameObject, const FString& SlotName, int32 UserIndex, FSavePipelineStats& OutStats,
+		const FSaveWriteOptions& Options = FSaveWriteOptions());
+
+	/**
+	 * @brief Read and decompress the Slot on a worker task, then deserialize it on the Game Thread
+	 * @param OnFinished Called on the Game Thread with the loaded Save Game Object, or nullptr if the load failed
+	 */
+	static void LoadAsync(const FString& SlotName, int32 UserIndex, FOnLoadPipelineFinished OnFinished);
+
+	/**
+	 * @brief Read, decompress and deserialize the Slot on the calling thread
+	 * @return The loaded Save Game Object, or nullptr if the load failed
+	 */
+	static USaveGame* LoadSync(const FString& SlotName, int32 UserIndex, FSavePipelineStats& OutStats);
+
+	/**
+	 * @brief Read and decompress several Slots on up to MaxConcurrency worker tasks at once, then deserialize them all in
+	 * a single pass on the Game Thread
+	 * @param SlotNames The Names of the Slots to load
+	 * @param UserIndex The User Index to load from
+	 * @param MaxConcurrency The maximum number of Slots that are read at the same time
+	 * @param OnFinished Called once on the Game Thread with a result for every Slot, in the same order as SlotNames
+	 */
+	static void LoadBatchAsync(const TArray<FString>& SlotNames, int32 UserIndex, int32 MaxConcurrency, FOnLoadBatchPipelineFinished OnFinished);
+
+	/**
+	 * @brief Create a transient copy of the Save Game Object that can be safely serialized off the Game Thread.
+	 * The copy is rooted, and must be released with ReleaseSnapshot once it is no longer needed.
+	 */
+	static USaveGame* CreateSnapshot(USaveGame* Source);
+
+	static void ReleaseSnapshot(USaveGame* Snapshot);
+
+	/**
+	 * @brief Serialize and compress a Save Game Object into the bytes that are stored in a Slot. If the payload matches
+	 * Options.SkipIfHash, Stats.bSkippedUnchanged is set and OutData is left empty
+	 */
+	static bool EncodePayload(USaveGame* SaveGameObject, TArray<uint8>& OutData, FSavePipelineStats& Stats,
+		const FSaveWriteOptions& Options = FSaveWriteOptions());
+
+	/**
+	 * @brief Compress already serialized Save Game Object bytes into the bytes that are stored in a Slot
+	 */
+	static void CompressPayload(TArray<uint8>&& RawData, TArray<uint8>& OutData, FSavePipelineStats& Stats, ESaveCompressionCodec Codec);
+
+	/**
+	 * @brief Decompress stored Slot bytes in place, leaving the serialized Save Game Object.
+	 * Data without the pipeline header is assumed to already be uncompressed.
+	 */
+	static bool DecodePayload(TArray<uint8>& InOutData, FSavePipelineStats& Stats);
+
+private:
+
+	static USaveGame* DeserializePayload(const TArray<uint8>& Data, FSavePipelineStats& Stats);
+};
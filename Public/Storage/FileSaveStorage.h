@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Storage/SaveStorageBackend.h"
+
+/**
+ * Stores each Slot as a file in a directory on the local filesystem. By default this is the same Saved/SaveGames
+ * directory and .sav naming that the engine uses on desktop platforms, so existing saves keep loading.
+ * \n \n
+ * Writes go to a temporary file that is then renamed over the Slot, so a crash mid-write never leaves a truncated Slot.
+ * Where the platform can't rename over an existing file, the old Slot is moved to a backup first, which reads fall back
+ * to. Reads size the buffer from the file once and read it in a single call.
+ */
+class SAVESYSTEM_API FFileSaveStorage : public ISaveStorageBackend
+{
+public:
+
+	/**
+	 * @param InDirectory The directory to store the Slots in, or empty to use Saved/SaveGames
+	 */
+	explicit FFileSaveStorage(const FString& InDirectory = FString());
+
+	virtual bool Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data) override;
+
+	virtual bool Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData) override;
+
+	virtual bool Exists(const FString& SlotName, int32 UserIndex) override;
+
+	virtual bool Delete(const FString& SlotName, int32 UserIndex) override;
+
+	/**
+	 * @brief Scans the directory and compares the modification time of every Slot file
+	 */
+	virtual bool GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames) override;
+
+	virtual const TCHAR* GetName() const override { return TEXT("File"); }
+
+	/**
+	 * @brief Get the path of the file a Slot is stored in
+	 */
+	FString GetSlotPath(const FString& SlotName, int32 UserIndex) const;
+
+	/**
+	 * @brief Rename a finished file over another, without ever deleting the old file before the new one is in place
+	 * @param Path The file to replace
+	 * @param TempPath The finished file. It is left where it is if the rename fails
+	 * @return If the file was replaced
+	 */
+	static bool ReplaceFile(const FString& Path, const FString& TempPath);
+
+	/**
+	 * @brief Get the path the old file is kept at while ReplaceFile swaps a new one in
+	 */
+	static FString GetBackupPath(const FString& Path);
+
+private:
+
+	FString Directory;
+};
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Storage/SaveStorageBackend.h"
+#include <atomic>
+
+/**
+ * Stores each Slot as a checkpoint file plus an append-only journal of the changes made since, so that frequent saves
+ * of a mostly unchanged Slot only write and flush the bytes that changed.
+ * \n \n
+ * - Checkpoint: the full Slot in Saved/SaveGames/<Slot>.sav, written to a temporary file that is renamed over it. It
+ * has the same layout as a File backend Slot, so either backend can read the other's checkpoints
+ * \n - Journal: <Slot>.journal, starting with the size and CRC of the checkpoint it applies to, followed by one record
+ * per write holding the changed byte ranges. Each record carries a CRC and is flushed to disk before the write returns
+ * \n \n
+ * Reading loads the checkpoint and replays the journal on top of it, stopping at the first torn or corrupt record. A
+ * journal whose header doesn't match the checkpoint is from an older generation and is ignored. Once the journal grows
+ * past the configured limits the next write folds it into a new checkpoint.
+ * \n \n
+ * The last contents of every Slot that was written or read are kept in memory to diff the next write against.
+ * Compressed Slots diff poorly, as a small change moves most of the compressed bytes, so the Save Pipeline writes
+ * uncompressed payloads to this backend. Writes whose change is too large simply checkpoint.
+ */
+class SAVESYSTEM_API FJournaledSaveStorage : public ISaveStorageBackend
+{
+public:
+
+	/**
+	 * @param InDirectory The directory to store the Slots in, or empty to use Saved/SaveGames
+	 * @param InMaxJournalRecords The number of records a journal can hold before the next write checkpoints the Slot
+	 * @param InMaxJournalRatio The size a journal can reach, relative to the Slot, before the next write checkpoints it
+	 */
+	explicit FJournaledSaveStorage(const FString& InDirectory = FString(), int32 InMaxJournalRecords = 64, float InMaxJournalRatio = 0.5f);
+
+	/**
+	 * @brief Checkpoints every Slot with a journal, so the Slots are complete for backends that don't read journals
+	 */
+	virtual ~FJournaledSaveStorage() override;
+
+	virtual bool Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data) override;
+
+	virtual bool Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData) override;
+
+	virtual bool Exists(const FString& SlotName, int32 UserIndex) override;
+
+	virtual bool Delete(const FString& SlotName, int32 UserIndex) override;
+
+	/**
+	 * @brief Scans the directory and compares the modification time of every checkpoint and journal
+	 */
+	virtual bool GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames) override;
+
+	virtual const TCHAR* GetName() const override { return TEXT("Journal"); }
+
+	virtual bool StoresChangesOnly() const override { return true; }
+
+	/**
+	 * @brief Fold the journal of a Slot into a new checkpoint
+	 * @return If the Slot has no journal to fold, or the checkpoint was written
+	 */
+	bool Checkpoint(const FString& SlotName, int32 UserIndex);
+
+	/**
+	 * @brief Fold the journal of every Slot this backend has written into a new checkpoint
+	 */
+	void CheckpointAll();
+
+	/**
+	 * @brief Get the total number of bytes written to checkpoints and journals by this backend
+	 */
+	int64 GetBytesWritten() const { return BytesWritten.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief Get the path of the checkpoint file of a Slot
+	 */
+	FString GetSlotPath(const FString& SlotName, int32 UserIndex) const;
+
+	/**
+	 * @brief Get the path of the journal file of a Slot
+	 */
+	FString GetJournalPath(const FString& SlotName, int32 UserIndex) const;
+
+private:
+
+	/**
+	 * @brief What is known about a single Slot. Each Slot has its own lock, so writes to different Slots don't wait on
+	 * each other's flushes
+	 */
+	struct FSlotJournal
+	{
+		FSlotJournal(const FString& InSlotName, int32 InUserIndex) : SlotName(InSlotName), UserIndex(InUserIndex) {}
+
+		FCriticalSection Lock;
+
+		const FString SlotName;
+
+		const int32 UserIndex;
+
+		/**
+		 * @brief Whether the Slot has been read from disk, or written, since the backend was created
+		 */
+		bool bLoaded = false;
+
+		/**
+		 * @brief The current contents of the Slot, with the journal applied
+		 */
+		TArray<uint8> Contents;
+
+		/**
+		 * @brief The size and CRC of the checkpoint on disk, which the journal header must match
+		 */
+		int32 CheckpointSize = 0;
+
+		uint32 CheckpointCrc = 0;
+
+		/**
+		 * @brief The size of the valid part of the journal, or 0 if the Slot has no journal
+		 */
+		int32 JournalBytes = 0;
+
+		/**
+		 * @brief The number of records in the journal
+		 */
+		int32 JournalRecords = 0;
+
+		/**
+		 * @brief Set when the journal ends in a torn record, so appending to it would be lost on the next read
+		 */
+		bool bJournalTorn = false;
+	};
+
+	TSharedRef<FSlotJournal> FindOrAddSlot(const FString& SlotName, int32 UserIndex);
+
+	/**
+	 * @brief Read the checkpoint of a Slot and replay its journal. The Slot must be locked
+	 */
+	bool LoadSlot(FSlotJournal& Slot);
+
+	/**
+	 * @brief Write the Slot as a new checkpoint and start an empty journal for it. The Slot must be locked
+	 */
+	bool WriteCheckpoint(FSlotJournal& Slot, const TArray<uint8>& Data);
+
+	/**
+	 * @brief Append a record to the journal of a Slot and flush it to disk. The Slot must be locked
+	 */
+	bool AppendRecord(FSlotJournal& Slot, const TArray<uint8>& Record);
+
+	/**
+	 * @brief Write a file to a temporary path, flush it and rename it over the destination
+	 */
+	bool WriteFileAtomic(const FString& Path, const TArray<uint8>& Data);
+
+	static FString MakeKey(const FString& SlotName, int32 UserIndex);
+
+	FString Directory;
+
+	int32 MaxJournalRecords;
+
+	float MaxJournalRatio;
+
+	FCriticalSection SlotsLock;
+
+	TMap<FString, TSharedRef<FSlotJournal>> Slots;
+
+	std::atomic<int64> BytesWritten{0};
+};
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Storage/SaveStorageBackend.h"
+
+/**
+ * Keeps every Slot in memory and never touches the disk. Useful for measuring the cost of serialization on its own,
+ * and for running save heavy automation tests at full speed. Everything is lost when the backend is destroyed.
+ */
+class SAVESYSTEM_API FMemorySaveStorage : public ISaveStorageBackend
+{
+public:
+
+	virtual bool Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data) override;
+
+	virtual bool Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData) override;
+
+	virtual bool Exists(const FString& SlotName, int32 UserIndex) override;
+
+	virtual bool Delete(const FString& SlotName, int32 UserIndex) override;
+
+	virtual const TCHAR* GetName() const override { return TEXT("Memory"); }
+
+	/**
+	 * @brief Remove every stored Slot
+	 */
+	void Reset();
+
+	/**
+	 * @brief Get the total number of bytes stored across all Slots
+	 */
+	int64 GetStoredBytes() const;
+
+private:
+
+	static FString MakeKey(const FString& SlotName, int32 UserIndex);
+
+	mutable FRWLock Lock;
+
+	TMap<FString, TArray<uint8>> Slots;
+};
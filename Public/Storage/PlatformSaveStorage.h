@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Storage/SaveStorageBackend.h"
+
+class ISaveGameSystem;
+
+/**
+ * Stores Slots through the platform Save Game System, the same as UGameplayStatics does. This is the backend to use on
+ * platforms that require saves to go through their own APIs.
+ */
+class SAVESYSTEM_API FPlatformSaveStorage : public ISaveStorageBackend
+{
+public:
+
+	FPlatformSaveStorage();
+
+	virtual bool Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data) override;
+
+	virtual bool Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData) override;
+
+	virtual bool Exists(const FString& SlotName, int32 UserIndex) override;
+
+	virtual bool Delete(const FString& SlotName, int32 UserIndex) override;
+
+	virtual const TCHAR* GetName() const override { return TEXT("Platform"); }
+
+private:
+
+	ISaveGameSystem* SaveGameSystem = nullptr;
+};
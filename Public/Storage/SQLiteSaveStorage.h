@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Storage/SaveStorageBackend.h"
+
+#if WITH_SAVESYSTEM_SQLITE
+
+class FSQLiteDatabase;
+class FSQLitePreparedStatement;
+
+/**
+ * Stores every Slot as a row in a single SQLite database file, rather than a file per Slot. Meant for servers that
+ * manage thousands of Slots, where opening and scanning that many files costs more than the saves themselves.
+ * \n \n
+ * Slots are looked up through the primary key on the Slot Name, batches are written in a single transaction, and the
+ * modification time is indexed so "modified since" queries don't have to touch every Slot.
+ * \n \n
+ * Only built when bWithSQLite is enabled in SaveSystem.Build.cs.
+ */
+class SAVESYSTEM_API FSQLiteSaveStorage : public ISaveStorageBackend
+{
+public:
+
+	/**
+	 * @param InDatabasePath The database file to use, or empty to use Saved/SaveGames/Slots.db
+	 */
+	explicit FSQLiteSaveStorage(const FString& InDatabasePath = FString());
+
+	virtual ~FSQLiteSaveStorage() override;
+
+	virtual bool Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data) override;
+
+	virtual bool Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData) override;
+
+	virtual bool Exists(const FString& SlotName, int32 UserIndex) override;
+
+	virtual bool Delete(const FString& SlotName, int32 UserIndex) override;
+
+	virtual bool WriteBatch(const TArray<TPair<FString, TArray<uint8>>>& Slots, int32 UserIndex) override;
+
+	virtual bool GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames) override;
+
+	virtual const TCHAR* GetName() const override { return TEXT("SQLite"); }
+
+	/**
+	 * @brief Whether the database was opened successfully
+	 */
+	bool IsOpen() const;
+
+private:
+
+	/**
+	 * @brief Binds and runs the write statement for a single Slot. The lock must already be held
+	 */
+	bool WriteLocked(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data, int64 ModifiedTicks);
+
+	/**
+	 * @brief A single connection is shared by every thread, so every use of the database goes through this lock
+	 */
+	FCriticalSection Lock;
+
+	TUniquePtr<FSQLiteDatabase> Database;
+
+	TUniquePtr<FSQLitePreparedStatement> WriteStatement;
+
+	TUniquePtr<FSQLitePreparedStatement> ReadStatement;
+
+	TUniquePtr<FSQLitePreparedStatement> ExistsStatement;
+
+	TUniquePtr<FSQLitePreparedStatement> DeleteStatement;
+
+	TUniquePtr<FSQLitePreparedStatement> ModifiedSinceStatement;
+};
+
+#endif
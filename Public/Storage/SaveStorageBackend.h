@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Where the bytes of a Save Slot are stored. Every Save Subsystem and the Save Pipeline go through the active backend
+ * rather than talking to the platform Save Game System directly, so storage can be swapped without touching them.
+ * \n \n
+ * All functions can be called from worker tasks, so implementations must be thread safe.
+ */
+class SAVESYSTEM_API ISaveStorageBackend
+{
+public:
+
+	virtual ~ISaveStorageBackend() = default;
+
+	/**
+	 * @brief Write the bytes of a Slot, replacing anything already stored in it
+	 * @return If the bytes were written
+	 */
+	virtual bool Write(const FString& SlotName, int32 UserIndex, const TArray<uint8>& Data) = 0;
+
+	/**
+	 * @brief Read the bytes of a Slot
+	 * @return If the Slot exists and was read
+	 */
+	virtual bool Read(const FString& SlotName, int32 UserIndex, TArray<uint8>& OutData) = 0;
+
+	virtual bool Exists(const FString& SlotName, int32 UserIndex) = 0;
+
+	/**
+	 * @brief Delete a Slot
+	 * @return If the Slot existed and was deleted
+	 */
+	virtual bool Delete(const FString& SlotName, int32 UserIndex) = 0;
+
+	/**
+	 * @brief Write several Slots at once. Backends that support it write them as a single transaction, so either all of
+	 * them are written or none are. The default writes them one at a time
+	 * @return If every Slot was written
+	 */
+	virtual bool WriteBatch(const TArray<TPair<FString, TArray<uint8>>>& Slots, int32 UserIndex);
+
+	/**
+	 * @brief Find the Slots that were written at or after a point in time
+	 * @param Since The earliest modification time, in UTC
+	 * @param OutSlotNames The Names of the Slots that were modified
+	 * @return If the backend supports the query
+	 */
+	virtual bool GetSlotsModifiedSince(const FDateTime& Since, int32 UserIndex, TArray<FString>& OutSlotNames) { return false; }
+
+	/**
+	 * @brief Whether the backend only stores what changed between writes. Compression moves most of the bytes on every
+	 * change, so the Save Pipeline writes uncompressed payloads to these backends whatever codec was asked for
+	 */
+	virtual bool StoresChangesOnly() const { return false; }
+
+	/**
+	 * @brief Get the name of the backend, for logging
+	 */
+	virtual const TCHAR* GetName() const = 0;
+};
+
+/**
+ * Access to the active Save Storage Backend
+ */
+class SAVESYSTEM_API FSaveStorage
+{
+public:
+
+	/**
+	 * @brief Get the active backend. Callers that hand it to a worker task should keep the returned reference, so that
+	 * swapping the backend can't pull it out from under the task
+	 */
+	static TSharedRef<ISaveStorageBackend> Get();
+
+	/**
+	 * @brief Replace the active backend. Passing nullptr goes back to the default for the platform
+	 */
+	static void SetBackend(TSharedPtr<ISaveStorageBackend> Backend);
+
+	/**
+	 * @brief Create the default backend for the platform. That is the File backend on desktop platforms, and the
+	 * platform Save Game System everywhere else
+	 */
+	static TSharedRef<ISaveStorageBackend> CreateDefaultBackend();
+};
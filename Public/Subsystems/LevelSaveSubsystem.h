@@ -3,16 +3,81 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameFramework/LevelActorRegistry.h"
 #include "GameFramework/LevelSaveObject.h"
 #include "GameFramework/SaveGame.h"
+#include "Serialization/SavePipeline.h"
 #include "Subsystems/WorldSubsystem.h"
 #include "LevelSaveSubsystem.generated.h"
 
+class ULevel;
+class USceneComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnLevelRestoreProgress, int32, RestoredActors, int32, TotalActors);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnLevelRestoreComplete);
+
 /**
- * 
+ * A single spatial cell of a partitioned Level save, and where it is in being loaded and written
+ */
+USTRUCT()
+struct FLevelSaveCell
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The saved state of the Actors in the cell. Created empty as soon as the cell is needed, so changes can be
+	 * recorded straight away, and merged over what is on disk once that has loaded
+	 */
+	UPROPERTY()
+	TObjectPtr<ULevelSaveObject> Data;
+
+	/**
+	 * @brief The number of Actors in the World whose state is kept in this cell. The cell is written and released once
+	 * the last of them streams out
+	 */
+	int32 ResidentActors = 0;
+
+	bool bLoading = false;
+
+	/**
+	 * @brief Set when the cell's Slot exists but could not be read. The cell is then never written, as that would replace
+	 * everything saved in it with only the changes made since. It is loaded again the next time it is needed
+	 */
+	bool bLoadFailed = false;
+
+	/**
+	 * @brief Set when the cell has changed since it was last written
+	 */
+	bool bDirty = false;
+
+	bool bWriteInFlight = false;
+
+	/**
+	 * @brief Set when a write was asked for while the cell was loading or already being written
+	 */
+	bool bWritePending = false;
+};
+
+/**
+ * The Level Save Subsystem saves the state of the Actors in a Level.
+ * \n \n
+ * Rather than rewriting the whole Level every time, only the Actors that changed since the last save are written as a
+ * small delta record. Once enough deltas have built up they are compacted back into a single base snapshot.
+ * \n \n
+ * Restoring the loaded state can be spread across several frames, so that a Level with thousands of saved Actors
+ * doesn't spike the frame time when it begins play.
+ * \n \n
+ * The state of a Level is handed to the Level State Cache when its World is torn down, so travelling back to it restores
+ * from memory, and whatever wasn't saved yet is written back in the background.
+ * \n \n
+ * Large streamed Worlds can instead partition their save into square cells, each stored whole in its own Slot. An
+ * Actor's state lives in the cell it was in when it first streamed in, so a cell is loaded and restored when the
+ * Actors in it stream in, and written back and released once the last of them streams out. Cells used by Actors that
+ * never stream out, such as those in the persistent Level or spawned ones, stay resident until the World is torn down
+ * and are written then.
  */
 UCLASS(Abstract, NotBlueprintType)
-class SAVESYSTEM_API ULevelSaveSubsystem : public UWorldSubsystem
+class SAVESYSTEM_API ULevelSaveSubsystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 public:
@@ -21,31 +86,437 @@ public:
 
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override { return IsRestoring(); }
+
+	virtual TStatId GetStatId() const override;
+
 	virtual void UpdateActors(AActor* SavedActor, bool bInteracted);
 
 	virtual void UpdateMovedActors(TObjectPtr<AActor> SavedActor, FTransform Transform);
-	
+
+	/**
+	 * @brief Saves the Actors that changed since the last save as a delta, or compacts everything into a new base
+	 * snapshot once MaxDeltasBeforeCompaction deltas have been written
+	 */
 	UFUNCTION(BlueprintCallable)
 	void SaveData();
 
+	/**
+	 * @brief Writes the full Level state as a new base snapshot and removes the deltas that it replaces
+	 */
+	UFUNCTION(BlueprintCallable)
+	void CompactSaveData();
+
 	UFUNCTION(BlueprintCallable)
 	void LoadData();
-	
+
+	/**
+	 * @brief The number of delta records that can be written before they are compacted into a new base snapshot
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System")
+	int32 MaxDeltasBeforeCompaction = 16;
+
+	/**
+	 * @brief The compression applied to the base snapshot. Level saves are large and very repetitive, and the base is
+	 * only written on compaction, so it is worth spending longer on a better ratio
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Compression")
+	ESaveCompressionCodec CompressionCodec = ESaveCompressionCodec::HighRatio;
+
+	/**
+	 * @brief The compression applied to delta records, which are small and written on every save
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Compression")
+	ESaveCompressionCodec DeltaCompressionCodec = ESaveCompressionCodec::Fast;
+
+	/**
+	 * @brief Save moved Actor transforms quantized, to about 1 mm and 0.05 degrees, at under a third of the size. Meant
+	 * for Levels full of props, leave it off where Actors have to be restored exactly
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Compression")
+	bool bQuantizeMovedActors = false;
+
+	/**
+	 * @brief Store the Level save in spatial cells that are loaded and released as the Actors in them stream in and out,
+	 * rather than in one Slot that is loaded whole when the World begins play. Must be set before the World begins play.
+	 * Saves written with and without cells are not read by the other
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Cells")
+	bool bPartitionIntoCells = false;
+
+	/**
+	 * @brief The width of a cell in cm. Best matched to the streaming grid of the World, so a cell is loaded along with
+	 * the Actors in it
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Cells")
+	float CellSize = 25600.f;
+
+	/**
+	 * @brief Get the cell that contains a location
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level Save System|Cells")
+	FIntPoint GetCellAt(const FVector& Location) const;
+
+	/**
+	 * @brief Get the number of cells that are loaded, or still being loaded or written
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level Save System|Cells")
+	int32 GetResidentCellCount() const { return Cells.Num(); }
+
+	/**
+	 * @brief Keep the state of the Level in the Level State Cache of the Game Instance when leaving it, and restore from
+	 * there when coming back. Not used by partitioned saves, whose cells already stream. Off by default, so Levels are
+	 * loaded from disk every time unless a project opts in
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Cache")
+	bool bCacheLevelState = false;
+
+	/**
+	 * @brief If the loaded state should be restored over several frames rather than all at once. Off by default, so the
+	 * saved state is fully applied as soon as it has been loaded, as it always has been
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Restore")
+	bool bTimeSlicedRestore = false;
+
+	/**
+	 * @brief The number of milliseconds per frame that a time sliced restore is allowed to spend updating Actors
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level Save System|Restore")
+	float RestoreBudgetMs = 2.f;
+
+	/**
+	 * @brief Event Dispatcher for each frame of a restore, and passes how many of the saved Actors have been restored so far
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Save System|Event Dispatchers|Level Save System")
+	FOnLevelRestoreProgress OnRestoreProgress;
+
+	/**
+	 * @brief Event Dispatcher for when all the saved Actors have been restored
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Save System|Event Dispatchers|Level Save System")
+	FOnLevelRestoreComplete OnRestoreComplete;
+
+	/**
+	 * @brief Whether the loaded state is still being applied to the Actors in the Level
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level Save System|Restore")
+	bool IsRestoring() const { return TransformCursor < PendingTransforms.Num() || RestoreCursor < PendingRestoreCount || !RestoreQueue.IsEmpty(); }
+
+	/**
+	 * @brief Whether a base snapshot or a delta of the Level is being written
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level Save System")
+	bool IsSaving() const { return bSaveInFlight; }
+
+	/**
+	 * @brief Whether the state of the Level has been loaded with all its deltas. Applying it to the Actors can still be
+	 * running. A Level partitioned into cells is loaded cell by cell instead, and never counts as loaded
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level Save System")
+	bool IsLoaded() const { return bStateLoaded; }
+
+	/**
+	 * @brief Moves a batch of Scene Components to their saved transforms, one time slice of the restore. Each move is
+	 * teleported, so physics neither sweeps nor derives a velocity from it
+	 * @param Batch The Scene Components and the transforms to move them to
+	 * @return The number of Scene Components that were moved
+	 */
+	static int32 ApplyTransformBatch(TArrayView<const TPair<TWeakObjectPtr<USceneComponent>, FTransform>> Batch);
+
+	/**
+	 * @brief Get the name of the Save Slot used for a delta record of a Level
+	 * @param LevelSlotName The Save Slot of the Level's base snapshot
+	 * @param DeltaIndex The index of the delta record
+	 */
+	static FString MakeDeltaSlotName(const FString& LevelSlotName, int32 DeltaIndex);
+
 protected:
 
 	UFUNCTION()
 	virtual void OnAsyncLoadFinished(const FString& SlotName, const int32 UserIndex, USaveGame* SaveGame);
-		
+
 	UFUNCTION()
 	virtual void OnAsyncSaveFinished(const FString& SlotName, const int32 UserIndex, bool bSuccess);
 
+	/**
+	 * @brief Applies the loaded Level state to the Actors in the Level
+	 */
+	virtual void ApplyLevelSaveObject();
+
+	/**
+	 * @brief Rebuilds the registry of live Actors from all the Actors in the World that implement ILevelSaveInterface. From
+	 * then on it is kept up to date as Actors spawn, stream in and out, and are destroyed
+	 * @param bIncludeMovableActors If Movable Actors should be registered as well, so that saved transforms can be restored to them
+	 */
+	void BuildActorIndex(bool bIncludeMovableActors = false);
+
+	/**
+	 * @brief Finds the live Actor for a persistent Id
+	 * @param ActorId The persistent Id of the Actor
+	 * @return The Actor, or nullptr if no live Actor has that Id
+	 */
+	AActor* ResolveActor(const FLevelActorId& ActorId) const;
+
+	/**
+	 * @brief Get the name of the Save Slot used for a delta record
+	 * @param DeltaIndex The index of the delta record
+	 */
+	FString GetDeltaSlotName(int32 DeltaIndex) const;
+
+	/**
+	 * @brief Get the name of the Save Slot used for a cell of a partitioned Level save
+	 */
+	FString GetCellSlotName(const FIntPoint& Cell) const;
+
 	FString LevelSaveSlot = "LevelSlot";
-	
+
 private:
 
+	/**
+	 * @brief Lets the cache finish a write back it started before the Level was loaded again, and a write this Subsystem
+	 * started before handing the state to the cache
+	 */
+	friend class ULevelStateCacheSubsystem;
+
+	/**
+	 * @brief Take the state of the Level from the Level State Cache, along with what is on disk for it
+	 * @return False if the Level isn't cached
+	 */
+	bool LoadFromCache();
+
+	void WriteBase();
+
+	void WriteDelta();
+
+	void LoadDelta(int32 DeltaIndex);
+
+	void OnBaseLoaded(USaveGame* SaveGame, const FSavePipelineStats& Stats);
+
+	void OnDeltaLoaded(USaveGame* SaveGame, const FSavePipelineStats& Stats, int32 DeltaIndex);
+
+	void OnBaseSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, int32 PreviousGeneration);
+
+	void OnDeltaSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, FString DeltaSlotName);
+
+	/**
+	 * @brief Make the delegate a write of the Level's state finishes through. It goes to this Subsystem while it still
+	 * has the state, and to the Level State Cache once the state has been checked in, even if the World is gone by then
+	 * @param DeltaSlotName The Slot of the delta being written, or empty for a base snapshot
+	 * @param PreviousGeneration The generation of the state before a base snapshot started a new one
+	 */
+	FOnSavePipelineFinished MakeWriteFinishedDelegate(const FString& DeltaSlotName, int32 PreviousGeneration);
+
+	void FinishSave();
+
+	/**
+	 * @brief Resolves the moved Actors of a Save Object and queues its state to be applied, behind any restore that is
+	 * already running
+	 */
+	void BeginRestore(ULevelSaveObject* Source);
+
+	/**
+	 * @brief Get the Save Object that holds the state of an Actor, which is about to be changed. For partitioned saves
+	 * this is the Actor's cell, which is loaded if it isn't already
+	 */
+	ULevelSaveObject* GetSaveObjectForUpdate(const AActor* Actor, const FLevelActorId& ActorId);
+
+	/**
+	 * @brief Registers the Actors of every visible Level and loads the cells they are in
+	 */
+	void LoadCells();
+
+	/**
+	 * @brief Writes every cell that changed since it was last written
+	 */
+	void SaveCells();
+
+	/**
+	 * @brief Waits for the cells that are loading or being written, then writes every cell that is still dirty. Called
+	 * when the World is torn down, as cells that are still in use would never be written otherwise
+	 */
+	void WriteCellsSync();
+
+	/**
+	 * @brief Registers the saveable Actors of a Level that streamed in, loading their cells or restoring them from the
+	 * state that is already loaded
+	 */
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	/**
+	 * @brief Unregisters the Actors of a Level that streamed out, releasing the cells they were the last of
+	 */
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+
+	/**
+	 * @brief Registers a saveable Actor that spawned after the registry was built, restoring its saved state if it has any
+	 */
+	void OnActorSpawned(AActor* Actor);
+
+	void OnActorDestroyed(AActor* Actor);
+
+	/**
+	 * @brief Adds an Actor to the registry. Its saved state, if it has any that is loaded, is added to Restore
+	 * @param Restore The Save Object to restore the Actor from, created if it is null
+	 */
+	void RegisterActor(AActor* Actor, ULevelSaveObject*& Restore);
+
+	/**
+	 * @brief Removes an Actor from the registry
+	 * @param OutEmptiedCells The cells that no longer have any Actors in them, once the Actor is gone
+	 */
+	void UnregisterActor(const AActor* Actor, TSet<FIntPoint>& OutEmptiedCells);
+
+	/**
+	 * @brief Get a cell, adding it and starting to load it from its Slot if it isn't resident
+	 */
+	FLevelSaveCell& FindOrLoadCell(const FIntPoint& Cell);
+
+	void OnCellLoaded(USaveGame* SaveGame, const FSavePipelineStats& Stats, FIntPoint Cell);
+
+	void WriteCell(const FIntPoint& Cell);
+
+	void OnCellSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, FIntPoint Cell);
+
+	/**
+	 * @brief Write the cell back if it changed and drop it, once no Actors in the World are using it
+	 */
+	void ReleaseCell(const FIntPoint& Cell);
+
+	/**
+	 * @brief Restores pending Actors until they have all been restored or the budget runs out
+	 * @param BudgetSeconds The time that can be spent, or a negative value to restore everything
+	 */
+	void ProcessRestore(double BudgetSeconds);
 
 	UPROPERTY()
 	TObjectPtr<ULevelSaveObject> LevelSaveObject;
-	
-	
+
+	/**
+	 * @brief The Actors whose interacted state changed since the last save
+	 */
+	TSet<FLevelActorId> DirtyInteractedActors;
+
+	/**
+	 * @brief The Actors whose transform changed since the last save
+	 */
+	TSet<FLevelActorId> DirtyMovedActors;
+
+	/**
+	 * @brief The live Actors that can have saved state, used to resolve saved entries in O(1)
+	 */
+	FLevelActorRegistry ActorRegistry;
+
+	/**
+	 * @brief Set once the registry has been built, after which it is kept up to date rather than rebuilt. Levels streamed
+	 * in and Actors spawned before that are picked up when it is built
+	 */
+	bool bRegistryBuilt = false;
+
+	/**
+	 * @brief Whether Movable Actors that don't implement ILevelSaveInterface are registered as well
+	 */
+	bool bRegistryIncludesMovable = false;
+
+	/**
+	 * @brief The Root Components of moved Actors and the saved transforms that are waiting to be applied to them
+	 */
+	TArray<TPair<TWeakObjectPtr<USceneComponent>, FTransform>> PendingTransforms;
+
+	/**
+	 * @brief The index of the next entry in PendingTransforms to apply
+	 */
+	int32 TransformCursor = 0;
+
+	/**
+	 * @brief The time spent applying transforms during the current restore
+	 */
+	double TransformRestoreSeconds = 0.0;
+
+	/**
+	 * @brief The Save Object whose interacted states are being applied to their Actors. Held on to separately from
+	 * LevelSaveObject, which a load can replace while the restore is still running
+	 */
+	UPROPERTY()
+	TObjectPtr<ULevelSaveObject> RestoreSource;
+
+	/**
+	 * @brief The Save Objects waiting for RestoreSource to finish, such as cells that loaded during a restore
+	 */
+	UPROPERTY()
+	TArray<TObjectPtr<ULevelSaveObject>> RestoreQueue;
+
+	/**
+	 * @brief The number of entries of RestoreSource to apply. Entries added after the restore started are left alone
+	 */
+	int32 PendingRestoreCount = 0;
+
+	/**
+	 * @brief The number of entries applied from earlier sources during the current restore
+	 */
+	int32 CompletedRestoreCount = 0;
+
+	/**
+	 * @brief The index of the next entry of RestoreSource to apply
+	 */
+	int32 RestoreCursor = 0;
+
+	/**
+	 * @brief The number of delta records currently stored on disk after the base snapshot
+	 */
+	int32 StoredDeltaCount = 0;
+
+	/**
+	 * @brief Whether a base snapshot exists on disk for the deltas to be applied on top of
+	 */
+	bool bBaseOnDisk = false;
+
+	/**
+	 * @brief Set when a delta could not be written, so the next save writes a full base instead
+	 */
+	bool bForceCompaction = false;
+
+	bool bSaveInFlight = false;
+
+	bool bSavePending = false;
+
+	/**
+	 * @brief Set once the base snapshot and all its deltas have been folded into LevelSaveObject. Until then it only holds
+	 * part of the Level's state, which must not be handed to the cache
+	 */
+	bool bStateLoaded = false;
+
+	/**
+	 * @brief Set once the state has been handed to the Level State Cache as the World is torn down. From then on the
+	 * state is the cache's, and so is finishing a write that is still running
+	 */
+	bool bStateCheckedIn = false;
+
+	/**
+	 * @brief Set while the World is being torn down, so that cells which finish loading aren't restored any more
+	 */
+	bool bShuttingDown = false;
+
+	/**
+	 * @brief The resident cells of a partitioned Level save
+	 */
+	UPROPERTY()
+	TMap<FIntPoint, FLevelSaveCell> Cells;
+
+	/**
+	 * @brief The cell each registered Actor keeps its state in. Fixed when the Actor is first seen, so an Actor that moves
+	 * keeps its state in the cell that is loaded along with it
+	 */
+	TMap<FLevelActorId, FIntPoint> ActorCells;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle LevelRemovedHandle;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	FDelegateHandle ActorDestroyedHandle;
 };
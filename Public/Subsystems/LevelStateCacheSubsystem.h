@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/SavePipeline.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Subsystems/MultiSlotSaveSubsystem.h"
+#include "Tickable.h"
+#include "LevelStateCacheSubsystem.generated.h"
+
+class ULevelSaveObject;
+class ULevelSaveSubsystem;
+
+/**
+ * The state of a Level held by the Level State Cache, along with what is known about the Level's Slots on disk
+ */
+USTRUCT()
+struct SAVESYSTEM_API FLevelStateCacheEntry
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The full state of the Level, with every delta folded in
+	 */
+	UPROPERTY()
+	TObjectPtr<ULevelSaveObject> State;
+
+	/**
+	 * @brief The estimated memory used by State, taken when the Level was left
+	 */
+	int64 EstimatedBytes = 0;
+
+	/**
+	 * @brief When the entry was last used, to pick the least recently used one to evict
+	 */
+	uint64 LastAccess = 0;
+
+	/**
+	 * @brief Whether a base snapshot of the Level is on disk, and how many delta records follow it
+	 */
+	bool bBaseOnDisk = false;
+
+	int32 StoredDeltaCount = 0;
+
+	/**
+	 * @brief The compression the Level Save Subsystem writes its base snapshot with
+	 */
+	ESaveCompressionCodec Codec = ESaveCompressionCodec::HighRatio;
+
+	/**
+	 * @brief Set when State has changes that aren't on disk yet
+	 */
+	bool bDirty = false;
+
+	/**
+	 * @brief When the entry was last made dirty
+	 */
+	double DirtyTime = 0.0;
+
+	bool bWriteInFlight = false;
+
+	/**
+	 * @brief Set while the write in flight is one the Level Save Subsystem started before checking the state in, which
+	 * the cache then finishes
+	 */
+	bool bCheckedInWriteInFlight = false;
+
+	/**
+	 * @brief Set when the entry was picked for eviction while it still had to be written back
+	 */
+	bool bEvictAfterWrite = false;
+
+	/**
+	 * @brief The Level Save Subsystem using the entry, while its Level is loaded. That Subsystem is in charge of writing
+	 * the state until it checks the entry back in
+	 */
+	TWeakObjectPtr<ULevelSaveSubsystem> Owner;
+};
+
+/**
+ * Keeps the state of recently visited Levels in memory across level travel, so that returning to a Level restores it
+ * straight away rather than going back to disk.
+ * \n \n
+ * A Level Save Subsystem checks its Level's state out when the World begins play, and back in when the World is torn
+ * down. Changes that weren't saved by then are written back in the background once they have had WriteBackDelaySeconds
+ * to settle, as a new base snapshot that replaces the Level's deltas. Once the cached states go over MemoryBudgetBytes the
+ * least recently used ones are evicted, after being written back if they have to be.
+ */
+UCLASS()
+class SAVESYSTEM_API ULevelStateCacheSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+public:
+
+	/**
+	 * @brief Writes back every dirty Level before the Game Instance shuts down
+	 */
+	virtual void Deinitialize() override;
+
+	/**
+	 * @brief Only ticks while a Level is waiting to be written back
+	 */
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override { return DirtyEntries > 0; }
+
+	virtual TStatId GetStatId() const override;
+
+	/**
+	 * @brief Get the cache of the Game Instance a World belongs to
+	 * @return The cache, or nullptr if the World has no Game Instance
+	 */
+	static ULevelStateCacheSubsystem* Get(const UWorld* World);
+
+	/**
+	 * @brief Hand the cached state of a Level to the Level Save Subsystem that is loading it
+	 * @param SlotName The Slot of the Level
+	 * @param Owner The Level Save Subsystem that takes over writing the state, including any unsaved changes
+	 * @param OutEntry The cached state and what is on disk for it
+	 * @return False if the Level isn't cached
+	 */
+	bool CheckOut(const FString& SlotName, ULevelSaveSubsystem* Owner, FLevelStateCacheEntry& OutEntry);
+
+	/**
+	 * @brief Hand the state of a Level back to the cache as the Level is left
+	 * @param SlotName The Slot of the Level
+	 * @param State The full state of the Level
+	 * @param bBaseOnDisk Whether a base snapshot of the Level is on disk
+	 * @param StoredDeltaCount The number of delta records on disk, not counting one that is still being written
+	 * @param bWriteInFlight Whether the Level Save Subsystem still has a write of the state running. The cache holds
+	 * back its own writes until that one has finished, and finishes it in the Subsystem's place
+	 * @param bUnsaved Whether the state has changes that aren't on disk, which the cache then writes back
+	 * @param Codec The compression to write the state back with
+	 */
+	void CheckIn(const FString& SlotName, ULevelSaveObject* State, bool bBaseOnDisk, int32 StoredDeltaCount, bool bWriteInFlight, bool bUnsaved,
+		ESaveCompressionCodec Codec);
+
+	/**
+	 * @brief Start writing back every dirty Level that isn't loaded, without waiting for WriteBackDelaySeconds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Level State Cache")
+	void FlushDirtyLevels();
+
+	/**
+	 * @brief Drop every cached Level that isn't loaded or still has to be written back
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Level State Cache")
+	void ClearCache();
+
+	/**
+	 * @brief Get the hit, miss and eviction counters of the cache
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Level State Cache")
+	FSaveSlotCacheStats GetCacheStats() const { return CacheStats; }
+
+	/**
+	 * @brief The estimated memory the cached Levels are allowed to use. The least recently used Levels that aren't loaded
+	 * are evicted once this is exceeded
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level State Cache")
+	int64 MemoryBudgetBytes = 32 * 1024 * 1024;
+
+	/**
+	 * @brief How long a left Level stays dirty before it is written back, so that travelling straight back to it doesn't
+	 * cost a write
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Level State Cache")
+	float WriteBackDelaySeconds = 5.f;
+
+private:
+
+	/**
+	 * @brief Lets a Level Save Subsystem hand over a write that finishes after it checked its state in
+	 */
+	friend class ULevelSaveSubsystem;
+
+	/**
+	 * @brief Finish a write that a Level Save Subsystem started before checking its state in. Passed on to the Subsystem
+	 * that has checked the Level out since, if there is one
+	 * @param DeltaSlotName The Slot of the delta that was written, or empty for a base snapshot
+	 */
+	void OnCheckedInWriteFinished(bool bSuccess, const FSavePipelineStats& Stats, const FString& SlotName, const FString& DeltaSlotName, int32 PreviousGeneration);
+
+	/**
+	 * @brief Write the state of a Level that isn't loaded as a new base snapshot, in a new generation so the deltas it
+	 * replaces are never applied on top of it
+	 */
+	void WriteBack(const FString& SlotName);
+
+	void OnWriteBackFinished(bool bSuccess, const FSavePipelineStats& Stats, FString SlotName, int32 PreviousGeneration, int32 DeltaCount);
+
+	/**
+	 * @brief Evicts the least recently used Levels until the cache fits in the budget. Dirty Levels are written back first
+	 */
+	void EnforceBudget();
+
+	void Evict(const FString& SlotName);
+
+	void SetDirty(FLevelStateCacheEntry& Entry, bool bDirty);
+
+	static int64 EstimateBytes(const ULevelSaveObject* State);
+
+	UPROPERTY()
+	TMap<FString, FLevelStateCacheEntry> Entries;
+
+	FSaveSlotCacheStats CacheStats;
+
+	uint64 AccessCounter = 0;
+
+	/**
+	 * @brief The number of entries with bDirty set, so the cache only ticks while there is something to write
+	 */
+	int32 DirtyEntries = 0;
+};
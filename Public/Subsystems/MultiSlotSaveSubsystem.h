@@ -3,10 +3,80 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "GameFramework/SaveSlotManifest.h"
 #include "Subsystems/SaveSubsystem.h"
 #include "MultiSlotSaveSubsystem.generated.h"
 
+/**
+ * A Slot known to the Multi Slot Save Subsystem. The Save Game Object is held strongly while the Slot is resident,
+ * and is released again when the Slot is evicted from the cache.
+ */
+USTRUCT()
+struct SAVESYSTEM_API FSaveSlotCacheEntry
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The Save Game Object for the Slot, or nullptr if the Slot is not resident
+	 */
+	UPROPERTY()
+	TObjectPtr<USaveGame> SaveGame;
+
+	/**
+	 * @brief The estimated memory used by the Save Game Object, based on its serialized size
+	 */
+	int64 EstimatedBytes = 0;
+
+	/**
+	 * @brief When the Slot was last accessed, used to pick the least recently used Slot to evict
+	 */
+	uint64 LastAccess = 0;
+
+	/**
+	 * @brief Whether the Save Game Object has changed since it was last saved or loaded, in which case it is written
+	 * back before being evicted. Set for new Slots, failed writes, the Slot that stops being Active and by MarkSlotDirty
+	 */
+	bool bDirty = false;
+};
+
+/**
+ * Counters for the Slot cache of the Multi Slot Save Subsystem
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FSaveSlotCacheStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The number of Slot accesses that found the Slot resident
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Multi Slot Save System|Slot Cache")
+	int32 Hits = 0;
+
+	/**
+	 * @brief The number of Slot accesses that had to go to disk
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Multi Slot Save System|Slot Cache")
+	int32 Misses = 0;
+
+	/**
+	 * @brief The number of Slots that were evicted to stay within the budget
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Multi Slot Save System|Slot Cache")
+	int32 Evictions = 0;
+
+	/**
+	 * @brief The number of Slots currently resident
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Multi Slot Save System|Slot Cache")
+	int32 ResidentSlots = 0;
 
+	/**
+	 * @brief The estimated memory used by the resident Slots
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Multi Slot Save System|Slot Cache")
+	int64 ResidentBytes = 0;
+};
 
 /**
  * The Multi Slot Save Subsystem is a Save Subsystem that uses multiple Save Slots rather than a single one. This is useful for games that have multiple players, or for games that need to save multiple save files.
@@ -21,10 +91,13 @@ class SAVESYSTEM_API UMultiSlotSaveSubsystem : public USaveSubsystem
 	DECLARE_DYNAMIC_MULTICAST_SPARSE_DELEGATE_OneParam(FMultiSlotSaveSubsystemSlotAdded, UMultiSlotSaveSubsystem, OnSlotAdded, FString, SlotName);
 	DECLARE_DYNAMIC_MULTICAST_SPARSE_DELEGATE_OneParam(FMultiSlotSaveSubsystemSlotRemoved, UMultiSlotSaveSubsystem, OnSlotRemoved, FString, SlotName);
 	DECLARE_DYNAMIC_MULTICAST_SPARSE_DELEGATE_OneParam(FMultiSlotSaveSubsystemSaveCreated, UMultiSlotSaveSubsystem, OnSaveCreated, FString, SlotName);
+	DECLARE_DYNAMIC_MULTICAST_SPARSE_DELEGATE_OneParam(FMultiSlotSaveSubsystemSlotsLoaded, UMultiSlotSaveSubsystem, OnSlotsLoaded, const TArray<FSaveSlotLoadResult>&, Results);
 
 	
 public:
 
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
 	virtual void Deinitialize() override;
 
 	virtual FString GetPlayerSaveSlot() override
@@ -59,6 +132,12 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Save System|Event Dispatchers|Multi Slot Save System")
 	FMultiSlotSaveSubsystemSaveCreated OnSaveCreated;
 
+	/**
+	 * @brief Event Dispatcher for when a batch of Slots started by LoadSlots has finished, with a result for every Slot
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Save System|Event Dispatchers|Multi Slot Save System")
+	FMultiSlotSaveSubsystemSlotsLoaded OnSlotsLoaded;
+
 #pragma endregion 
 
 #pragma region Add Slot
@@ -118,7 +197,8 @@ public:
 	 * @param bAsync If the Save Game Object should be saved asynchronously or not
 	 * @param bVerbose If the function should print out to the log
 	 * @return If the Save Game Object was saved successfully. If Async is true, this will always return true.
-	 * You'll need to check the OnPlayerDataSaved Event to see if it was successful
+	 * You'll need to check the OnPlayerDataSaved Event to see if it was successful. Async saves are scheduled, so repeated
+	 * calls for the same Slot are collapsed into a single write
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Save Slot")
 	bool SaveSlot(FString SlotName, bool bAsync = true);
@@ -133,6 +213,23 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Save Slot")
 	bool SaveActiveSlot(bool bAsync = true);
 
+	/**
+	 * @brief Save several resident Slots to the Disk as a single batch. Storage backends that support it write the batch
+	 * as one transaction, so either every Slot is saved or none are
+	 * @param SlotNames The Names of the Slots to save
+	 * @return If the batch was started. Each Slot still reports its result through the OnPlayerDataSaved Event
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Save Slot")
+	bool SaveSlotBatch(const TArray<FString>& SlotNames);
+
+	/**
+	 * @brief Save a resident Slot asynchronously, like SaveSlot
+	 * @param SlotName The Name of the Slot to save
+	 * @return A handle that completes with the result of the write that includes this save. It fails straight away if
+	 * the Slot isn't resident
+	 */
+	TSharedRef<FSaveOperation> BeginSaveSlot(const FString& SlotName);
+
 #pragma endregion 
 
 #pragma region Load Slot
@@ -142,7 +239,8 @@ public:
 	 * @brief Load a Save Game Object, this will not set the Active Slot or call the OnSlotAdded Event. If the Slot is not found in the TMap,
 	 * it will attempt to load it from the Disk if it exists. If it does not exist on the Disk, it will return false
 	 * @param SlotName The Name of the Slot to load
-	 * @param bAsync If the Save Game Object should be loaded asynchronously or not
+	 * @param bAsync If the Save Game Object should be loaded asynchronously or not. A synchronous load first waits for the
+	 * saves still queued or scheduled on the Slot
 	 * @return If the Save Game Object was loaded successfully. If Async is true, this will always return true.
 	 * You'll need to check the OnPlayerDataLoaded Event to see if it was successful
 	 */
@@ -151,7 +249,8 @@ public:
 
 	/**
 	 * @brief Load the Active Slot in the Save System, this will not set the Active Slot or call the OnSlotAdded Event
-	 * @param bAsync If the Save Game Object should be loaded asynchronously or not
+	 * @param bAsync If the Save Game Object should be loaded asynchronously or not. A synchronous load first waits for the
+	 * saves still queued or scheduled on the Slot
 	 * @return If the Save Game Object was loaded successfully. If Async is true, this will always return true.
 	 * You'll need to check the OnPlayerDataLoaded Event to see if it was successful
 	 */
@@ -167,6 +266,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Load Slot")
 	bool LoadSlotFromDisk(FString SlotName);
 
+	/**
+	 * @brief Load several Save Game Objects from the Disk at once. The Slots are read and decompressed in parallel, and
+	 * OnSlotsLoaded is called once when all of them have finished. This will not set the Active Slot or call the OnSlotAdded Event
+	 * @param SlotNames The Names of the Slots to load from the Disk
+	 * @param MaxConcurrency The maximum number of Slots that are read at the same time
+	 * @return If the batch was started
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Load Slot")
+	bool LoadSlots(const TArray<FString>& SlotNames, int32 MaxConcurrency = 8);
+
+	/**
+	 * @brief Load a Slot asynchronously, like LoadSlot. Slots that aren't resident are loaded from the Disk and cached
+	 * @param SlotName The Name of the Slot to load
+	 * @return A handle that completes with the loaded Save Game Object. It fails straight away if the Slot is neither
+	 * resident nor on the Disk
+	 */
+	TSharedRef<FSaveOperation> BeginLoadSlot(const FString& SlotName);
+
 #pragma endregion
 
 	/**
@@ -188,8 +305,7 @@ public:
 
 	
 	/**
-	 * @brief Get All the Save Slots in the Save System
-	 * @param bVerbose If the function should print out to the log
+	 * @brief Get All the resident Save Slots in the Save System
 	 * @return An Array of Save Game Objects
 	 */
 	UFUNCTION(BlueprintPure, Category = "Save System|Multi Slot Save System")
@@ -201,6 +317,75 @@ public:
 	 */
 	UFUNCTION(BlueprintPure, Category = "Save System|Multi Slot Save System")
 	TArray<FString> GetAllSaveSlotNames() const;
+
+	/**
+	 * @brief Get the Names of the Slots that were saved at or after a point in time. Asks the storage backend when it can
+	 * answer the query itself, and falls back to the timestamps in the Slot Manifest otherwise
+	 * @param Since The earliest save time, in UTC
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System")
+	TArray<FString> GetSlotNamesModifiedSince(FDateTime Since) const;
+
+#pragma region Slot Cache
+
+	/**
+	 * @brief Marks a resident Slot as changed, so that it is written back before it is evicted. Call this after changing a
+	 * Slot other than the Active Slot without saving it, as the Slot cache cannot see changes made to its Save Game Objects
+	 * @param SlotName The Name of the Slot
+	 * @return If the Slot is resident
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Slot Cache")
+	bool MarkSlotDirty(const FString& SlotName);
+
+	/**
+	 * @brief Get the hit, miss and eviction counters of the Slot cache
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Multi Slot Save System|Slot Cache")
+	FSaveSlotCacheStats GetSlotCacheStats() const;
+
+	/**
+	 * @brief The estimated memory that resident Slots are allowed to use. The least recently used Slots are evicted once
+	 * this is exceeded, apart from the Active Slot and Slots with a save scheduled, which are always kept resident
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Multi Slot Save System|Slot Cache")
+	int64 SlotCacheBudgetBytes = 64 * 1024 * 1024;
+
+#pragma endregion
+
+#pragma region Slot Manifest
+
+	/**
+	 * @brief Get the manifest entries of every Slot that has been written, without loading any of them
+	 * @return An Array of Slot Manifest Entries
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Multi Slot Save System|Slot Manifest")
+	TArray<FSaveSlotManifestEntry> GetSlotManifestEntries() const;
+
+	/**
+	 * @brief Get the manifest entry of a single Slot
+	 * @param SlotName The Name of the Slot
+	 * @param OutEntry The manifest entry of the Slot, if it was found
+	 * @return If the Slot is in the manifest
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Multi Slot Save System|Slot Manifest")
+	bool GetSlotManifestEntry(const FString& SlotName, FSaveSlotManifestEntry& OutEntry) const;
+
+	/**
+	 * @brief Store a small game-defined blob alongside a Slot in the manifest, such as the data to show for it in a load game menu
+	 * @param SlotName The Name of the Slot
+	 * @param Metadata The data to store
+	 * @return If the Slot is in the manifest
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Multi Slot Save System|Slot Manifest")
+	bool SetSlotMetadata(const FString& SlotName, const TArray<uint8>& Metadata);
+
+	/**
+	 * @brief The Name of the Slot that the manifest is stored in
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Multi Slot Save System|Slot Manifest")
+	FString ManifestSlotName = "SlotManifest";
+
+#pragma endregion
 	
 protected:
 	
@@ -220,16 +405,92 @@ protected:
 	 */
 	UFUNCTION(BlueprintPure, Category = "Save System|Multi Slot Save System")
 	USaveGame* GetActiveSaveSlot();
+
+	/**
+	 * @brief Is called when an async Slot save is finished. Updates the manifest before handing over to OnSavePipelineFinished
+	 * @param WriteKind Whether the write was started by the save scheduler, or queued as a batch or a write back
+	 */
+	void OnSlotSaveFinished(bool bSuccess, const FSavePipelineStats& Stats, FString SlotName, ESlotWriteKind WriteKind);
+
+	/**
+	 * @brief Loads the manifest from disk, or creates an empty one if there is none yet
+	 */
+	void LoadManifest();
+
+	/**
+	 * @brief Records that a Slot was written, and writes the manifest
+	 * @param SlotName The Name of the Slot
+	 * @param SaveGame The Save Game Object in the Slot, used to record its class
+	 * @param SizeBytes The size of the Slot on disk, or a negative value to leave it unchanged
+	 */
+	void UpdateManifestEntry(const FString& SlotName, const USaveGame* SaveGame, int64 SizeBytes);
+
+	/**
+	 * @brief Writes the manifest asynchronously. Requests made while a write is in flight are folded into one follow up write
+	 */
+	void WriteManifest();
 	
 public:
 	virtual USaveGame* GetSaveGameObject(const TSubclassOf<USaveGame> SaveGameClass) override;
 
 	virtual USaveGame* GetRawSaveGameObject() override;
 protected:
+	virtual void OnLoadPipelineFinished(USaveGame* SaveGame, const FSavePipelineStats& Stats, FString SlotName) override;
+
+	virtual USaveGame* GetSaveGameForSlot(const FString& SlotName) override;
+
+	/**
+	 * @brief Is called when a Slot started by LoadSlotFromDisk has been loaded. Caches the Slot and calls the OnPlayerDataLoaded Event
+	 */
+	void OnSlotLoadedFromDisk(USaveGame* LoadedSaveGame, const FSavePipelineStats& Stats, FString SlotName);
+
+	/**
+	 * @brief Is called when a batch started by LoadSlots has finished. Caches every loaded Slot before broadcasting OnSlotsLoaded
+	 */
+	void OnSlotsBatchLoaded(const TArray<FSaveSlotLoadResult>& Results);
+
+	/**
+	 * @brief Runs the pre-save logic on a resident Slot and writes it through the Save Pipeline
+	 * @param SlotName The Name of the Slot to write
+	 * @param bAsync If the write should happen on a worker task
+	 * @return If the write succeeded, or for async writes if it was started
+	 */
+	bool WriteSlot(const FString& SlotName, bool bAsync);
+
+	/**
+	 * @brief Is called when a batch started by SaveSlotBatch has been written, and finishes each Slot in the batch
+	 */
+	void OnSlotBatchSaveFinished(bool bSuccess, const TArray<FSavePipelineStats>& Stats, TArray<FString> SlotNames);
+
+	/**
+	 * @brief Makes a Save Game Object resident for a Slot, and evicts other Slots if that goes over the budget
+	 * @param SlotName The Name of the Slot
+	 * @param SaveGame The Save Game Object for the Slot
+	 * @param EstimatedBytes The estimated memory used by the Save Game Object
+	 */
+	void CacheSlot(const FString& SlotName, USaveGame* SaveGame, int64 EstimatedBytes);
+
+	/**
+	 * @brief Get the resident Save Game Object for a Slot, without counting it as an access
+	 */
+	USaveGame* GetResidentSlot(const FString& SlotName) const;
+
+	/**
+	 * @brief Get the resident Save Game Object for a Slot for a caller outside the Slot cache, counting a hit or a miss
+	 * and marking it as recently used
+	 */
+	USaveGame* AccessSlot(const FString& SlotName);
+
+	/**
+	 * @brief Evicts the least recently used Slots until the resident Slots fit in the budget. Dirty Slots are written back first
+	 */
+	void EnforceSlotCacheBudget();
+
 	/**
 	 * @brief The Map of Save Slots in the Save System
 	 */
-	TMap<FString, TWeakObjectPtr<USaveGame>> SaveSlots;
+	UPROPERTY()
+	TMap<FString, FSaveSlotCacheEntry> SaveSlots;
 
 	/**
 	 * @brief The Index of the Active Slot in the Save System
@@ -237,9 +498,24 @@ protected:
 	FString CurrentSaveSlot = "";
 
 	/**
-	 * @brief Test array to see if the Save Game is being created properly and to make sure there were no memory leaks.
+	 * @brief The counters of the Slot cache
 	 */
-	TArray<TWeakObjectPtr<USaveGame>> CreatedSaveGames;
+	FSaveSlotCacheStats SlotCacheStats;
+
+	/**
+	 * @brief Increases every time a Slot is accessed, to order the Slots by how recently they were used
+	 */
+	uint64 SlotAccessCounter = 0;
+
+	/**
+	 * @brief The index of every Slot that has been written
+	 */
+	UPROPERTY()
+	TObjectPtr<USaveSlotManifest> SlotManifest;
+
+	bool bManifestWriteInFlight = false;
+
+	bool bManifestWritePending = false;
 };
 
 
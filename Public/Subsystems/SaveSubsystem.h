@@ -5,13 +5,116 @@
 #include "CoreMinimal.h"
 
 #include "SaveSystem.h"
+#include "Operations/SaveOperation.h"
+#include "Serialization/SavePipeline.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Tickable.h"
 #include "SaveSubsystem.generated.h"
 
 class USaveGame;
+class ISaveStorageBackend;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPlayerDataLoaded, USaveGame*, PlayerSaveObject);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPlayerDataSaved, bool, bSuccess);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnSaveStatsReported, FString, SlotName, FSavePipelineStats, Stats);
+
+/**
+ * How an async write to a Slot was started, which decides what it finishes once it is done
+ */
+enum class ESlotWriteKind : uint8
+{
+	// Started outside the Slot's operation queue, so it finishes nothing
+	Unqueued,
+	// An operation in the Slot's queue, such as a batch or a write back, which completes that operation
+	Queued,
+	// The write started by the save scheduler, which also finishes the scheduled save
+	Scheduled
+};
+
+/**
+ * Counters for the per-slot save scheduler, to compare how many saves were asked for against how many were written
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FSaveSchedulerStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The number of async save requests received
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Scheduler")
+	int32 RequestsReceived = 0;
+
+	/**
+	 * @brief The number of writes that were actually started
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Scheduler")
+	int32 WritesPerformed = 0;
+
+	/**
+	 * @brief The number of requests that were folded into a write that was already scheduled
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Scheduler")
+	int32 RequestsCoalesced = 0;
+
+	/**
+	 * @brief The number of writes that were skipped because the Slot already held exactly the same payload
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Scheduler")
+	int32 WritesSkippedUnchanged = 0;
+};
+
+/**
+ * What the autosave scheduler has done, and what it has cost the Game Thread
+ */
+USTRUCT(BlueprintType)
+struct SAVESYSTEM_API FAutosaveStats
+{
+	GENERATED_BODY()
+
+	/**
+	 * @brief The number of autosaves that were started
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	int32 AutosavesRun = 0;
+
+	/**
+	 * @brief The number of autosaves that had to wait for the frame time or a blocker when they were due
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	int32 AutosavesDeferred = 0;
+
+	/**
+	 * @brief The number of autosaves that ran anyway because they reached the maximum delay
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	int32 AutosavesForced = 0;
+
+	/**
+	 * @brief When the last autosave ran, in UTC
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	FDateTime LastAutosaveTime;
+
+	/**
+	 * @brief How many seconds after it was due the last autosave ran
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	float LastDelaySeconds = 0.f;
+
+	/**
+	 * @brief The Game Thread time spent starting the last autosave, which covers the pre-save logic and the Snapshot
+	 * unless a write to the Slot was already in flight
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	float LastGameThreadMs = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	float MaxGameThreadMs = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Save System|Autosave")
+	float TotalGameThreadMs = 0.f;
+};
 
 /**
  * The Save Subsystem is a Game Instance Subsystem that handles the saving and loading of the Player Data. It is a base class that should be extended to add functionality.
@@ -19,7 +122,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPlayerDataSaved, bool, bSuccess);
  * It needs to be both Abstract and NotBlueprintType because it is a base class but we don't want it to be used directly, nor do we want it to automatically be created.
  */
 UCLASS(Abstract, NotBlueprintType)
-class SAVESYSTEM_API USaveSubsystem : public UGameInstanceSubsystem
+class SAVESYSTEM_API USaveSubsystem : public UGameInstanceSubsystem, public FTickableGameObject
 {
 	GENERATED_BODY()
 public:
@@ -27,6 +130,20 @@ public:
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 
 	virtual void Deinitialize() override;
+
+	/**
+	 * @brief Only ticks while autosave is running, to check whether an autosave is due and the frame is quiet enough
+	 */
+	virtual void Tick(float DeltaTime) override;
+
+	virtual bool IsTickable() const override { return bAutosaveRunning; }
+
+	/**
+	 * @brief Ticks with the world of the Game Instance, so that autosaves follow its game time and pause with it
+	 */
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	virtual TStatId GetStatId() const override;
 	
 	/**
 	 * @brief Event Dispatcher for when the Player Data is loaded, and passes the Save Game Object
@@ -40,6 +157,12 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Save System|Event Dispatchers")
 	FOnPlayerDataSaved OnPlayerDataSaved;
 
+	/**
+	 * @brief Event Dispatcher for when a save has gone through the Save Pipeline, and passes the time spent in each stage
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Save System|Event Dispatchers")
+	FOnSaveStatsReported OnSaveStatsReported;
+
 	/**
 	 * @brief Creates a New Save Game, and overwrites the old one if it exists
 	 */
@@ -53,11 +176,24 @@ public:
 	void SaveData(bool bAsync = true);
 
 	/**
-	 * @brief Loads the Player Data from the Save Slot. Creates a new instance if the current one is invalid or non existent
+	 * @brief Loads the Player Data from the Save Slot. Creates a new instance if the current one is invalid or non existent.
+	 * A synchronous load first waits for the saves still queued or scheduled on the Slot
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Save System")
 	void LoadData(bool bAsync = true);
 
+	/**
+	 * @brief Saves the Player Data asynchronously, like SaveData
+	 * @return A handle that completes with the result of the write that includes this save
+	 */
+	TSharedRef<FSaveOperation> BeginSaveData();
+
+	/**
+	 * @brief Loads the Player Data asynchronously, like LoadData
+	 * @return A handle that completes with the loaded Save Game Object
+	 */
+	TSharedRef<FSaveOperation> BeginLoadData();
+
 	/**
 	 * @brief Clears the Save Slot of all data, and deletes the current Player Save Object. Use with caution!
 	 * @param bVerbose 
@@ -83,6 +219,10 @@ public:
 	UFUNCTION()
 	virtual void OnAsyncSaveFinished(const FString& SlotName, const int32 UserIndex, bool bSuccess);
 
+	/**
+	 * @brief Writes the Player Save Object to the Player Save Slot straight away, outside the save scheduler and the
+	 * Slot's operation queue. SaveData is what goes through both
+	 */
 	UFUNCTION()
 	virtual void OnPreSaveObjectComplete(bool bAsyncSave);
 	
@@ -134,6 +274,111 @@ public:
 	UFUNCTION(BlueprintPure)
 	TSubclassOf<USaveGame> GetSaveGameClass();
 
+	/**
+	 * @brief Get the per-stage timings of the last save that went through the Save Pipeline
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Pipeline")
+	FSavePipelineStats GetLastSaveStats() const { return LastSaveStats; }
+
+	/**
+	 * @brief Get the per-stage timings of the last load that went through the Save Pipeline
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Pipeline")
+	FSavePipelineStats GetLastLoadStats() const { return LastLoadStats; }
+
+	/**
+	 * @brief Get the counters of the save scheduler
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Scheduler")
+	FSaveSchedulerStats GetSaveSchedulerStats() const { return SaveSchedulerStats; }
+
+	/**
+	 * @brief The compression applied to Slots saved by this Subsystem, unless the Slot has its own codec set
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Compression")
+	ESaveCompressionCodec CompressionCodec = ESaveCompressionCodec::Fast;
+
+	/**
+	 * @brief Override the compression for a single Slot
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Compression")
+	void SetSlotCompressionCodec(const FString& SlotName, ESaveCompressionCodec Codec);
+
+	/**
+	 * @brief Remove the compression override of a Slot, so it goes back to using CompressionCodec
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Compression")
+	void ClearSlotCompressionCodec(const FString& SlotName);
+
+	/**
+	 * @brief Get the compression that will be applied when a Slot is saved
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Compression")
+	ESaveCompressionCodec GetSlotCompressionCodec(const FString& SlotName) const;
+
+	/**
+	 * @brief Whether a Slot has an operation running or waiting in its operation queue
+	 */
+	UFUNCTION(BlueprintPure, Category = "Save System|Scheduler")
+	bool HasPendingSlotOperations(const FString& SlotName) const { return SlotOperationQueues.Contains(SlotName); }
+
+	/**
+	 * @brief Async save requests for the same Slot that arrive within this many seconds of each other are collapsed into
+	 * a single write. Zero writes straight away, while still collapsing requests made during an in-flight write
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Scheduler")
+	float SaveDebounceSeconds = 0.5f;
+
+#pragma region Autosave
+
+	/**
+	 * @brief Start saving the Player Data every AutosaveIntervalSeconds. The first autosave is due one interval from now
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Autosave")
+	void StartAutosave();
+
+	UFUNCTION(BlueprintCallable, Category = "Save System|Autosave")
+	void StopAutosave();
+
+	UFUNCTION(BlueprintPure, Category = "Save System|Autosave")
+	bool IsAutosaveRunning() const { return bAutosaveRunning; }
+
+	/**
+	 * @brief Hold back autosaves while a gameplay state is active, such as combat or a cutscene. Autosaves that are due
+	 * wait until every blocker is removed, or until they reach AutosaveMaxDelaySeconds. Blockers are counted, so every
+	 * call has to be matched by a call to RemoveAutosaveBlocker with the same Reason
+	 * @param Reason The gameplay state, so that several states can block at once
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Save System|Autosave")
+	void AddAutosaveBlocker(FName Reason);
+
+	UFUNCTION(BlueprintCallable, Category = "Save System|Autosave")
+	void RemoveAutosaveBlocker(FName Reason);
+
+	UFUNCTION(BlueprintPure, Category = "Save System|Autosave")
+	FAutosaveStats GetAutosaveStats() const { return AutosaveStats; }
+
+	/**
+	 * @brief The time between autosaves, in game time. Time spent paused doesn't count
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Autosave")
+	float AutosaveIntervalSeconds = 300.f;
+
+	/**
+	 * @brief An autosave that is due waits while the smoothed Game Thread time of recent frames is above this many
+	 * milliseconds. Zero never waits for the frame time
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Autosave")
+	float AutosaveFrameBudgetMs = 20.f;
+
+	/**
+	 * @brief The longest an autosave can wait for the frame time or a blocker before it runs anyway
+	 */
+	UPROPERTY(BlueprintReadWrite, Category = "Save System|Autosave")
+	float AutosaveMaxDelaySeconds = 30.f;
+
+#pragma endregion
+
 protected:
 	/**
 	 * @brief Assigns the Save Game Object for the Player, and calls the OnPlayerDataLoaded Event
@@ -141,8 +386,272 @@ protected:
 	 * @return Whether the Assignment was valid or not
 	 */
 	bool AssignSaveGameObject(USaveGame* SaveGameObject);
+
+	/**
+	 * @brief Runs the pre-save logic on the Player Save Object and writes it to a Slot
+	 * @param bAsync If the write should go through the async Save Pipeline
+	 * @param SlotName The Slot to write, fixed when the save was requested
+	 * @return For synchronous writes, whether the Slot was written. Async writes report through OnSavePipelineFinished
+	 */
+	bool SavePlayerData(bool bAsync, const FString& SlotName);
+
+	/**
+	 * @brief Writes the Player Save Object to a Slot, once its pre-save logic has run
+	 * @param bScheduled If the write was started by the save scheduler, as the running operation of the Slot's queue
+	 * @return For synchronous writes, whether the Slot was written. Async writes report through OnSavePipelineFinished
+	 */
+	bool WritePlayerData(bool bAsync, const FString& SlotName, bool bScheduled);
+
+	/**
+	 * @brief Creates a new Player Save Object, for when there is nothing in the Slot to load
+	 */
+	void CreatePlayerData(const FString& SlotName, TSharedPtr<FSaveOperation> Operation);
+
+	/**
+	 * @brief Loads the Player Save Slot, or creates a new Save Game Object if it doesn't exist
+	 * @param bAsync If the load should go through the async Save Pipeline
+	 * @param Operation The handle to complete with the result, if the caller asked for one
+	 */
+	void LoadPlayerData(bool bAsync, TSharedPtr<FSaveOperation> Operation);
+
+	/**
+	 * @brief Is called when an async save through the Save Pipeline is finished. Records the stats and calls OnAsyncSaveFinished
+	 * @param WriteKind How the write was started. Only the scheduler's own write finishes the scheduled save, as a batch
+	 * or a write back ahead of it in the Slot's queue finishes while the scheduled write is still waiting its turn
+	 */
+	void OnSavePipelineFinished(bool bSuccess, const FSavePipelineStats& Stats, FString SlotName, ESlotWriteKind WriteKind);
+
+	/**
+	 * @brief Is called when an async load through the Save Pipeline is finished. Records the stats and calls OnAsyncLoadFinished
+	 */
+	virtual void OnLoadPipelineFinished(USaveGame* SaveGame, const FSavePipelineStats& Stats, FString SlotName);
+
+	/**
+	 * @brief Records and broadcasts the stats of a save that went through the Save Pipeline
+	 */
+	void ReportSaveStats(const FString& SlotName, const FSavePipelineStats& Stats);
+
+	/**
+	 * @brief Schedules an async write of a Slot. Requests inside the debounce window collapse into one write, and a request
+	 * made while a write to the Slot is in flight schedules exactly one follow-up write once it has finished
+	 * @param SlotName The Name of the Slot to write
+	 * @param StartWrite Starts the write when it is due, and returns false if it could not be started. The write must call
+	 * FinishScheduledSave when it is done. When the Subsystem shuts down inside the debounce window it is called with
+	 * bAsync false instead, to write the Slot before returning whether it was written
+	 * @param Operation The handle to complete with the result of the write, if the caller asked for one
+	 */
+	void RequestSave(const FString& SlotName, TFunction<bool(bool bAsync)> StartWrite, TSharedPtr<FSaveOperation> Operation = nullptr);
+
+	/**
+	 * @brief Marks the scheduled write to a Slot as finished, completes the handles waiting on it, and starts the
+	 * follow-up write if one was requested meanwhile
+	 */
+	void FinishScheduledSave(const FString& SlotName, bool bSuccess, const FSavePipelineStats& Stats);
+
+	/**
+	 * @brief Whether a Slot has a save waiting out its debounce window, in flight, or queued as a follow-up
+	 */
+	bool HasScheduledSave(const FString& SlotName) const;
+
+	/**
+	 * @brief Writes the save scheduled for a Slot now, and waits for it along with everything else queued on the Slot, so
+	 * a synchronous read of the Slot sees the same data an async load queued at this point would
+	 * @return False if it gave up waiting, in which case the Slot may still be written after it is read
+	 */
+	bool WaitForSlotWrites(const FString& SlotName);
+
+	/**
+	 * @brief Adds an operation to the queue of a Slot. Operations on the same Slot run strictly in the order they were
+	 * queued, while operations on different Slots run in parallel
+	 * @param SlotName The Name of the Slot the operation reads or writes
+	 * @param StartOperation Starts the operation. Returns true if it is still running, in which case it must call
+	 * CompleteSlotOperation when done, or false if it has already finished
+	 */
+	void EnqueueSlotOperation(const FString& SlotName, TFunction<bool()> StartOperation);
+
+	/**
+	 * @brief Marks the running operation on a Slot as complete and starts the next one in its queue
+	 */
+	void CompleteSlotOperation(const FString& SlotName);
+
+	/**
+	 * @brief Queues an async load of a Slot through the Save Pipeline
+	 * @param SlotName The Name of the Slot to load
+	 * @param OnLoaded Called on the Game Thread with the loaded Save Game Object, or nullptr if the load failed
+	 * @param Operation The handle to complete once OnLoaded has run. A handle cancelled before its turn skips the load
+	 */
+	void EnqueueSlotLoad(const FString& SlotName, TFunction<void(USaveGame*, const FSavePipelineStats&)> OnLoaded,
+		TSharedPtr<FSaveOperation> Operation = nullptr);
+
+	/**
+	 * @brief Starts an async load of a Slot from an operation that already holds the Slot's turn. Completes the operation
+	 * once OnLoaded has run
+	 * @param QueuedTime When the load was queued, in platform seconds
+	 */
+	void StartSlotLoad(const FString& SlotName, TFunction<void(USaveGame*, const FSavePipelineStats&)> OnLoaded,
+		TSharedPtr<FSaveOperation> Operation, double QueuedTime);
+
+	/**
+	 * @brief Creates a handle for an operation on a Slot. Handles that haven't finished when the Subsystem is
+	 * deinitialized are failed, so nothing waits on them forever
+	 */
+	TSharedRef<FSaveOperation> MakeTrackedOperation(const FString& SlotName);
+
+	/**
+	 * @brief Saves whatever autosave covers. The default saves the Player Data, and starts the write straight away
+	 * instead of waiting out the debounce window, so the cost lands on the frame autosave chose
+	 */
+	virtual void PerformAutosave();
+
+	/**
+	 * @brief Get the options to write a Slot with: its compression codec, and the hash of the payload last written to it
+	 * so that an unchanged save can skip the write
+	 */
+	FSaveWriteOptions GetSlotWriteOptions(const FString& SlotName) const;
+
+	/**
+	 * @brief Remembers the hash of the payload that was written to a Slot, or forgets it if the write failed
+	 */
+	void RecordSlotWrite(const FString& SlotName, bool bSuccess, const FSavePipelineStats& Stats);
+
+	/**
+	 * @brief Forgets the hash of the payload written to a Slot, so the next save always writes. Call this when the Slot
+	 * is deleted
+	 */
+	void ForgetSlotWrite(const FString& SlotName);
+
+	/**
+	 * @brief Get the Save Game Object that a Slot is saved from and loaded into
+	 * @param SlotName The Name of the Slot
+	 * @return The Save Game Object, or nullptr if the Slot doesn't have one in memory
+	 */
+	virtual USaveGame* GetSaveGameForSlot(const FString& SlotName);
+
+	/**
+	 * @brief The stats of the last save that went through the Save Pipeline
+	 */
+	FSavePipelineStats LastSaveStats;
+
+	/**
+	 * @brief The stats of the last load that went through the Save Pipeline
+	 */
+	FSavePipelineStats LastLoadStats;
 	
 private:
+	/**
+	 * @brief The scheduling state of a single Slot
+	 */
+	struct FSlotSaveSchedule
+	{
+		FTimerHandle DebounceTimer;
+		TFunction<bool(bool)> StartWrite;
+		bool bWriteInFlight = false;
+		bool bFollowUpPending = false;
+
+		/**
+		 * @brief The handles that will be completed by the next write, and by the write in flight
+		 */
+		TArray<TSharedRef<FSaveOperation>> WaitingOperations;
+		TArray<TSharedRef<FSaveOperation>> InFlightOperations;
+
+		/**
+		 * @brief Set when the next write was also requested without a handle, so it can't be dropped even if every
+		 * handle waiting on it is cancelled
+		 */
+		bool bUntrackedRequest = false;
+
+		/**
+		 * @brief When the first save folded into the next write, and into the write in flight, was requested. In platform
+		 * seconds, or 0 if nothing is waiting
+		 */
+		double FirstRequestTime = 0.0;
+		double InFlightRequestTime = 0.0;
+	};
+
+	/**
+	 * @brief Starts the scheduled write for a Slot, or queues a follow-up if one is already in flight
+	 */
+	void DispatchScheduledSave(FString SlotName);
+
+	/**
+	 * @brief Cuts the debounce window of a Slot short and dispatches its write now
+	 */
+	void FlushScheduledSave(const FString& SlotName);
+
+	/**
+	 * @brief Waits for the writes in flight, then synchronously writes every Slot that still has a save scheduled
+	 */
+	void WriteScheduledSavesSync();
+
+	TMap<FString, FSlotSaveSchedule> SaveSchedules;
+
+	/**
+	 * @brief Set once the Subsystem has started shutting down, so finished writes no longer start their follow-ups
+	 */
+	bool bShuttingDown = false;
+
+	/**
+	 * @brief The operations on a single Slot, in the order they will run
+	 */
+	struct FSlotOperationQueue
+	{
+		TArray<TFunction<bool()>> Pending;
+		bool bRunning = false;
+	};
+
+	/**
+	 * @brief Starts queued operations on a Slot until one of them is left running, or the queue is empty
+	 */
+	void RunNextSlotOperation(const FString& SlotName);
+
+	TMap<FString, FSlotOperationQueue> SlotOperationQueues;
+
+	TArray<TWeakPtr<FSaveOperation>> TrackedOperations;
+
+	bool bAutosaveRunning = false;
+
+	/**
+	 * @brief Set once the autosave that is due has been counted as deferred
+	 */
+	bool bAutosaveDeferred = false;
+
+	/**
+	 * @brief The game time that has passed while autosave was running. Only moves forward while the game isn't paused
+	 */
+	double AutosaveClockSeconds = 0.0;
+
+	/**
+	 * @brief When the next autosave is due, on AutosaveClockSeconds
+	 */
+	double NextAutosaveTime = 0.0;
+
+	/**
+	 * @brief The Game Thread time of recent frames, smoothed so a single spike or quiet frame doesn't decide on its own
+	 */
+	float SmoothedGameThreadMs = 0.f;
+
+	/**
+	 * @brief How many times each blocker has been added and not yet removed
+	 */
+	TMap<FName, int32> AutosaveBlockers;
+
+	FAutosaveStats AutosaveStats;
+
+	TMap<FString, ESaveCompressionCodec> SlotCompressionCodecs;
+
+	/**
+	 * @brief The hash of the payload last written to a Slot, and the backend it was written to
+	 */
+	struct FPersistedPayload
+	{
+		uint64 Hash = 0;
+		TWeakPtr<ISaveStorageBackend> Storage;
+	};
+
+	TMap<FString, FPersistedPayload> PersistedPayloads;
+
+	FSaveSchedulerStats SaveSchedulerStats;
+
 	/**
 	 * @brief The Class to use for the Save Game Object
 	 */
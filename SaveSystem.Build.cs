@@ -17,8 +17,25 @@ public class SaveSystem : ModuleRules
             new string[]
             {
                 "CoreUObject",
-                "Engine"
+                "Engine",
+                "Json"
             }
         );
+
+        // The most detailed verbosity compiled into the high frequency Save System log categories. Test and Shipping builds
+        // strip everything below Warning, so the per Actor and per Slot logging costs nothing there
+        bool bStripDetailLogs = Target.Configuration == UnrealTargetConfiguration.Test || Target.Configuration == UnrealTargetConfiguration.Shipping;
+        string DetailLogVerbosity = bStripDetailLogs ? "Warning" : "All";
+        PublicDefinitions.Add("SAVESYSTEM_LEVEL_LOG_VERBOSITY=" + DetailLogVerbosity);
+        PublicDefinitions.Add("SAVESYSTEM_SLOTS_LOG_VERBOSITY=" + DetailLogVerbosity);
+        PublicDefinitions.Add("SAVESYSTEM_PIPELINE_LOG_VERBOSITY=" + DetailLogVerbosity);
+
+        // Builds the SQLite Slot store (FSQLiteSaveStorage). Needs the SQLiteCore plugin to be enabled in the project
+        bool bWithSQLite = false;
+        PublicDefinitions.Add("WITH_SAVESYSTEM_SQLITE=" + (bWithSQLite ? "1" : "0"));
+        if (bWithSQLite)
+        {
+            PrivateDependencyModuleNames.Add("SQLiteCore");
+        }
     }
 }
\ No newline at end of file